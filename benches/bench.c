@@ -0,0 +1,63 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "object/list.h"
+#include "object/repr.h"
+#include "vm/eval.h"
+
+double bench_seconds_since(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start.tv_sec) + (double) (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+uint64_t bench_now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+void bench_fail(char const *what) {
+    fprintf(stderr, "%s\n", what);
+    exit(EXIT_FAILURE);
+}
+
+void bench_fail_errno(char const *what) {
+    perror(what);
+    exit(EXIT_FAILURE);
+}
+
+void bench_eval_source(VirtualMachine *vm, char const *source) {
+    auto const handle = fmemopen((void *) source, strlen(source), "rb");
+    if (nullptr == handle) {
+        bench_fail("could not open source");
+    }
+
+    auto const file = (NamedFile) {.name = "<bench>", .handle = handle};
+    if (false == object_reader_try_read_all(&vm->reader, file, &vm->exprs)) {
+        object_repr(vm->error, stderr);
+        bench_fail("");
+    }
+    fclose(handle);
+
+    object_list_for(it, vm->exprs) {
+        if (false == try_eval(vm, vm->globals, it)) {
+            object_repr(vm->error, stderr);
+            bench_fail("");
+        }
+    }
+}
+
+size_t bench_parse_count(char const *value, char const *name) {
+    char *end;
+    auto const count = strtoul(value, &end, 10);
+    if ('\0' != *end || 0 == count) {
+        fprintf(stderr, "%s must be a positive number\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    return count;
+}
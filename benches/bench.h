@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "vm/virtual_machine.h"
+
+// Helpers shared by the benchmarks that evaluate Persimmon code.
+
+double bench_seconds_since(struct timespec start);
+
+// Reads the monotonic clock.
+uint64_t bench_now_ns();
+
+// Prints `what` and exits.
+[[noreturn]]
+void bench_fail(char const *what);
+
+// Prints `what` with the error in `errno` and exits.
+[[noreturn]]
+void bench_fail_errno(char const *what);
+
+// Reads and evaluates `source` in `vm`; prints the error and exits on failure.
+void bench_eval_source(VirtualMachine *vm, char const *source);
+
+// Parses command line argument `name`, exiting unless it is a positive number.
+size_t bench_parse_count(char const *value, char const *name);
@@ -0,0 +1,84 @@
+// Measures channel throughput between two VMs: a `future` sends MESSAGES values into a
+// channel while the main VM receives them, first small integers, then lists of 128 integers
+// (1 KB of payload each).
+//
+// Usage: persimmon-channels-bench [MESSAGES [CAPACITY]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "vm/virtual_machine.h"
+
+#define DEFAULT_MESSAGES 100000
+#define DEFAULT_CAPACITY 1024
+
+static char const SETUP[] =
+        "(defn produce (ch x n)"
+        "  (if (eq? 0 n)"
+        "    nil"
+        "    (do (send ch x) (produce ch x (- n 1)))))"
+        "(defn consume (ch n)"
+        "  (if (eq? 0 n)"
+        "    nil"
+        "    (do (recv ch) (consume ch (- n 1)))))"
+        "(defn run (capacity x n)"
+        "  (define ch (chan capacity))"
+        "  (define producer (future produce ch x n))"
+        "  (consume ch n)"
+        "  (deref producer))"
+        "(define small 42)"
+        "(define large (range 128))";
+
+static void run(VirtualMachine *vm, char const *name, char const *payload, size_t messages, size_t capacity) {
+    char source[128];
+    snprintf(source, sizeof(source), "(run %zu %s %zu)", capacity, payload, messages);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bench_eval_source(vm, source);
+    auto const elapsed = bench_seconds_since(start);
+
+    printf(
+            "%-12s %zu messages in %.3f s: %.0f messages/s\n",
+            name, messages, elapsed, (double) messages / elapsed
+    );
+}
+
+int main(int argc, char **argv) {
+    if (argc > 3) {
+        fprintf(stderr, "Usage: %s [MESSAGES [CAPACITY]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto const messages = argc > 1 ? bench_parse_count(argv[1], "MESSAGES") : DEFAULT_MESSAGES;
+    auto const capacity = argc > 2 ? bench_parse_count(argv[2], "CAPACITY") : DEFAULT_CAPACITY;
+
+    VirtualMachine vm;
+    auto const config = (VirtualMachine_Config) {
+            .allocator_config = {
+                    .hard_limit = 64 * 1024 * 1024,
+                    .soft_limit_initial = 64 * 1024,
+                    .soft_limit_grow_factor = 1.25,
+                    .debug = {.gc_mode = ALLOCATOR_SOFT_GC}
+            },
+            .reader_config = {
+                    .scanner_config = {.max_token_length = 2 * 1024},
+                    .parser_config = {.max_nesting_depth = 50}
+            },
+            .stack_config = {.size_bytes = 64 * 1024},
+            .workers = 1
+    };
+    if (false == vm_try_init(&vm, config)) {
+        bench_fail("could not initialize VM");
+    }
+
+    bench_eval_source(&vm, SETUP);
+    run(&vm, "int:", "small", messages, capacity);
+    run(&vm, "1 KB list:", "large", messages, capacity);
+
+    vm_free(&vm);
+    return EXIT_SUCCESS;
+}
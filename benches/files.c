@@ -0,0 +1,153 @@
+// Reads FILES small files (10000 by default) of SIZE bytes (512 by default) three ways: with
+// blocking `fread` calls from C, with `read-file` called from a single task, one file after
+// another, and with `read-file` called from a task per file.
+//
+// Usage: persimmon-files-bench [FILES [SIZE]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "object/list.h"
+#include "vm/virtual_machine.h"
+
+#define DEFAULT_FILES 10000
+#define DEFAULT_SIZE 512
+
+static char const SETUP[] =
+        "(defn read-serially (paths)"
+        "  (map read-file paths))"
+        "(defn read-concurrently (paths)"
+        "  (map join (map (fn (p) (spawn read-file p)) paths)))";
+
+static void file_path(char *path, size_t size, char const *dir, size_t i) {
+    snprintf(path, size, "%s/%zu", dir, i);
+}
+
+static void create_files(char const *dir, size_t count, size_t size) {
+    auto const contents = (char *) malloc(size);
+    if (nullptr == contents) {
+        bench_fail("malloc");
+    }
+    memset(contents, 'x', size);
+
+    char path[256];
+    for (size_t i = 1; i <= count; i++) {
+        file_path(path, sizeof(path), dir, i);
+        auto const file = fopen(path, "wb");
+        if (nullptr == file || size != fwrite(contents, 1, size, file) || 0 != fclose(file)) {
+            bench_fail("could not create the files");
+        }
+    }
+
+    free(contents);
+}
+
+static void remove_files(char const *dir, size_t count) {
+    char path[256];
+    for (size_t i = 1; i <= count; i++) {
+        file_path(path, sizeof(path), dir, i);
+        unlink(path);
+    }
+    rmdir(dir);
+}
+
+static double read_blocking(char const *dir, size_t count, size_t size) {
+    auto const buffer = (char *) malloc(size + 1);
+    if (nullptr == buffer) {
+        bench_fail("malloc");
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    char path[256];
+    for (size_t i = 1; i <= count; i++) {
+        file_path(path, sizeof(path), dir, i);
+        auto const file = fopen(path, "rb");
+        if (nullptr == file || size != fread(buffer, 1, size + 1, file)) {
+            bench_fail("could not read the files");
+        }
+        fclose(file);
+    }
+
+    free(buffer);
+    return bench_seconds_since(start);
+}
+
+static double read_with(VirtualMachine *vm, char const *fn, size_t count) {
+    char source[64];
+    snprintf(source, sizeof(source), "(%s paths)", fn);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bench_eval_source(vm, source);
+    auto const elapsed = bench_seconds_since(start);
+
+    if (count != object_list_count(vm->value)) {
+        bench_fail("could not read the files");
+    }
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 3) {
+        fprintf(stderr, "Usage: %s [FILES [SIZE]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto const count = argc > 1 ? bench_parse_count(argv[1], "FILES") : DEFAULT_FILES;
+    auto const size = argc > 2 ? bench_parse_count(argv[2], "SIZE") : DEFAULT_SIZE;
+
+    char dir[] = "/tmp/persimmon-files-bench-XXXXXX";
+    if (nullptr == mkdtemp(dir)) {
+        bench_fail("could not create a directory");
+    }
+    create_files(dir, count, size);
+
+    VirtualMachine vm;
+    auto const config = (VirtualMachine_Config) {
+            .allocator_config = {
+                    .hard_limit = 512 * 1024 * 1024,
+                    .soft_limit_initial = 64 * 1024,
+                    .soft_limit_grow_factor = 1.25,
+                    .debug = {.gc_mode = ALLOCATOR_SOFT_GC}
+            },
+            .reader_config = {
+                    .scanner_config = {.max_token_length = 2 * 1024},
+                    .parser_config = {.max_nesting_depth = 50}
+            },
+            .stack_config = {.size_bytes = 64 * 1024},
+            .tasks_config = {.stack_config = {.size_bytes = 4 * 1024}},
+    };
+    if (false == vm_try_init(&vm, config)) {
+        bench_fail("could not initialize VM");
+    }
+
+    char define_paths[128];
+    snprintf(
+            define_paths, sizeof(define_paths),
+            "(define paths (map (fn (i) (str \"%s/\" i)) (range %zu)))",
+            dir, count
+    );
+    bench_eval_source(&vm, define_paths);
+    bench_eval_source(&vm, SETUP);
+
+    // Starts the pool of threads, so that no run pays for it.
+    read_with(&vm, "read-serially", count);
+
+    auto const blocking = read_blocking(dir, count, size);
+    auto const serial = read_with(&vm, "read-serially", count);
+    auto const concurrent = read_with(&vm, "read-concurrently", count);
+
+    printf("blocking fread:         %zu files in %.3f s\n", count, blocking);
+    printf("read-file, one task:    %zu files in %.3f s\n", count, serial);
+    printf("read-file, task each:   %zu files in %.3f s\n", count, concurrent);
+
+    vm_free(&vm);
+    remove_files(dir, count);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+// Measures the memory needed to give WORKERS VMs a lookup dict of ENTRIES entries, first by
+// transferring a copy to each of them, then by freezing the dict once and transferring
+// references to it.
+//
+// Usage: persimmon-frozen-bench [WORKERS [ENTRIES]]
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "object/compare.h"
+#include "object/frozen.h"
+#include "object/transfer.h"
+#include "vm/virtual_machine.h"
+
+#define DEFAULT_WORKERS 16
+#define DEFAULT_ENTRIES 20000
+
+static VirtualMachine_Config const CONFIG = {
+        .allocator_config = {
+                .hard_limit = 256 * 1024 * 1024,
+                .soft_limit_initial = 64 * 1024,
+                .soft_limit_grow_factor = 1.25,
+                .debug = {.gc_mode = ALLOCATOR_SOFT_GC}
+        },
+        .reader_config = {
+                .scanner_config = {.max_token_length = 2 * 1024},
+                .parser_config = {.max_nesting_depth = 50}
+        },
+        .stack_config = {.size_bytes = 64 * 1024},
+};
+
+static size_t heap_in_use(void) {
+    return mallinfo2().uordblks;
+}
+
+// Moves `table` into the `value` of every worker and returns the memory this took.
+static size_t share(Object *table, VirtualMachine *workers, size_t count, double *elapsed) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    auto const before = heap_in_use();
+
+    auto message = (Transfer_Message) {0};
+    Transfer_Ref ref;
+    errno_t error_code;
+    if (false == transfer_try_pack(&message, table, &ref, &error_code)) {
+        bench_fail("could not pack the table");
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        Transfer_Unpacker u;
+        auto const ok = transfer_unpacker_try_init(&u, &message, &error_code)
+                        && transfer_try_unpack(&u, &workers[i].allocator, ref, &workers[i].value, &error_code);
+        transfer_unpacker_free(&u);
+        if (false == ok || false == object_equals(table, workers[i].value)) {
+            bench_fail("could not unpack the table");
+        }
+    }
+
+    transfer_message_free(&message);
+
+    *elapsed = bench_seconds_since(start);
+    return heap_in_use() - before;
+}
+
+static void init_workers(VirtualMachine *workers, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (false == vm_try_init(&workers[i], CONFIG)) {
+            bench_fail("could not initialize VM");
+        }
+    }
+}
+
+static void free_workers(VirtualMachine *workers, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        vm_free(&workers[i]);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 3) {
+        fprintf(stderr, "Usage: %s [WORKERS [ENTRIES]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto const count = argc > 1 ? bench_parse_count(argv[1], "WORKERS") : DEFAULT_WORKERS;
+    auto const entries = argc > 2 ? bench_parse_count(argv[2], "ENTRIES") : DEFAULT_ENTRIES;
+
+    auto const workers = (VirtualMachine *) calloc(count, sizeof(VirtualMachine));
+    if (nullptr == workers) {
+        bench_fail("calloc");
+    }
+
+    VirtualMachine vm;
+    if (false == vm_try_init(&vm, CONFIG)) {
+        bench_fail("could not initialize VM");
+    }
+
+    char source[256];
+    snprintf(
+            source, sizeof(source),
+            "(reduce (fn (d k) (put k (str \"value-\" k) d)) nil (range %zu))",
+            entries
+    );
+    bench_eval_source(&vm, source);
+
+    double elapsed;
+    init_workers(workers, count);
+    auto const copied = share(vm.value, workers, count, &elapsed);
+    printf("copied: %8zu KB in %zu workers, %.3f s\n", copied / 1024, count, elapsed);
+    free_workers(workers, count);
+
+    init_workers(workers, count);
+    auto const before = heap_in_use();
+    Object *table;
+    errno_t error_code;
+    if (false == frozen_try_freeze(vm.value, &table, &error_code)) {
+        bench_fail("could not freeze the table");
+    }
+    auto const region = heap_in_use() - before;
+    auto const referenced = share(table, workers, count, &elapsed);
+    printf(
+            "frozen: %8zu KB in the region, %zu KB in %zu workers, %.3f s\n",
+            region / 1024, referenced / 1024, count, elapsed
+    );
+    free_workers(workers, count);
+
+    vm_free(&vm);
+    free(workers);
+
+    return EXIT_SUCCESS;
+}
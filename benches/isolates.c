@@ -0,0 +1,187 @@
+// Stress test for running isolated VMs concurrently: every thread runs all sources in its
+// own VMs, round after round, and checks that each run prints exactly what a run on the
+// main thread printed.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "object/list.h"
+#include "object/repr.h"
+#include "vm/eval.h"
+#include "vm/virtual_machine.h"
+
+#define DEFAULT_ROUNDS 10
+
+typedef struct {
+    char *data;
+    size_t size;
+} Output;
+
+typedef struct {
+    char **paths;
+    Output *expected;
+    size_t count;
+    size_t rounds;
+} Scripts;
+
+typedef struct {
+    pthread_t thread;
+    size_t id;
+    Scripts const *scripts;
+    size_t runs;
+    size_t mismatches;
+} Worker;
+
+static void eval_file(VirtualMachine *vm, NamedFile file) {
+    if (false == object_reader_try_read_all(&vm->reader, file, &vm->exprs)) {
+        object_repr(vm->error, vm->output);
+        return;
+    }
+
+    object_list_for(it, vm->exprs) {
+        if (false == try_eval(vm, vm->globals, it)) {
+            object_repr(vm->error, vm->output);
+            return;
+        }
+    }
+}
+
+// Runs `path` in a fresh VM and returns everything it printed.
+static Output run_script(char const *path) {
+    auto output = (Output) {0};
+    auto const out = open_memstream(&output.data, &output.size);
+    if (nullptr == out) {
+        bench_fail_errno("open_memstream");
+    }
+
+    VirtualMachine vm;
+    auto const config = (VirtualMachine_Config) {
+            .allocator_config = {
+                    .hard_limit = 64 * 1024 * 1024,
+                    .soft_limit_initial = 64 * 1024,
+                    .soft_limit_grow_factor = 1.25,
+                    .debug = {.gc_mode = ALLOCATOR_SOFT_GC}
+            },
+            .reader_config = {
+                    .scanner_config = {.max_token_length = 2 * 1024},
+                    .parser_config = {.max_nesting_depth = 50}
+            },
+            .stack_config = {.size_bytes = 64 * 1024},
+            .output = out
+    };
+    if (false == vm_try_init(&vm, config)) {
+        fprintf(stderr, "could not initialize VM\n");
+        exit(EXIT_FAILURE);
+    }
+
+    NamedFile file;
+    if (false == named_file_try_open(path, "rb", &file)) {
+        bench_fail_errno(path);
+    }
+
+    eval_file(&vm, file);
+
+    named_file_close(&file);
+    vm_free(&vm);
+    fclose(out);
+
+    return output;
+}
+
+static void *run_worker(void *arg) {
+    auto const worker = (Worker *) arg;
+    auto const scripts = worker->scripts;
+
+    for (size_t round = 0; round < scripts->rounds; round++) {
+        for (size_t i = 0; i < scripts->count; i++) {
+            // Threads start at different scripts, so different scripts run at the same time.
+            auto const index = (i + worker->id) % scripts->count;
+            auto const output = run_script(scripts->paths[index]);
+            auto const expected = scripts->expected[index];
+
+            worker->runs++;
+            if (output.size != expected.size || 0 != memcmp(output.data, expected.data, output.size)) {
+                worker->mismatches++;
+            }
+
+            free(output.data);
+        }
+    }
+
+    return nullptr;
+}
+
+int main(int argc, char **argv) {
+    auto const cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads = cpus > 0 ? (size_t) cpus : 1;
+    size_t rounds = DEFAULT_ROUNDS;
+
+    int first_source = 1;
+    while (first_source + 1 < argc) {
+        if (0 == strcmp("--threads", argv[first_source])) {
+            threads = bench_parse_count(argv[first_source + 1], "--threads");
+        } else if (0 == strcmp("--rounds", argv[first_source])) {
+            rounds = bench_parse_count(argv[first_source + 1], "--rounds");
+        } else {
+            break;
+        }
+
+        first_source += 2;
+    }
+
+    if (first_source >= argc) {
+        fprintf(stderr, "Usage: %s [--threads N] [--rounds N] SOURCE...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto scripts = (Scripts) {
+            .paths = argv + first_source,
+            .count = (size_t) (argc - first_source),
+            .rounds = rounds
+    };
+    scripts.expected = calloc(scripts.count, sizeof(Output));
+    auto const workers = (Worker *) calloc(threads, sizeof(Worker));
+    if (nullptr == scripts.expected || nullptr == workers) {
+        bench_fail_errno("calloc");
+    }
+
+    for (size_t i = 0; i < scripts.count; i++) {
+        scripts.expected[i] = run_script(scripts.paths[i]);
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (size_t i = 0; i < threads; i++) {
+        workers[i] = (Worker) {.id = i, .scripts = &scripts};
+        if (0 != pthread_create(&workers[i].thread, nullptr, run_worker, &workers[i])) {
+            bench_fail_errno("pthread_create");
+        }
+    }
+
+    size_t runs = 0, mismatches = 0;
+    for (size_t i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, nullptr);
+        runs += workers[i].runs;
+        mismatches += workers[i].mismatches;
+    }
+
+    auto const elapsed = bench_seconds_since(start);
+    printf(
+            "%zu threads ran %zu scripts in %.3f s: %.1f scripts/s, %zu mismatched outputs\n",
+            threads, runs, elapsed, (double) runs / elapsed, mismatches
+    );
+
+    for (size_t i = 0; i < scripts.count; i++) {
+        free(scripts.expected[i].data);
+    }
+    free(scripts.expected);
+    free(workers);
+
+    return 0 == mismatches ? EXIT_SUCCESS : EXIT_FAILURE;
+}
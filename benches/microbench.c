@@ -0,0 +1,410 @@
+// Measures the primitives the runtime is built from, one at a time: each benchmark is run in
+// batches calibrated to take at least 10 ms, and SAMPLES batches (15 by default) are timed. The
+// median, minimum, maximum, mean and standard deviation of the time per operation are written
+// as JSON, one benchmark per line in a fixed order, to standard output or FILE. NAMEs select
+// benchmarks.
+//
+// Usage: persimmon-microbench [--samples SAMPLES] [--output FILE] [NAME...]
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "utility/arena.h"
+#include "utility/string_builder.h"
+#include "object/compare.h"
+#include "object/constructors.h"
+#include "object/dict.h"
+#include "object/list.h"
+#include "vm/reader/scanner.h"
+#include "vm/virtual_machine.h"
+#include "utility/guards.h"
+
+#define DEFAULT_SAMPLES     15
+#define MIN_SAMPLE_NS       (10 * 1000 * 1000)
+#define DICT_KEYS           10000
+#define LIVE_OBJECTS        10000
+#define LIST_LENGTH         100
+#define ARENA_ALLOCATIONS   4096
+#define NURSERY_SIZE        (256 * 1024)
+
+typedef struct {
+    char const *name;
+    // What one operation is.
+    char const *op;
+    void (*run)(size_t iterations);
+} Microbench;
+
+static VirtualMachine_Config const CONFIG = {
+        .allocator_config = {
+                .hard_limit = 64 * 1024 * 1024,
+                .soft_limit_initial = 64 * 1024,
+                .soft_limit_grow_factor = 1.25,
+                .debug = {.gc_mode = ALLOCATOR_SOFT_GC}
+        },
+        .reader_config = {
+                .scanner_config = {.max_token_length = 2 * 1024},
+                .parser_config = {.max_nesting_depth = 50}
+        },
+        .stack_config = {.size_bytes = 64 * 1024},
+};
+
+static char const SOURCE[] =
+        "; Recursive helpers used by the benchmark input\n"
+        "(defn fold-left (f acc xs)\n"
+        "  (if xs\n"
+        "    (fold-left f (f acc (first xs)) (rest xs))\n"
+        "    acc))\n"
+        "(define some-list '(1 -2 +3 456789 1234567890 \"string\" \"with \\\"escapes\\\"\\n\"))\n"
+        "(print (str \"sum: \" (fold-left + 0 '(1 2 3 4 5 6 7 8 9 10)))) ; trailing comment\n";
+
+// Objects are kept alive in the roots of the VMs: `value` holds what the benchmarks read,
+// `error` the objects they make.
+static VirtualMachine VM;
+static VirtualMachine GC_VM;
+static VirtualMachine NURSERY_VM;
+static Object *DICT;
+static Object *KEYS[DICT_KEYS];
+static Object *LIST_A;
+static Object *LIST_B;
+static Scanner SCANNER;
+
+static void run_allocate(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        if (false == object_try_make_int(&VM.allocator, (int64_t) i, &VM.error)) {
+            bench_fail("allocate: out of memory");
+        }
+    }
+}
+
+// As `allocate`, in the nursery, with a safe point after every allocation as between steps.
+static void run_nursery_allocate(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        if (false == object_try_make_int(&NURSERY_VM.allocator, (int64_t) i, &NURSERY_VM.error)) {
+            bench_fail("nursery-allocate: out of memory");
+        }
+        allocator_safepoint(&NURSERY_VM.allocator);
+    }
+}
+
+// The VM collects at every allocation, with `LIVE_OBJECTS` objects to mark.
+static void run_gc_cycle(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        if (false == object_try_make_int(&GC_VM.allocator, (int64_t) i, &GC_VM.error)) {
+            bench_fail("gc-cycle: out of memory");
+        }
+    }
+}
+
+static void run_dict_put(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        auto const key = KEYS[(i * 7919) % DICT_KEYS];
+        if (false == object_dict_try_put(&VM.allocator, DICT, key, key, &VM.error)) {
+            bench_fail("dict-put: out of memory");
+        }
+    }
+}
+
+static void run_dict_get(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        Object *value;
+        if (false == object_dict_try_get(DICT, KEYS[(i * 7919) % DICT_KEYS], &value)) {
+            bench_fail("dict-get: key not found");
+        }
+    }
+}
+
+static void run_compare(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        if (OBJECT_EQUALS != object_compare(LIST_A, LIST_B)) {
+            bench_fail("compare: lists differ");
+        }
+    }
+}
+
+// One operation is one character; batches carry on where the previous one stopped.
+static void run_scanner_accept(size_t iterations) {
+    static size_t offset = 0;
+    static Position pos = {.lineno = 1};
+    for (size_t i = 0; i < iterations; i++) {
+        if ('\0' == SOURCE[offset]) {
+            offset = 0;
+        }
+
+        auto const c = (unsigned char) SOURCE[offset++];
+        pos = '\n' == c
+              ? (Position) {.lineno = pos.lineno + 1}
+              : (Position) {.lineno = pos.lineno, .col = pos.col + 1};
+
+        SyntaxError error;
+        if (false == scanner_try_accept(&SCANNER, pos, c, &error)) {
+            bench_fail("scanner-accept: syntax error");
+        }
+    }
+}
+
+// The arena is freed every `ARENA_ALLOCATIONS` allocations, which is part of their cost.
+static void run_arena_allocate(size_t iterations) {
+    auto arena = (Arena) {0};
+    for (size_t i = 0; i < iterations; i++) {
+        if (0 == (i + 1) % ARENA_ALLOCATIONS) {
+            arena_free(&arena);
+        }
+
+        void *p;
+        errno_t error_code;
+        if (false == arena_try_allocate(&arena, 8, 32, &p, &error_code)) {
+            bench_fail("arena-allocate: out of memory");
+        }
+    }
+    arena_free(&arena);
+}
+
+static void run_sb_printf(size_t iterations) {
+    auto sb = (StringBuilder) {0};
+    for (size_t i = 0; i < iterations; i++) {
+        sb_clear(&sb);
+
+        errno_t error_code;
+        if (false == sb_try_printf(&sb, &error_code, "%s-%zu: %d", "key", i, 42)) {
+            bench_fail("sb-printf: out of memory");
+        }
+    }
+    sb_free(&sb);
+}
+
+static Microbench const MICROBENCHES[] = {
+        {"allocate",       "object_try_make_int",                run_allocate},
+        {"nursery-allocate", "object_try_make_int, 256K nursery", run_nursery_allocate},
+        {"gc-cycle",       "collection of 10000 live integers",  run_gc_cycle},
+        {"dict-put",       "object_dict_try_put, 10000 keys",    run_dict_put},
+        {"dict-get",       "object_dict_try_get, 10000 keys",    run_dict_get},
+        {"compare",        "object_compare, 100-integer lists",  run_compare},
+        {"scanner-accept", "scanner_try_accept, one character",  run_scanner_accept},
+        {"arena-allocate", "arena_try_allocate, 32 bytes",       run_arena_allocate},
+        {"sb-printf",      "sb_try_printf",                      run_sb_printf},
+};
+
+#define MICROBENCHES_COUNT (sizeof(MICROBENCHES) / sizeof(MICROBENCHES[0]))
+
+// Makes a list of the integers from 0 to `count` in `vm->exprs`.
+static void make_ints(VirtualMachine *vm, size_t count) {
+    vm->exprs = OBJECT_NIL;
+    for (size_t i = count; i > 0; i--) {
+        auto const ok = object_try_make_int(&vm->allocator, (int64_t) i - 1, &vm->error)
+                        && object_list_try_prepend(&vm->allocator, vm->error, &vm->exprs);
+        if (false == ok) {
+            bench_fail("out of memory");
+        }
+    }
+}
+
+// Moves `vm->exprs` into `vm->value` and returns it.
+static Object *keep(VirtualMachine *vm) {
+    if (false == object_list_try_prepend(&vm->allocator, vm->exprs, &vm->value)) {
+        bench_fail("out of memory");
+    }
+    vm->exprs = OBJECT_NIL;
+
+    return vm->value->as_list.first;
+}
+
+static void init_fixtures() {
+    if (false == vm_try_init(&VM, CONFIG)) {
+        bench_fail("could not initialize VM");
+    }
+    VM.value = OBJECT_NIL;
+
+    make_ints(&VM, DICT_KEYS);
+    auto const keys = keep(&VM);
+    size_t i = 0;
+    object_list_for(key, keys) {
+        KEYS[i++] = key;
+    }
+
+    for (i = 0; i < DICT_KEYS; i++) {
+        auto const key = KEYS[(i * 7919) % DICT_KEYS];
+        if (false == object_dict_try_put(&VM.allocator, VM.exprs, key, key, &VM.exprs)) {
+            bench_fail("out of memory");
+        }
+    }
+    DICT = keep(&VM);
+
+    make_ints(&VM, LIST_LENGTH);
+    LIST_A = keep(&VM);
+    make_ints(&VM, LIST_LENGTH);
+    LIST_B = keep(&VM);
+
+    auto gc_config = CONFIG;
+    gc_config.allocator_config.debug.gc_mode = ALLOCATOR_ALWAYS_GC;
+    if (false == vm_try_init(&GC_VM, gc_config)) {
+        bench_fail("could not initialize VM");
+    }
+    GC_VM.value = OBJECT_NIL;
+    make_ints(&GC_VM, LIVE_OBJECTS);
+    keep(&GC_VM);
+
+    auto nursery_config = CONFIG;
+    nursery_config.allocator_config.nursery_size = NURSERY_SIZE;
+    if (false == vm_try_init(&NURSERY_VM, nursery_config)) {
+        bench_fail("could not initialize VM");
+    }
+    allocator_open_nursery(&NURSERY_VM.allocator);
+
+    errno_t error_code;
+    if (false == scanner_try_init(&SCANNER, CONFIG.reader_config.scanner_config, &error_code)) {
+        bench_fail("could not initialize the scanner");
+    }
+}
+
+static void free_fixtures() {
+    scanner_free(&SCANNER);
+    vm_free(&NURSERY_VM);
+    vm_free(&GC_VM);
+    vm_free(&VM);
+}
+
+static int compare_doubles(void const *a, void const *b) {
+    auto const x = *(double const *) a;
+    auto const y = *(double const *) b;
+    return (x > y) - (x < y);
+}
+
+// Doubles the batch until it takes `MIN_SAMPLE_NS`; the batches run serve as warmup.
+static size_t calibrate(Microbench const *bench) {
+    size_t iterations = 1;
+    while (true) {
+        auto const start = bench_now_ns();
+        bench->run(iterations);
+        if (bench_now_ns() - start >= MIN_SAMPLE_NS) {
+            return iterations;
+        }
+
+        iterations *= 2;
+    }
+}
+
+static void measure(Microbench const *bench, size_t samples, FILE *output, bool is_last) {
+    auto const iterations = calibrate(bench);
+
+    auto const ns_per_op = (double *) calloc(samples, sizeof(double));
+    if (nullptr == ns_per_op) {
+        bench_fail("calloc");
+    }
+
+    for (size_t i = 0; i < samples; i++) {
+        auto const start = bench_now_ns();
+        bench->run(iterations);
+        ns_per_op[i] = (double) (bench_now_ns() - start) / (double) iterations;
+    }
+    qsort(ns_per_op, samples, sizeof(double), compare_doubles);
+
+    double mean = 0;
+    for (size_t i = 0; i < samples; i++) {
+        mean += ns_per_op[i] / (double) samples;
+    }
+    double variance = 0;
+    for (size_t i = 0; i < samples; i++) {
+        variance += (ns_per_op[i] - mean) * (ns_per_op[i] - mean) / (double) samples;
+    }
+
+    fprintf(
+            output,
+            "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"max_ns_per_op\": %.3f, "
+            "\"mean_ns_per_op\": %.3f, \"stddev_ns_per_op\": %.3f, \"iterations\": %zu, \"op\": \"%s\"}%s\n",
+            bench->name, ns_per_op[samples / 2], ns_per_op[0], ns_per_op[samples - 1],
+            mean, sqrt(variance), iterations, bench->op, is_last ? "" : ","
+    );
+    fflush(output);
+
+    free(ns_per_op);
+}
+
+static bool is_selected(Microbench const *bench, int argc, char **argv) {
+    if (0 == argc) {
+        return true;
+    }
+
+    for (int i = 0; i < argc; i++) {
+        if (0 == strcmp(bench->name, argv[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+[[noreturn]]
+static void usage(char const *program) {
+    fprintf(stderr, "Usage: %s [--samples SAMPLES] [--output FILE] [NAME...]\n", program);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    auto const program = argv[0];
+    argc--;
+    argv++;
+
+    size_t samples = DEFAULT_SAMPLES;
+    auto output = stdout;
+    while (argc > 0 && 0 == strncmp("--", argv[0], 2)) {
+        if (argc < 2) {
+            usage(program);
+        }
+
+        if (0 == strcmp("--samples", argv[0])) {
+            char *end;
+            samples = strtoul(argv[1], &end, 10);
+            if ('\0' != *end || 0 == samples) {
+                bench_fail("SAMPLES must be a positive number");
+            }
+        } else if (0 == strcmp("--output", argv[0])) {
+            output = fopen(argv[1], "wb");
+            if (nullptr == output) {
+                perror(argv[1]);
+                return EXIT_FAILURE;
+            }
+        } else {
+            usage(program);
+        }
+
+        argc -= 2;
+        argv += 2;
+    }
+
+    size_t remaining = 0;
+    for (size_t i = 0; i < MICROBENCHES_COUNT; i++) {
+        remaining += is_selected(&MICROBENCHES[i], argc, argv) ? 1 : 0;
+    }
+    if (remaining < (size_t) argc) {
+        fprintf(stderr, "unknown benchmark among:");
+        for (int i = 0; i < argc; i++) {
+            fprintf(stderr, " %s", argv[i]);
+        }
+        fprintf(stderr, "\n");
+        return EXIT_FAILURE;
+    }
+
+    init_fixtures();
+
+    fprintf(output, "{\n  \"guards\": \"%s\",\n  \"samples\": %zu,\n  \"benchmarks\": [\n", GUARD_LEVEL_NAME, samples);
+    for (size_t i = 0; i < MICROBENCHES_COUNT; i++) {
+        if (is_selected(&MICROBENCHES[i], argc, argv)) {
+            measure(&MICROBENCHES[i], samples, output, 0 == --remaining);
+        }
+    }
+    fprintf(output, "  ]\n}\n");
+
+    free_fixtures();
+
+    if (0 != fclose(output)) {
+        perror("could not write the results");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
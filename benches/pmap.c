@@ -0,0 +1,101 @@
+// Compares `map` with `pmap` on a CPU-bound function: every call computes a Fibonacci number
+// the slow way. Each run uses a fresh VM, so that `pmap` runs pay for starting their pool.
+//
+// Usage: persimmon-pmap-bench [CALLS [N]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "utility/string_builder.h"
+#include "object/repr.h"
+#include "vm/virtual_machine.h"
+
+#define DEFAULT_CALLS 64
+#define DEFAULT_N 16
+
+static size_t const THREADS[] = {1, 2, 4, 8};
+
+static char const SETUP[] =
+        "(defn fib (n)"
+        "  (if (eq? -1 (compare n 2))"
+        "    n"
+        "    (+ (fib (- n 1)) (fib (- n 2)))))"
+        "(defn repeat (x n)"
+        "  (map (fn (_) x) (range n)))";
+
+// Evaluates `(MAPPER fib (repeat N CALLS))` and returns its repr in `result`.
+static double run(char const *mapper, size_t threads, size_t calls, size_t n, StringBuilder *result) {
+    VirtualMachine vm;
+    auto const config = (VirtualMachine_Config) {
+            .allocator_config = {
+                    .hard_limit = 64 * 1024 * 1024,
+                    .soft_limit_initial = 64 * 1024,
+                    .soft_limit_grow_factor = 1.25,
+                    .debug = {.gc_mode = ALLOCATOR_SOFT_GC}
+            },
+            .reader_config = {
+                    .scanner_config = {.max_token_length = 2 * 1024},
+                    .parser_config = {.max_nesting_depth = 50}
+            },
+            .stack_config = {.size_bytes = 64 * 1024},
+            .workers = threads
+    };
+    if (false == vm_try_init(&vm, config)) {
+        bench_fail("could not initialize VM");
+    }
+
+    bench_eval_source(&vm, SETUP);
+
+    char source[128];
+    snprintf(source, sizeof(source), "(%s fib (repeat %zu %zu))", mapper, n, calls);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bench_eval_source(&vm, source);
+    auto const elapsed = bench_seconds_since(start);
+
+    errno_t error_code;
+    sb_clear(result);
+    if (false == object_try_repr(vm.value, result, &error_code)) {
+        bench_fail("could not repr the result");
+    }
+
+    vm_free(&vm);
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 3) {
+        fprintf(stderr, "Usage: %s [CALLS [N]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto const calls = argc > 1 ? bench_parse_count(argv[1], "CALLS") : DEFAULT_CALLS;
+    auto const n = argc > 2 ? bench_parse_count(argv[2], "N") : DEFAULT_N;
+
+    auto expected = (StringBuilder) {0};
+    auto got = (StringBuilder) {0};
+
+    auto const baseline = run("map", 1, calls, n, &expected);
+    printf("map:            %8.3f s\n", baseline);
+
+    auto mismatches = 0;
+    for (size_t i = 0; i < sizeof(THREADS) / sizeof(THREADS[0]); i++) {
+        auto const elapsed = run("pmap", THREADS[i], calls, n, &got);
+        auto const matches = expected.length == got.length && 0 == memcmp(expected.str, got.str, got.length);
+        mismatches += false == matches;
+
+        printf(
+                "pmap, %zu threads: %8.3f s, %5.2fx%s\n",
+                THREADS[i], elapsed, baseline / elapsed, matches ? "" : " (wrong result)"
+        );
+    }
+
+    sb_free(&got);
+    sb_free(&expected);
+
+    return 0 == mismatches ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "utility/guards.h"
+#include "utility/arena.h"
+#include "utility/exchange.h"
+#include "vm/reader/line_reader.h"
+#include "vm/reader/scanner.h"
+#include "vm/reader/source.h"
+#include "vm/reader/tokenizer.h"
+
+#define SOURCE_SIZE_BYTES   (50 * 1024 * 1024)
+#define LINES_PER_ARENA     4096
+
+static char const SOURCE_CHUNK[] =
+        "; Recursive helpers used by the benchmark input\n"
+        "(defn fold-left (f acc xs)\n"
+        "\t(if xs\n"
+        "\t\t(fold-left f (f acc (first xs)) (rest xs))\n"
+        "\t\tacc))\n"
+        "\n"
+        "(define some-list '(1 -2 +3 456789 1234567890 \"string\" \"with \\\"escapes\\\"\\n\"))\n"
+        "(define some-dict (dict 'key-one \"value one\", 'key-two 22, 'key-three some-list.first))\n"
+        "(print (str \"sum: \" (fold-left + 0 '(1 2 3 4 5 6 7 8 9 10)))) ; trailing comment\n";
+
+static double seconds_since(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start.tv_sec) + (double) (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+[[noreturn]]
+static void fail(SyntaxError error) {
+    fprintf(stderr, "%s at %zu:%zu\n", syntax_error_str(error.code), error.pos.lineno, error.pos.col + 1);
+    exit(EXIT_FAILURE);
+}
+
+static FILE *generate_source(size_t *size) {
+    auto const file = tmpfile();
+    if (nullptr == file) {
+        perror("tmpfile");
+        exit(EXIT_FAILURE);
+    }
+
+    auto const chunk_size = strlen(SOURCE_CHUNK);
+    *size = 0;
+    while (*size < SOURCE_SIZE_BYTES) {
+        if (chunk_size != fwrite(SOURCE_CHUNK, 1, chunk_size, file)) {
+            perror("fwrite");
+            exit(EXIT_FAILURE);
+        }
+        *size += chunk_size;
+    }
+
+    return file;
+}
+
+static FILE *open_source(char const *path, size_t *size) {
+    auto const file = fopen(path, "r");
+    if (nullptr == file) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+
+    fseek(file, 0, SEEK_END);
+    *size = (size_t) ftell(file);
+    return file;
+}
+
+static size_t tokenize_lines(FILE *file, Scanner *s) {
+    auto lines_arena = (Arena) {0};
+    auto line_reader = line_reader_make(file);
+    size_t tokens = 0;
+
+    while (true) {
+        Line line;
+        errno_t error_code;
+        if (false == line_reader_try_read(&line_reader, &lines_arena, &line, &error_code)) {
+            fprintf(stderr, "could not read source: %s\n", strerror(error_code));
+            exit(EXIT_FAILURE);
+        }
+
+        if (nullptr == line.data) {
+            break;
+        }
+
+        auto pos = (Position) {.lineno = line.lineno};
+        for (size_t i = 0; i < line.count; i++) {
+            auto const char_pos = exchange(pos, ((Position) {
+                    .lineno = pos.lineno,
+                    .col = pos.col + 1,
+                    .end_col = pos.end_col + 1
+            }));
+
+            SyntaxError error;
+            if (false == scanner_try_accept(s, char_pos, line.data[i], &error)) {
+                fail(error);
+            }
+
+            tokens += s->has_token;
+        }
+
+        if (0 == line.lineno % LINES_PER_ARENA) {
+            arena_free(&lines_arena);
+        }
+    }
+
+    arena_free(&lines_arena);
+    line_reader_free(&line_reader);
+
+    return tokens;
+}
+
+static size_t tokenize_source(FILE *file, Scanner *s) {
+    Source source;
+    errno_t error_code;
+    if (false == source_try_load(file, &source, &error_code)) {
+        fprintf(stderr, "could not load source: %s\n", strerror(error_code));
+        exit(EXIT_FAILURE);
+    }
+
+    auto tokenizer = tokenizer_make(source.data, source.size);
+    size_t tokens = 0;
+
+    while (true) {
+        SyntaxError error;
+        if (false == tokenizer_try_next(&tokenizer, s, &error)) {
+            fail(error);
+        }
+
+        if (false == s->has_token) {
+            break;
+        }
+
+        tokens++;
+    }
+
+    source_free(&source);
+
+    return tokens;
+}
+
+static void run(char const *name, FILE *file, size_t size, size_t (*tokenize)(FILE *, Scanner *)) {
+    Scanner s;
+    errno_t error_code;
+    if (false == scanner_try_init(&s, (Scanner_Config) {.max_token_length = 2048}, &error_code)) {
+        fprintf(stderr, "could not initialize scanner: %s\n", strerror(error_code));
+        exit(EXIT_FAILURE);
+    }
+
+    rewind(file);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    auto const tokens = tokenize(file, &s);
+
+    auto const elapsed = seconds_since(start);
+    auto const megabytes = (double) size / (1024.0 * 1024.0);
+    printf(
+            "%-12s tokenized %.1f MB (%zu tokens) in %.3f s: %.1f MB/s\n",
+            name, megabytes, tokens, elapsed, megabytes / elapsed
+    );
+
+    scanner_free(&s);
+}
+
+int main(int argc, char **argv) {
+    size_t size;
+    auto const file = argc > 1 ? open_source(argv[1], &size) : generate_source(&size);
+
+    run("line reader", file, size, tokenize_lines);
+    run("source", file, size, tokenize_source);
+
+    fclose(file);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,16 @@
+; Errors thrown and caught, from the top of the stack and from 50 calls deep.
+
+(defn dive (n)
+  (if (eq? 0 n)
+    (throw 'bottom)
+    (+ 1 (dive (- n 1)))))
+
+(defn repeat (n)
+  (if (eq? 0 n)
+    nil
+    (do
+      (catch (throw 'top))
+      (catch (dive 50))
+      (repeat (- n 1)))))
+
+(repeat 5000)
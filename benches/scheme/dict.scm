@@ -0,0 +1,12 @@
+; Persistent dict insertion and lookup with 10^5 integer keys.
+
+(define keys (range 100000))
+
+(define table (reduce (fn (d k) (put k (* k k) d)) nil keys))
+
+(defn sum-values (sum keys)
+  (if keys
+    (sum-values (+ sum (get (first keys) table)) (rest keys))
+    sum))
+
+(sum-values 0 keys)
@@ -0,0 +1,11 @@
+; Function calls and integer arithmetic.
+
+(defn < (a b)
+  (eq? -1 (compare a b)))
+
+(defn fib (n)
+  (if (< n 2)
+    n
+    (+ (fib (- n 1)) (fib (- n 2)))))
+
+(fib 22)
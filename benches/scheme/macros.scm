@@ -0,0 +1,18 @@
+; Deep macro expansion: every call expands a macro 100 levels deep.
+
+(defmacro nest (n)
+  (if (eq? 0 n)
+    0
+    (list '+ 1 (list 'nest (- n 1)))))
+
+(defn deep ()
+  (nest 100))
+
+(defn repeat (n)
+  (if (eq? 0 n)
+    nil
+    (do
+      (deep)
+      (repeat (- n 1)))))
+
+(repeat 200)
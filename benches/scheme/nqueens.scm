@@ -0,0 +1,26 @@
+; Backtracking over lists: counts the placements of 7 queens on a 7x7 board.
+
+(defn < (a b)
+  (eq? -1 (compare a b)))
+
+(defn safe? (row distance placed)
+  (if placed
+    (if (or (eq? row (first placed))
+            (eq? row (+ (first placed) distance))
+            (eq? row (- (first placed) distance)))
+      nil
+      (safe? row (+ distance 1) (rest placed)))
+    'true))
+
+(defn solutions-from (n row placed count)
+  (if (< n row)
+    0
+    (+ (if (safe? row 1 placed) (solutions n (prepend row placed) (+ count 1)) 0)
+       (solutions-from n (+ row 1) placed count))))
+
+(defn solutions (n placed count)
+  (if (eq? n count)
+    1
+    (solutions-from n 1 placed count)))
+
+(solutions 7 nil 0)
@@ -0,0 +1,5 @@
+; String building: many short strings, then one long string built piece by piece.
+
+(define words (map (fn (i) (str "word-" i)) (range 20000)))
+
+(define text (reduce (fn (acc i) (str acc i ",")) "" (range 2000)))
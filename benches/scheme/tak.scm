@@ -0,0 +1,11 @@
+; Deeply nested calls with three arguments.
+
+(defn < (a b)
+  (eq? -1 (compare a b)))
+
+(defn tak (x y z)
+  (if (< y x)
+    (tak (tak (- x 1) y z) (tak (- y 1) z x) (tak (- z 1) x y))
+    z))
+
+(tak 18 12 6)
@@ -0,0 +1,191 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "server/client.h"
+#include "vm/reader/source.h"
+
+#define DEFAULT_REQUESTS    200
+#define DEFAULT_CLIENTS     1
+#define CONNECT_ATTEMPTS    500
+
+typedef struct {
+    char const *persimmon;
+    char const *source_path;
+    Source source;
+    char const *socket_path;
+} Bench;
+
+// Runs a fresh interpreter process on the source, the way a script is run without a server.
+static bool spawn_fresh(Bench const *bench) {
+    auto const child = fork();
+    if (child < 0) {
+        bench_fail_errno("fork");
+    }
+
+    if (0 == child) {
+        auto const null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd < 0 || dup2(null_fd, STDOUT_FILENO) < 0) {
+            _exit(EXIT_FAILURE);
+        }
+
+        execl(bench->persimmon, bench->persimmon, bench->source_path, (char *) nullptr);
+        _exit(EXIT_FAILURE);
+    }
+
+    int status;
+    return child == waitpid(child, &status, 0) && WIFEXITED(status) && EXIT_SUCCESS == WEXITSTATUS(status);
+}
+
+static bool request_server(Bench const *bench) {
+    int fd;
+    errno_t error_code;
+    return client_try_connect(bench->socket_path, &fd, &error_code)
+           && client_try_eval(fd, bench->source.data, bench->source.size, nullptr, &error_code);
+}
+
+static int compare_u64(void const *a, void const *b) {
+    auto const lhs = *(uint64_t const *) a;
+    auto const rhs = *(uint64_t const *) b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+static double percentile_ms(uint64_t const *sorted, size_t count, double p) {
+    auto const index = (size_t) (p * (double) (count - 1));
+    return (double) sorted[index] / 1e6;
+}
+
+static void run(char const *name, Bench const *bench, size_t requests, size_t clients,
+                bool (*request)(Bench const *)) {
+    // Shared with client processes, which record the latency of every request they make.
+    auto const latencies = (uint64_t *) mmap(
+            nullptr, requests * sizeof(uint64_t),
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0
+    );
+    if (MAP_FAILED == latencies) {
+        bench_fail_errno("mmap");
+    }
+
+    fflush(stdout);
+    auto const start = bench_now_ns();
+    for (size_t client = 0; client < clients; client++) {
+        auto const child = fork();
+        if (child < 0) {
+            bench_fail_errno("fork");
+        }
+
+        if (0 == child) {
+            for (auto i = client; i < requests; i += clients) {
+                auto const request_start = bench_now_ns();
+                if (false == request(bench)) {
+                    _exit(EXIT_FAILURE);
+                }
+                latencies[i] = bench_now_ns() - request_start;
+            }
+            _exit(EXIT_SUCCESS);
+        }
+    }
+
+    auto ok = true;
+    for (size_t client = 0; client < clients; client++) {
+        int status;
+        ok = -1 != wait(&status) && WIFEXITED(status) && EXIT_SUCCESS == WEXITSTATUS(status) && ok;
+    }
+    auto const elapsed = (double) (bench_now_ns() - start) / 1e9;
+
+    if (false == ok) {
+        fprintf(stderr, "%s: some requests failed\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    qsort(latencies, requests, sizeof(uint64_t), compare_u64);
+    printf(
+            "%-8s %zu requests, %zu clients in %.3f s: %.1f requests/s, "
+            "latency p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+            name, requests, clients, elapsed, (double) requests / elapsed,
+            percentile_ms(latencies, requests, 0.5),
+            percentile_ms(latencies, requests, 0.99),
+            percentile_ms(latencies, requests, 1.0)
+    );
+
+    munmap(latencies, requests * sizeof(uint64_t));
+}
+
+static pid_t start_server(Bench const *bench) {
+    auto const child = fork();
+    if (child < 0) {
+        bench_fail_errno("fork");
+    }
+
+    if (0 == child) {
+        execl(bench->persimmon, bench->persimmon, "--serve", bench->socket_path, (char *) nullptr);
+        _exit(EXIT_FAILURE);
+    }
+
+    for (size_t attempt = 0; attempt < CONNECT_ATTEMPTS; attempt++) {
+        int fd;
+        errno_t error_code;
+        if (client_try_connect(bench->socket_path, &fd, &error_code)) {
+            close(fd);
+            return child;
+        }
+
+        usleep(10 * 1000);
+    }
+
+    fprintf(stderr, "server did not start on \"%s\"\n", bench->socket_path);
+    kill(child, SIGTERM);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3 || argc > 5) {
+        fprintf(stderr, "Usage: %s PERSIMMON SOURCE [REQUESTS [CLIENTS]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto const requests = argc > 3 ? bench_parse_count(argv[3], "REQUESTS") : DEFAULT_REQUESTS;
+    auto const clients = argc > 4 ? bench_parse_count(argv[4], "CLIENTS") : DEFAULT_CLIENTS;
+
+    auto const file = fopen(argv[2], "rb");
+    if (nullptr == file) {
+        bench_fail_errno(argv[2]);
+    }
+
+    auto bench = (Bench) {.persimmon = argv[1], .source_path = argv[2]};
+    errno_t error_code;
+    if (false == source_try_load(file, &bench.source, &error_code)) {
+        fprintf(stderr, "could not load source: %s\n", strerror(error_code));
+        return EXIT_FAILURE;
+    }
+    fclose(file);
+
+    char socket_dir[] = "/tmp/persimmon-bench-XXXXXX";
+    if (nullptr == mkdtemp(socket_dir)) {
+        bench_fail_errno("mkdtemp");
+    }
+
+    char socket_path[sizeof(socket_dir) + 16];
+    snprintf(socket_path, sizeof(socket_path), "%s/socket", socket_dir);
+    bench.socket_path = socket_path;
+
+    run("spawn", &bench, requests, clients, spawn_fresh);
+
+    auto const server = start_server(&bench);
+    run("server", &bench, requests, clients, request_server);
+
+    kill(server, SIGTERM);
+    waitpid(server, nullptr, 0);
+    rmdir(socket_dir);
+    source_free(&bench.source);
+
+    return EXIT_SUCCESS;
+}
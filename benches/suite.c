@@ -0,0 +1,516 @@
+// Runs the Persimmon workloads of benches/scheme (and demos/main.scm) in a fresh VM each time:
+// WARMUP runs are discarded, then RUNS runs are timed, from reading the source to the end of its
+// evaluation; the largest heap of any run is reported with the times. Results are written as
+// JSON, one benchmark per line, to standard output or FILE. What the workloads print is
+// discarded. Paths are relative to the repository root, which the runner must be started from.
+//
+// The heap settings of the VMs can be changed with the `PERSIMMON_HEAP_*` environment variables
+// of the interpreter (see object/heap_config.h), to compare heap policies.
+//
+// Compare mode reads two result files and flags the benchmarks whose median time or peak heap
+// grew by more than PERCENT (5 by default); it fails if any did, if a benchmark of the baseline
+// is missing from the results, or if either file holds no results.
+//
+// Usage: persimmon-bench [--warmup WARMUP] [--runs RUNS] [--output FILE] [NAME...]
+//        persimmon-bench --compare BASELINE RESULTS [--threshold PERCENT]
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "object/heap_config.h"
+#include "object/list.h"
+#include "object/repr.h"
+#include "vm/eval.h"
+#include "vm/virtual_machine.h"
+#include "utility/guards.h"
+
+#define DEFAULT_WARMUP      2
+#define DEFAULT_RUNS        10
+#define DEFAULT_THRESHOLD   5.0
+#define MAX_NAME_LENGTH     63
+#define MAX_GUARDS_LENGTH   15
+
+typedef struct {
+    char const *name;
+    char const *path;
+} Benchmark;
+
+static Benchmark const BENCHMARKS[] = {
+        {"fib",      "benches/scheme/fib.scm"},
+        {"tak",      "benches/scheme/tak.scm"},
+        {"nqueens",  "benches/scheme/nqueens.scm"},
+        {"dict",     "benches/scheme/dict.scm"},
+        {"strings",  "benches/scheme/strings.scm"},
+        {"pipeline", "demos/main.scm"},
+        {"macros",   "benches/scheme/macros.scm"},
+        {"catch",    "benches/scheme/catch.scm"},
+};
+
+#define BENCHMARKS_COUNT (sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]))
+
+static VirtualMachine_Config config = {
+        .allocator_config = {
+                .hard_limit = 1024 * 1024 * 1024,
+                .soft_limit_initial = 64 * 1024,
+                .soft_limit_grow_factor = 1.25,
+                .debug = {.gc_mode = ALLOCATOR_SOFT_GC}
+        },
+        .reader_config = {
+                .scanner_config = {.max_token_length = 2 * 1024},
+                .parser_config = {.max_nesting_depth = 50}
+        },
+        .stack_config = {.size_bytes = 1024 * 1024},
+};
+
+typedef struct {
+    char name[MAX_NAME_LENGTH + 1];
+    uint64_t median_ns;
+    size_t peak_heap_bytes;
+} Result;
+
+[[noreturn]]
+static void fail_with_error(Benchmark const *benchmark, Object *error) {
+    fprintf(stderr, "%s: ", benchmark->name);
+    object_repr(error, stderr);
+    fprintf(stderr, "\n");
+    exit(EXIT_FAILURE);
+}
+
+static int compare_u64(void const *a, void const *b) {
+    auto const x = *(uint64_t const *) a;
+    auto const y = *(uint64_t const *) b;
+    return (x > y) - (x < y);
+}
+
+// Returns the time the run took and the largest heap it grew.
+static uint64_t run(Benchmark const *benchmark, size_t *peak_heap_bytes) {
+    VirtualMachine vm;
+    if (false == vm_try_init(&vm, config)) {
+        fprintf(stderr, "%s: could not initialize VM\n", benchmark->name);
+        exit(EXIT_FAILURE);
+    }
+
+    auto const start = bench_now_ns();
+
+    NamedFile file;
+    if (false == named_file_try_open(benchmark->path, "rb", &file)) {
+        bench_fail_errno(benchmark->path);
+    }
+    if (false == object_reader_try_read_all(&vm.reader, file, &vm.exprs)) {
+        fail_with_error(benchmark, vm.error);
+    }
+    named_file_close(&file);
+
+    object_list_for(it, vm.exprs) {
+        if (false == try_eval(&vm, vm.globals, it)) {
+            fail_with_error(benchmark, vm.error);
+        }
+    }
+
+    auto const elapsed = bench_now_ns() - start;
+    *peak_heap_bytes = allocator_statistics(&vm.allocator).heap_bytes_max;
+    vm_free(&vm);
+
+    return elapsed;
+}
+
+static void write_result(
+        FILE *output,
+        Benchmark const *benchmark,
+        uint64_t *runs_ns,
+        size_t runs,
+        size_t peak_heap_bytes,
+        bool is_last
+) {
+    qsort(runs_ns, runs, sizeof(uint64_t), compare_u64);
+
+    double mean = 0;
+    for (size_t i = 0; i < runs; i++) {
+        mean += (double) runs_ns[i] / (double) runs;
+    }
+    double variance = 0;
+    for (size_t i = 0; i < runs; i++) {
+        variance += ((double) runs_ns[i] - mean) * ((double) runs_ns[i] - mean) / (double) runs;
+    }
+
+    // `read_results` reads the name, the median and the peak heap back.
+    fprintf(
+            output,
+            "    {\"name\": \"%s\", \"median_ns\": %" PRIu64 ", \"peak_heap_bytes\": %zu, "
+            "\"min_ns\": %" PRIu64 ", \"max_ns\": %" PRIu64 ", \"mean_ns\": %.0f, \"stddev_ns\": %.0f, "
+            "\"runs_ns\": [",
+            benchmark->name, runs_ns[runs / 2], peak_heap_bytes,
+            runs_ns[0], runs_ns[runs - 1], mean, sqrt(variance)
+    );
+    for (size_t i = 0; i < runs; i++) {
+        fprintf(output, "%s%" PRIu64, 0 == i ? "" : ", ", runs_ns[i]);
+    }
+    fprintf(output, "]}%s\n", is_last ? "" : ",");
+}
+
+static bool is_selected(Benchmark const *benchmark, int argc, char **argv) {
+    if (0 == argc) {
+        return true;
+    }
+
+    for (int i = 0; i < argc; i++) {
+        if (0 == strcmp(benchmark->name, argv[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int run_benchmarks(size_t warmup, size_t runs, FILE *output, int argc, char **argv) {
+    for (int i = 0; i < argc; i++) {
+        auto is_known = false;
+        for (size_t j = 0; j < BENCHMARKS_COUNT; j++) {
+            is_known = is_known || 0 == strcmp(BENCHMARKS[j].name, argv[i]);
+        }
+        if (false == is_known) {
+            fprintf(stderr, "unknown benchmark: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto const runs_ns = (uint64_t *) calloc(runs, sizeof(uint64_t));
+    if (nullptr == runs_ns) {
+        bench_fail_errno("calloc");
+    }
+
+    // The workloads print to standard output, which may be where the results go.
+    auto const results_fd = dup(STDOUT_FILENO);
+    auto const null_fd = open("/dev/null", O_WRONLY);
+    if (results_fd < 0 || null_fd < 0) {
+        bench_fail_errno("/dev/null");
+    }
+    auto const is_stdout = stdout == output;
+    if (is_stdout) {
+        output = fdopen(results_fd, "w");
+        if (nullptr == output) {
+            bench_fail_errno("fdopen");
+        }
+    }
+
+    size_t remaining = 0;
+    for (size_t i = 0; i < BENCHMARKS_COUNT; i++) {
+        remaining += is_selected(&BENCHMARKS[i], argc, argv) ? 1 : 0;
+    }
+
+    fprintf(
+            output,
+            "{\n  \"guards\": \"%s\",\n  \"warmup\": %zu,\n  \"runs\": %zu,\n  \"benchmarks\": [\n",
+            GUARD_LEVEL_NAME, warmup, runs
+    );
+    for (size_t i = 0; i < BENCHMARKS_COUNT; i++) {
+        auto const benchmark = &BENCHMARKS[i];
+        if (false == is_selected(benchmark, argc, argv)) {
+            continue;
+        }
+
+        fprintf(stderr, "%s...\n", benchmark->name);
+        fflush(stdout);
+        dup2(null_fd, STDOUT_FILENO);
+
+        size_t peak_heap_bytes = 0;
+        for (size_t j = 0; j < warmup + runs; j++) {
+            size_t run_peak_heap_bytes;
+            auto const elapsed = run(benchmark, &run_peak_heap_bytes);
+            if (j >= warmup) {
+                runs_ns[j - warmup] = elapsed;
+                peak_heap_bytes = run_peak_heap_bytes > peak_heap_bytes ? run_peak_heap_bytes : peak_heap_bytes;
+            }
+        }
+
+        fflush(stdout);
+        dup2(results_fd, STDOUT_FILENO);
+        write_result(output, benchmark, runs_ns, runs, peak_heap_bytes, 0 == --remaining);
+    }
+    fprintf(output, "  ]\n}\n");
+
+    free(runs_ns);
+    close(null_fd);
+    if (false == is_stdout) {
+        close(results_fd);
+    }
+    if (0 != fclose(output)) {
+        bench_fail_errno("could not write the results");
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static char *read_file(char const *path) {
+    auto const file = fopen(path, "rb");
+    if (nullptr == file) {
+        bench_fail_errno(path);
+    }
+
+    size_t length = 0, capacity = 4096;
+    auto text = (char *) malloc(capacity);
+    while (nullptr != text) {
+        length += fread(text + length, 1, capacity - length - 1, file);
+        if (length < capacity - 1) {
+            break;
+        }
+        capacity *= 2;
+        text = (char *) realloc(text, capacity);
+    }
+    if (nullptr == text) {
+        bench_fail_errno("realloc");
+    }
+    if (ferror(file)) {
+        bench_fail_errno(path);
+    }
+    fclose(file);
+
+    text[length] = '\0';
+    return text;
+}
+
+// Finds `"field":` between `it` and `end`, whatever the spaces, and returns what follows it.
+static char const *find_field(char const *it, char const *end, char const *field) {
+    auto const length = strlen(field);
+    for (; nullptr != (it = strstr(it, field)) && it < end; it += length) {
+        auto value = it + length;
+        value += strspn(value, " \t\r\n");
+        if (':' == *value) {
+            value++;
+            return value + strspn(value, " \t\r\n");
+        }
+    }
+
+    return nullptr;
+}
+
+static bool try_read_string(char const *value, char *string, size_t max_length) {
+    if (nullptr == value || '"' != *value) {
+        return false;
+    }
+
+    auto const length = strcspn(value + 1, "\"");
+    if ('"' != value[1 + length] || length > max_length) {
+        return false;
+    }
+    memcpy(string, value + 1, length);
+    string[length] = '\0';
+    return true;
+}
+
+static bool try_read_number(char const *value, uint64_t *number) {
+    if (nullptr == value) {
+        return false;
+    }
+
+    char *end;
+    *number = strtoull(value, &end, 10);
+    return end != value;
+}
+
+// Reads back the results written by `write_result`, and the guards they were built with;
+// returns their count. Only the JSON matters, not how it is laid out.
+static size_t read_results(char const *path, Result **results, char guards[MAX_GUARDS_LENGTH + 1]) {
+    auto const text = read_file(path);
+    auto const text_end = text + strlen(text);
+
+    if (false == try_read_string(find_field(text, text_end, "\"guards\""), guards, MAX_GUARDS_LENGTH)) {
+        strcpy(guards, "?");
+    }
+
+    size_t count = 0, capacity = 0;
+    *results = nullptr;
+    // Each result is the object from its name to the next closing brace.
+    auto const name_field = "\"name\"";
+    auto next = find_field(text, text_end, name_field);
+    while (nullptr != next) {
+        auto const it = next;
+        auto const brace = strchr(it, '}');
+        auto const end = nullptr == brace ? text_end : brace;
+        next = find_field(end, text_end, name_field);
+
+        Result result;
+        uint64_t peak_heap_bytes;
+        auto const ok =
+                try_read_string(it, result.name, MAX_NAME_LENGTH)
+                && try_read_number(find_field(it, end, "\"median_ns\""), &result.median_ns)
+                && try_read_number(find_field(it, end, "\"peak_heap_bytes\""), &peak_heap_bytes);
+        if (false == ok) {
+            continue;
+        }
+        result.peak_heap_bytes = (size_t) peak_heap_bytes;
+
+        if (count == capacity) {
+            capacity = 0 == capacity ? BENCHMARKS_COUNT : capacity * 2;
+            *results = (Result *) realloc(*results, capacity * sizeof(Result));
+            if (nullptr == *results) {
+                bench_fail_errno("realloc");
+            }
+        }
+        (*results)[count++] = result;
+    }
+    free(text);
+
+    if (0 == count) {
+        fprintf(stderr, "%s: no results\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    return count;
+}
+
+static Result const *find_result(Result const *results, size_t count, char const *name) {
+    for (size_t i = 0; i < count; i++) {
+        if (0 == strcmp(results[i].name, name)) {
+            return &results[i];
+        }
+    }
+
+    return nullptr;
+}
+
+static double change(double baseline, double value) {
+    return 0 == baseline ? 0 : 100.0 * (value - baseline) / baseline;
+}
+
+static int compare_results(char const *baseline_path, char const *results_path, double threshold) {
+    Result *baseline, *results;
+    char baseline_guards[MAX_GUARDS_LENGTH + 1], results_guards[MAX_GUARDS_LENGTH + 1];
+    auto const baseline_count = read_results(baseline_path, &baseline, baseline_guards);
+    auto const results_count = read_results(results_path, &results, results_guards);
+
+    auto regressions = 0;
+    printf("guards: %s in the baseline, %s in the results\n", baseline_guards, results_guards);
+    printf(
+            "%-10s %12s %12s %8s %14s %14s %8s\n",
+            "benchmark", "baseline ms", "ms", "change", "baseline heap", "heap", "change"
+    );
+    for (size_t i = 0; i < results_count; i++) {
+        auto const result = &results[i];
+        auto const base = find_result(baseline, baseline_count, result->name);
+        if (nullptr == base) {
+            printf("%-10s (not in the baseline)\n", result->name);
+            continue;
+        }
+
+        auto const time_change = change((double) base->median_ns, (double) result->median_ns);
+        auto const heap_change = change((double) base->peak_heap_bytes, (double) result->peak_heap_bytes);
+        auto const is_regression = time_change > threshold || heap_change > threshold;
+        regressions += is_regression ? 1 : 0;
+        printf(
+                "%-10s %12.2f %12.2f %+7.1f%% %14zu %14zu %+7.1f%%%s\n",
+                result->name,
+                (double) base->median_ns / 1e6, (double) result->median_ns / 1e6, time_change,
+                base->peak_heap_bytes, result->peak_heap_bytes, heap_change,
+                is_regression ? "  REGRESSION" : ""
+        );
+    }
+
+    // A workload that stopped producing results, because it crashed for instance, fails too.
+    auto missing = 0;
+    for (size_t i = 0; i < baseline_count; i++) {
+        if (nullptr == find_result(results, results_count, baseline[i].name)) {
+            printf("%-10s (missing from the results)\n", baseline[i].name);
+            missing++;
+        }
+    }
+
+    free(baseline);
+    free(results);
+
+    if (regressions > 0) {
+        printf("%d regression(s) beyond %.1f%%\n", regressions, threshold);
+    }
+    if (missing > 0) {
+        printf("%d benchmark(s) missing from the results\n", missing);
+    }
+    return regressions > 0 || missing > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static size_t parse_count(char const *value, char const *name, size_t min) {
+    char *end;
+    auto const count = strtoul(value, &end, 10);
+    if ('\0' != *end || count < min) {
+        fprintf(stderr, "%s must be a number, at least %zu\n", name, min);
+        exit(EXIT_FAILURE);
+    }
+
+    return count;
+}
+
+static double parse_percent(char const *value) {
+    char *end;
+    auto const percent = strtod(value, &end);
+    if ('\0' != *end || percent < 0) {
+        fprintf(stderr, "PERCENT must be a non-negative number\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return percent;
+}
+
+[[noreturn]]
+static void usage(char const *program) {
+    fprintf(
+            stderr,
+            "Usage: %s [--warmup WARMUP] [--runs RUNS] [--output FILE] [NAME...]\n"
+            "       %s --compare BASELINE RESULTS [--threshold PERCENT]\n",
+            program, program
+    );
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    auto const program = argv[0];
+    argc--;
+    argv++;
+
+    if (argc > 0 && 0 == strcmp("--compare", argv[0])) {
+        if (3 == argc) {
+            return compare_results(argv[1], argv[2], DEFAULT_THRESHOLD);
+        }
+        if (5 == argc && 0 == strcmp("--threshold", argv[3])) {
+            return compare_results(argv[1], argv[2], parse_percent(argv[4]));
+        }
+        usage(program);
+    }
+
+    size_t warmup = DEFAULT_WARMUP, runs = DEFAULT_RUNS;
+    auto output = stdout;
+    while (argc > 0 && 0 == strncmp("--", argv[0], 2)) {
+        if (argc < 2) {
+            usage(program);
+        }
+
+        if (0 == strcmp("--warmup", argv[0])) {
+            warmup = parse_count(argv[1], "WARMUP", 0);
+        } else if (0 == strcmp("--runs", argv[0])) {
+            runs = parse_count(argv[1], "RUNS", 1);
+        } else if (0 == strcmp("--output", argv[0])) {
+            output = fopen(argv[1], "wb");
+            if (nullptr == output) {
+                bench_fail_errno(argv[1]);
+            }
+        } else {
+            usage(program);
+        }
+
+        argc -= 2;
+        argv += 2;
+    }
+
+    char const *variable;
+    if (false == heap_config_try_read_environment(&config.allocator_config, &variable)) {
+        fprintf(stderr, "invalid value for %s\n", variable);
+        return EXIT_FAILURE;
+    }
+
+    return run_benchmarks(warmup, runs, output, argc, argv);
+}
@@ -0,0 +1,196 @@
+// Measures how long HANDLERS concurrent request handlers take to respond when one VM
+// interleaves them as tasks. Every 100th handler is slow (it computes a larger Fibonacci number);
+// the others are fast. Handlers respond by printing their number into a pipe, and a thread
+// records when each line arrives. Runs once preempting tasks after FUEL steps, and once letting
+// each task run to completion.
+//
+// Usage: persimmon-tasks-bench [HANDLERS [FUEL]]
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "vm/virtual_machine.h"
+
+#define DEFAULT_HANDLERS 1000
+#define DEFAULT_FUEL 1000
+#define SLOW_EVERY 100
+
+static char const SETUP[] =
+        "(defn fib (n)"
+        "  (if (eq? -1 (compare n 2))"
+        "    n"
+        "    (+ (fib (- n 1)) (fib (- n 2)))))"
+        "(defn is-slow (i)"
+        "  (eq? i (* (/ i 100) 100)))"
+        "(defn handle (i)"
+        "  (fib (if (is-slow i) 20 8))"
+        "  (print i))"
+        "(defn serve (count)"
+        "  (map join (map (fn (i) (spawn handle (- i 1))) (range count))))";
+
+typedef struct {
+    int fd;
+    struct timespec start;
+    double *latencies;
+    size_t handlers;
+    size_t count;
+} Responses;
+
+// Reads what `print` writes: a handler's number per line.
+static void *record(void *arg) {
+    Responses *r = arg;
+    char buffer[4096];
+    char line[32];
+    size_t line_length = 0;
+
+    ssize_t size;
+    while ((size = read(r->fd, buffer, sizeof(buffer))) > 0) {
+        auto const now = bench_seconds_since(r->start);
+        for (ssize_t i = 0; i < size; i++) {
+            if ('\n' != buffer[i]) {
+                if (line_length + 1 < sizeof(line)) {
+                    line[line_length++] = buffer[i];
+                }
+                continue;
+            }
+
+            line[line_length] = '\0';
+            line_length = 0;
+            auto const handler = strtoul(line, nullptr, 10);
+            if (handler < r->handlers) {
+                r->latencies[handler] = now;
+                r->count++;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+static int compare_doubles(void const *a, void const *b) {
+    auto const x = *(double const *) a;
+    auto const y = *(double const *) b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(double const *sorted, size_t count, double p) {
+    auto const index = (size_t) (p * (double) (count - 1) + 0.5);
+    return sorted[index];
+}
+
+static void report(char const *name, Responses const *r, size_t handlers) {
+    auto const fast = (double *) calloc(handlers, sizeof(double));
+    if (nullptr == fast) {
+        bench_fail("calloc");
+    }
+
+    size_t fast_count = 0;
+    double slow_max = 0;
+    for (size_t i = 0; i < handlers; i++) {
+        if (0 == i % SLOW_EVERY) {
+            slow_max = r->latencies[i] > slow_max ? r->latencies[i] : slow_max;
+            continue;
+        }
+        fast[fast_count++] = r->latencies[i];
+    }
+    qsort(fast, fast_count, sizeof(double), compare_doubles);
+
+    printf(
+            "%-24s fast p50 %7.2f ms, p99 %7.2f ms, max %7.2f ms; slow max %7.2f ms\n",
+            name,
+            percentile(fast, fast_count, 0.50) * 1e3,
+            percentile(fast, fast_count, 0.99) * 1e3,
+            fast[fast_count - 1] * 1e3,
+            slow_max * 1e3
+    );
+    free(fast);
+}
+
+static void run(char const *name, size_t handlers, size_t fuel) {
+    auto r = (Responses) {.latencies = calloc(handlers, sizeof(double)), .handlers = handlers};
+    if (nullptr == r.latencies) {
+        bench_fail("calloc");
+    }
+
+    int fds[2];
+    if (0 != pipe(fds)) {
+        bench_fail("pipe");
+    }
+    r.fd = fds[0];
+
+    auto const output = fdopen(fds[1], "w");
+    if (nullptr == output) {
+        bench_fail("fdopen");
+    }
+    setvbuf(output, nullptr, _IOLBF, 0);
+
+    VirtualMachine vm;
+    auto const config = (VirtualMachine_Config) {
+            .allocator_config = {
+                    .hard_limit = 256 * 1024 * 1024,
+                    .soft_limit_initial = 64 * 1024,
+                    .soft_limit_grow_factor = 1.25,
+                    .debug = {.gc_mode = ALLOCATOR_SOFT_GC}
+            },
+            .reader_config = {
+                    .scanner_config = {.max_token_length = 2 * 1024},
+                    .parser_config = {.max_nesting_depth = 50}
+            },
+            .stack_config = {.size_bytes = 64 * 1024},
+            .tasks_config = {.fuel = fuel, .stack_config = {.size_bytes = 8 * 1024}},
+            .output = output
+    };
+    if (false == vm_try_init(&vm, config)) {
+        bench_fail("could not initialize VM");
+    }
+
+    bench_eval_source(&vm, SETUP);
+
+    pthread_t reader;
+    clock_gettime(CLOCK_MONOTONIC, &r.start);
+    if (0 != pthread_create(&reader, nullptr, record, &r)) {
+        bench_fail("pthread_create");
+    }
+
+    char source[64];
+    snprintf(source, sizeof(source), "(serve %zu)", handlers);
+    bench_eval_source(&vm, source);
+
+    vm_free(&vm);
+    fclose(output);
+    pthread_join(reader, nullptr);
+    close(r.fd);
+
+    if (handlers != r.count) {
+        bench_fail("some handlers did not respond");
+    }
+    report(name, &r, handlers);
+    free(r.latencies);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 3) {
+        fprintf(stderr, "Usage: %s [HANDLERS [FUEL]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto const handlers = argc > 1 ? bench_parse_count(argv[1], "HANDLERS") : DEFAULT_HANDLERS;
+    auto const fuel = argc > 2 ? bench_parse_count(argv[2], "FUEL") : DEFAULT_FUEL;
+    if (handlers <= SLOW_EVERY) {
+        fprintf(stderr, "HANDLERS must be greater than %d\n", SLOW_EVERY);
+        return EXIT_FAILURE;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "preempted every %zu:", fuel);
+    run(name, handlers, fuel);
+    run("run to completion:", handlers, SIZE_MAX);
+
+    return EXIT_SUCCESS;
+}
@@ -1,6 +1,8 @@
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "utility/guards.h"
+#include "object/heap_config.h"
 #include "object/list.h"
 #include "object/repr.h"
 #include "vm/reader/reader.h"
@@ -8,6 +10,10 @@
 #include "vm/virtual_machine.h"
 #include "vm/traceback.h"
 #include "vm/errors.h"
+#include "vm/image.h"
+#include "vm/profiler.h"
+#include "vm/trace.h"
+#include "server/server.h"
 
 static bool try_shift_args(int *argc, char ***argv, char **arg) {
     if (*argc <= 0) {
@@ -23,6 +29,18 @@ static bool try_shift_args(int *argc, char ***argv, char **arg) {
     return true;
 }
 
+static bool try_shift_option_value(int *argc, char ***argv, char **value) {
+    auto const option = (*argv)[0];
+    try_shift_args(argc, argv, nullptr);
+
+    if (try_shift_args(argc, argv, value)) {
+        return true;
+    }
+
+    printf("ERROR: %s requires a value\n", option);
+    return false;
+}
+
 static void print_any_as_error(Object *error) {
     printf("Error: ");
     object_repr(error, stdout);
@@ -104,35 +122,248 @@ static bool try_eval_file(VirtualMachine *vm, NamedFile file) {
     return true;
 }
 
+static bool try_stream_file(VirtualMachine *vm, NamedFile file) {
+    auto stream = object_reader_stream_make(file);
+
+    while (true) {
+        if (false == object_reader_try_stream(&vm->reader, &stream, &vm->exprs)) {
+            print_error(vm->error);
+            break;
+        }
+
+        if (OBJECT_NIL == vm->exprs) {
+            break;
+        }
+
+        object_list_for(it, vm->exprs) {
+            if (try_eval(vm, vm->globals, it)) {
+                continue;
+            }
+
+            print_error(vm->error);
+            object_reader_stream_free(&stream);
+            return false;
+        }
+    }
+
+    object_reader_stream_free(&stream);
+    return true;
+}
+
+static bool try_parse_workers(char const *value, size_t *workers) {
+    if (nullptr == value) {
+        auto const cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        *workers = cpus > 0 ? (size_t) cpus : 1;
+        return true;
+    }
+
+    char *end;
+    errno = 0;
+    auto const parsed = strtoul(value, &end, 10);
+    if (0 != errno || '\0' != *end || 0 == parsed) {
+        printf("ERROR: --workers requires a positive number\n");
+        return false;
+    }
+
+    *workers = parsed;
+    return true;
+}
+
+static bool try_serve(VirtualMachine *vm, char const *socket_path, char const *workers_value, char const *preload) {
+    size_t workers;
+    if (false == try_parse_workers(workers_value, &workers)) {
+        return false;
+    }
+
+    if (nullptr != preload) {
+        NamedFile file;
+        if (false == named_file_try_open(preload, "rb", &file)) {
+            printf("ERROR: Could not open \"%s\": %s\n", preload, strerror(errno));
+            return false;
+        }
+
+        auto const ok = try_eval_file(vm, file);
+        named_file_close(&file);
+        if (false == ok) {
+            return false;
+        }
+    }
+
+    errno_t error_code;
+    auto const config = (Server_Config) {.socket_path = socket_path, .workers = workers};
+    if (false == server_try_run(vm, config, try_eval_file, &error_code)) {
+        printf("ERROR: Could not serve \"%s\": %s\n", socket_path, strerror(error_code));
+        return false;
+    }
+
+    return true;
+}
+
 int main(int argc, char **argv) {
     try_shift_args(&argc, &argv, nullptr);
 
+    auto stream = false;
+    char *cache_dir = nullptr;
+    char *image_path = nullptr;
+    char *save_image_path = nullptr;
+    char *socket_path = nullptr;
+    char *workers = nullptr;
+    char *profile_path = nullptr;
+    char *allocations_path = nullptr;
+    char *gc_trace_path = nullptr;
+    char *trace_path = nullptr;
+
+    // The environment overrides the defaults, and options override the environment.
+    auto allocator_config = (ObjectAllocator_Config) {
+            .hard_limit = 1024 * 1024 * 1024,
+            .soft_limit_initial = 1024 * 1024,
+            .nursery_size = 1024 * 1024,
+            .policy = ALLOCATOR_POLICY_ADAPTIVE,
+    };
+    char const *variable;
+    if (false == heap_config_try_read_environment(&allocator_config, &variable)) {
+        printf("ERROR: Invalid value for %s\n", variable);
+        return EXIT_FAILURE;
+    }
+
+    while (argc > 0) {
+        if (0 == strcmp("--stream", argv[0])) {
+            try_shift_args(&argc, &argv, nullptr);
+            stream = true;
+            continue;
+        }
+
+        if (0 == strncmp("--heap-", argv[0], strlen("--heap-"))) {
+            auto const option = argv[0];
+            char *setting;
+            if (false == try_shift_option_value(&argc, &argv, &setting)) {
+                return EXIT_FAILURE;
+            }
+            if (false == heap_config_try_set(&allocator_config, option + strlen("--heap-"), setting)) {
+                printf("ERROR: Invalid %s \"%s\"\n", option, setting);
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+
+        char **value = nullptr;
+        if (0 == strcmp("--cache", argv[0])) {
+            value = &cache_dir;
+        } else if (0 == strcmp("--image", argv[0])) {
+            value = &image_path;
+        } else if (0 == strcmp("--save-image", argv[0])) {
+            value = &save_image_path;
+        } else if (0 == strcmp("--serve", argv[0])) {
+            value = &socket_path;
+        } else if (0 == strcmp("--workers", argv[0])) {
+            value = &workers;
+        } else if (0 == strcmp("--profile", argv[0])) {
+            value = &profile_path;
+        } else if (0 == strcmp("--profile-allocations", argv[0])) {
+            value = &allocations_path;
+        } else if (0 == strcmp("--gc-trace", argv[0])) {
+            value = &gc_trace_path;
+        } else if (0 == strcmp("--trace", argv[0])) {
+            value = &trace_path;
+        }
+
+        if (nullptr != value) {
+            if (false == try_shift_option_value(&argc, &argv, value)) {
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+
+        break;
+    }
+
+    Profiler profiler;
+    FILE *profile = nullptr;
+    if (nullptr != profile_path) {
+        profile = fopen(profile_path, "wb");
+        if (nullptr == profile) {
+            printf("ERROR: Could not open \"%s\": %s\n", profile_path, strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    FILE *allocations = nullptr;
+    if (nullptr != allocations_path) {
+        allocations = fopen(allocations_path, "wb");
+        if (nullptr == allocations) {
+            printf("ERROR: Could not open \"%s\": %s\n", allocations_path, strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    FILE *gc_trace = nullptr;
+    if (nullptr != gc_trace_path) {
+        gc_trace = fopen(gc_trace_path, "wb");
+        if (nullptr == gc_trace) {
+            printf("ERROR: Could not open \"%s\": %s\n", gc_trace_path, strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    Trace trace_ring;
+    FILE *trace = nullptr;
+    if (nullptr != trace_path) {
+        trace = fopen(trace_path, "wb");
+        if (nullptr == trace) {
+            printf("ERROR: Could not open \"%s\": %s\n", trace_path, strerror(errno));
+            return EXIT_FAILURE;
+        }
+
+        errno_t trace_error_code;
+        if (false == trace_try_init(&trace_ring, (Trace_Config) {0}, &trace_error_code)) {
+            printf("ERROR: Could not start the trace: %s\n", strerror(trace_error_code));
+            fclose(trace);
+            return EXIT_FAILURE;
+        }
+    }
+
+    allocator_config.profile_sample_bytes = nullptr == allocations ? 0 : 256;
+    allocator_config.trace_events = gc_trace;
+    allocator_config.trace = nullptr == trace ? nullptr : &trace_ring;
+
     VirtualMachine vm;
     auto const config = (VirtualMachine_Config) {
-            .allocator_config = {
-                    .hard_limit = 1024 * 1024,
-                    .soft_limit_initial = 1024,
-                    .soft_limit_grow_factor = 1.25,
-                    .debug = {
-                            .no_free = true,
-                            .trace = false,
-                            .gc_mode = ALLOCATOR_ALWAYS_GC
-                    }
-            },
+            .allocator_config = allocator_config,
             .reader_config = {
                     .scanner_config = {.max_token_length = 2 * 1024},
-                    .parser_config = {.max_nesting_depth = 50}
+                    .parser_config = {.max_nesting_depth = 50},
+                    .cache_dir = cache_dir
             },
-            .stack_config = {.size_bytes = 2048}
+            .stack_config = {.size_bytes = 2048},
+            .profiler = nullptr == profile ? nullptr : &profiler,
+            .trace = nullptr == trace ? nullptr : &trace_ring
     };
     if (false == vm_try_init(&vm, config)) {
         printf("ERROR: Failed to initialize VM\n");
         return EXIT_FAILURE;
     }
 
+    errno_t error_code;
+    if (nullptr != image_path && false == image_try_load(&vm, image_path, &error_code)) {
+        printf("ERROR: Could not load image \"%s\": %s\n", image_path, strerror(error_code));
+        vm_free(&vm);
+        return EXIT_FAILURE;
+    }
+
+    errno_t profile_error_code;
+    if (nullptr != profile && false == profiler_try_start(&profiler, (Profiler_Config) {0}, &profile_error_code)) {
+        printf("ERROR: Could not start the profiler: %s\n", strerror(profile_error_code));
+        vm_free(&vm);
+        fclose(profile);
+        return EXIT_FAILURE;
+    }
+
     char *file_name;
     bool ok = true;
-    if (try_shift_args(&argc, &argv, &file_name)) {
+    if (nullptr != socket_path) {
+        auto const preload = try_shift_args(&argc, &argv, &file_name) ? file_name : nullptr;
+        ok = try_serve(&vm, socket_path, workers, preload);
+    } else if (try_shift_args(&argc, &argv, &file_name)) {
         NamedFile file;
         if (false == named_file_try_open(file_name, "rb", &file)) {
             printf("ERROR: Could not open \"%s\": %s\n", file_name, strerror(errno));
@@ -140,12 +371,66 @@ int main(int argc, char **argv) {
             return EXIT_FAILURE;
         }
 
-        ok = try_eval_file(&vm, file);
+        ok = stream ? try_stream_file(&vm, file) : try_eval_file(&vm, file);
         named_file_close(&file);
+
+        if (ok && nullptr != save_image_path && false == image_try_save(&vm, save_image_path, &error_code)) {
+            printf("ERROR: Could not save image \"%s\": %s\n", save_image_path, strerror(error_code));
+            ok = false;
+        }
     } else {
         run_repl(&vm);
     }
 
+    if (nullptr != allocations) {
+        auto is_written = allocator_try_write_profile(&vm.allocator, allocations, &profile_error_code);
+        if (0 != fclose(allocations) && is_written) {
+            profile_error_code = errno;
+            is_written = false;
+        }
+        if (false == is_written) {
+            printf(
+                    "ERROR: Could not write profile \"%s\": %s\n",
+                    allocations_path, strerror(profile_error_code)
+            );
+            ok = false;
+        }
+    }
+
     vm_free(&vm);
+
+    if (nullptr != gc_trace && 0 != fclose(gc_trace)) {
+        printf("ERROR: Could not write GC trace \"%s\": %s\n", gc_trace_path, strerror(errno));
+        ok = false;
+    }
+
+    if (nullptr != trace) {
+        errno_t trace_error_code;
+        auto is_written = trace_try_dump(&trace_ring, trace, &trace_error_code);
+        if (0 != fclose(trace) && is_written) {
+            trace_error_code = errno;
+            is_written = false;
+        }
+        if (false == is_written) {
+            printf("ERROR: Could not write trace \"%s\": %s\n", trace_path, strerror(trace_error_code));
+            ok = false;
+        }
+        trace_free(&trace_ring);
+    }
+
+    if (nullptr != profile) {
+        profiler_stop(&profiler);
+        auto is_written = profiler_try_write(&profiler, profile, &profile_error_code);
+        if (0 != fclose(profile) && is_written) {
+            profile_error_code = errno;
+            is_written = false;
+        }
+        if (false == is_written) {
+            printf("ERROR: Could not write profile \"%s\": %s\n", profile_path, strerror(profile_error_code));
+            ok = false;
+        }
+        profiler_free(&profiler);
+    }
+
     return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "allocation_profile.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utility/guards.h"
+#include "utility/dynamic_array.h"
+#include "utility/slice.h"
+#include "repr.h"
+
+#define ALLOCATION_PROFILE_MAX_SITES 40
+#define ALLOCATION_PROFILE_MAX_EXPR_LENGTH 60
+
+AllocationProfile allocation_profile_make(size_t sample_bytes) {
+    guard_is_greater(sample_bytes, 0);
+
+    return (AllocationProfile) {.sample_bytes = sample_bytes};
+}
+
+void allocation_profile_free(AllocationProfile *p) {
+    guard_is_not_null(p);
+
+    da_free(&p->sites);
+    da_free(&p->_pending);
+    free(p->_slots);
+    *p = (AllocationProfile) {0};
+}
+
+static size_t slot_index(AllocationProfile const *p, Object *expr) {
+    auto const hash = ((uint64_t) (uintptr_t) expr >> 3) * 0x9e3779b97f4a7c15;
+    return (size_t) (hash >> 32) & (p->_slots_capacity - 1);
+}
+
+static AllocationProfile_Slot *slot_find(AllocationProfile const *p, Object *expr) {
+    auto index = slot_index(p, expr);
+    while (nullptr != p->_slots[index].expr && expr != p->_slots[index].expr) {
+        index = (index + 1) & (p->_slots_capacity - 1);
+    }
+
+    return &p->_slots[index];
+}
+
+static bool slots_try_grow(AllocationProfile *p) {
+    auto const capacity = 0 == p->_slots_capacity ? 64 : p->_slots_capacity * 2;
+    auto const slots = (AllocationProfile_Slot *) calloc(capacity, sizeof(AllocationProfile_Slot));
+    if (nullptr == slots) {
+        return false;
+    }
+
+    auto const old_slots = p->_slots;
+    auto const old_capacity = p->_slots_capacity;
+    p->_slots = slots;
+    p->_slots_capacity = capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (nullptr != old_slots[i].expr) {
+            *slot_find(p, old_slots[i].expr) = old_slots[i];
+        }
+    }
+    free(old_slots);
+
+    return true;
+}
+
+static bool try_find_site(AllocationProfile *p, Object *expr, size_t *site) {
+    if (2 * (p->sites.count + 1) > p->_slots_capacity && false == slots_try_grow(p)) {
+        return false;
+    }
+
+    auto const slot = slot_find(p, expr);
+    if (nullptr == slot->expr) {
+        if (false == da_try_append(&p->sites, ((AllocationProfile_Site) {.expr = expr}))) {
+            return false;
+        }
+        *slot = (AllocationProfile_Slot) {.expr = expr, .index = p->sites.count - 1};
+    }
+
+    *site = slot->index;
+    return true;
+}
+
+void allocation_profile_sample(AllocationProfile *p, Object *expr, Object *obj, size_t weight) {
+    guard_is_not_null(p);
+    guard_is_not_null(expr);
+    guard_is_not_null(obj);
+
+    size_t site;
+    auto const ok =
+            try_find_site(p, expr, &site)
+            && da_try_append(&p->_pending, ((AllocationProfile_Sample) {.obj = obj, .site = site, .weight = weight}));
+    if (false == ok) {
+        p->dropped += weight;
+        return;
+    }
+
+    p->samples += weight;
+}
+
+static void add(AllocationProfile_Stats *stats, double bytes, double objects, bool is_collected, bool has_survived) {
+    stats->bytes += bytes;
+    stats->objects += objects;
+    if (is_collected) {
+        stats->collected += objects;
+    }
+    if (has_survived) {
+        stats->survived += objects;
+    }
+}
+
+static void account(AllocationProfile *p, bool is_collected) {
+    slice_for(it, &p->_pending) {
+        auto const bytes = (double) (it->weight * p->sample_bytes);
+        auto const objects = bytes / (double) it->obj->size;
+        auto const has_survived = is_collected && OBJECT_BLACK == it->obj->color;
+
+        add(&p->by_type[it->obj->type], bytes, objects, is_collected, has_survived);
+        add(&p->sites.data[it->site].stats, bytes, objects, is_collected, has_survived);
+    }
+
+    slice_clear(&p->_pending);
+}
+
+void allocation_profile_collect(AllocationProfile *p) {
+    guard_is_not_null(p);
+
+    account(p, true);
+}
+
+typedef struct {
+    char *text;
+    AllocationProfile_Stats stats;
+} AllocationProfile_Line;
+
+static int compare_texts(void const *a, void const *b) {
+    return strcmp(((AllocationProfile_Line const *) a)->text, ((AllocationProfile_Line const *) b)->text);
+}
+
+static int compare_bytes(void const *a, void const *b) {
+    auto const x = ((AllocationProfile_Line const *) a)->stats.bytes;
+    auto const y = ((AllocationProfile_Line const *) b)->stats.bytes;
+    return (x < y) - (x > y);
+}
+
+static void add_stats(AllocationProfile_Stats *stats, AllocationProfile_Stats const *other) {
+    stats->bytes += other->bytes;
+    stats->objects += other->objects;
+    stats->collected += other->collected;
+    stats->survived += other->survived;
+}
+
+static bool try_make_text(Object *expr, StringBuilder *sb, char **text, errno_t *error_code) {
+    sb_clear(sb);
+    auto const ok =
+            OBJECT_NIL == expr
+            ? sb_try_printf(sb, error_code, "<no frame>")
+            : object_try_repr(expr, sb, error_code);
+    if (false == ok) {
+        return false;
+    }
+
+    if (sb->length > ALLOCATION_PROFILE_MAX_EXPR_LENGTH) {
+        sb->length = ALLOCATION_PROFILE_MAX_EXPR_LENGTH;
+        sb->str[sb->length] = '\0';
+        if (false == sb_try_printf(sb, error_code, "...")) {
+            return false;
+        }
+    }
+
+    errno = 0;
+    *text = strdup(sb->str);
+    if (nullptr == *text) {
+        *error_code = errno;
+        return false;
+    }
+
+    return true;
+}
+
+// Expressions made by macros are made again by every expansion: sites are merged by their text.
+static bool try_make_lines(
+        AllocationProfile const *p,
+        AllocationProfile_Line *lines,
+        size_t *count,
+        errno_t *error_code
+) {
+    auto sb = (StringBuilder) {0};
+    *count = 0;
+    for (size_t i = 0; i < p->sites.count; i++) {
+        lines[i].stats = p->sites.data[i].stats;
+        if (false == try_make_text(p->sites.data[i].expr, &sb, &lines[i].text, error_code)) {
+            sb_free(&sb);
+            *count = i;
+            return false;
+        }
+    }
+    sb_free(&sb);
+
+    qsort(lines, p->sites.count, sizeof(AllocationProfile_Line), compare_texts);
+    for (size_t i = 0; i < p->sites.count; i++) {
+        if (*count > 0 && 0 == strcmp(lines[*count - 1].text, lines[i].text)) {
+            add_stats(&lines[*count - 1].stats, &lines[i].stats);
+            free(lines[i].text);
+            continue;
+        }
+
+        lines[(*count)++] = lines[i];
+    }
+    qsort(lines, *count, sizeof(AllocationProfile_Line), compare_bytes);
+
+    return true;
+}
+
+static void print_stats(AllocationProfile_Stats const *stats, FILE *file) {
+    fprintf(file, "%12.0f %10.0f ", stats->bytes, stats->objects);
+    if (stats->collected > 0) {
+        fprintf(file, "%8.1f%%", 100.0 * stats->survived / stats->collected);
+    } else {
+        fprintf(file, "%9s", "-");
+    }
+}
+
+bool allocation_profile_try_write(AllocationProfile *p, FILE *file, errno_t *error_code) {
+    guard_is_not_null(p);
+    guard_is_not_null(file);
+    guard_is_not_null(error_code);
+
+    // Still in the heap: whether they survive is not known yet.
+    account(p, false);
+
+    errno = 0;
+    auto const lines = (AllocationProfile_Line *) calloc(p->sites.count + 1, sizeof(AllocationProfile_Line));
+    if (nullptr == lines) {
+        *error_code = errno;
+        return false;
+    }
+
+    size_t count;
+    auto const ok = try_make_lines(p, lines, &count, error_code);
+    if (ok) {
+        fprintf(file, "Allocations, sampled every %zu bytes (%zu samples", p->sample_bytes, p->samples);
+        if (p->dropped > 0) {
+            fprintf(file, ", %zu dropped", p->dropped);
+        }
+        fprintf(file, "):\n");
+
+        fprintf(file, "%12s %10s %9s  %s\n", "bytes", "objects", "survived", "type");
+        for (size_t type = 0; type < sizeof(p->by_type) / sizeof(p->by_type[0]); type++) {
+            if (p->by_type[type].objects > 0) {
+                print_stats(&p->by_type[type], file);
+                fprintf(file, "  %s\n", object_type_str((Object_Type) type));
+            }
+        }
+
+        fprintf(file, "\n%12s %10s %9s  %s\n", "bytes", "objects", "survived", "call site");
+        for (size_t i = 0; i < count && i < ALLOCATION_PROFILE_MAX_SITES; i++) {
+            print_stats(&lines[i].stats, file);
+            fprintf(file, "  %s\n", lines[i].text);
+        }
+        if (count > ALLOCATION_PROFILE_MAX_SITES) {
+            fprintf(file, "(%zu more call sites)\n", count - ALLOCATION_PROFILE_MAX_SITES);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        free(lines[i].text);
+    }
+    free(lines);
+
+    if (ok && ferror(file)) {
+        *error_code = EIO;
+        return false;
+    }
+    return ok;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <errno.h>
+#include <stdio.h>
+
+#include "object.h"
+
+// Attributes heap usage to the expressions that allocate. The allocator samples an allocation
+// every `sample_bytes` bytes allocated and tags it with the expression of the top frame of the
+// stack, its call site; the next collection tells whether the object survived it. Every
+// sample stands for `sample_bytes` bytes, so totals are estimates, exact with `sample_bytes` 1.
+//
+// Call sites are kept alive by the allocator while profiling, so that their addresses are not
+// reused by other expressions.
+
+typedef struct {
+    double bytes;
+    double objects;
+    // Objects that were in the heap during a collection, and those that survived it.
+    double collected;
+    double survived;
+} AllocationProfile_Stats;
+
+typedef struct {
+    // Nil for allocations made outside of evaluation, by the reader for instance.
+    Object *expr;
+    AllocationProfile_Stats stats;
+} AllocationProfile_Site;
+
+typedef struct {
+    AllocationProfile_Site *data;
+    size_t count;
+    size_t capacity;
+} AllocationProfile_Sites;
+
+typedef struct {
+    Object *obj;
+    size_t site;
+    // How many times `sample_bytes` the sample stands for.
+    size_t weight;
+} AllocationProfile_Sample;
+
+typedef struct {
+    AllocationProfile_Sample *data;
+    size_t count;
+    size_t capacity;
+} AllocationProfile_Samples;
+
+typedef struct {
+    Object *expr;
+    size_t index;
+} AllocationProfile_Slot;
+
+typedef struct {
+    size_t sample_bytes;
+    // Samples taken, and samples lost because memory ran out.
+    size_t samples;
+    size_t dropped;
+    AllocationProfile_Stats by_type[TYPE_HANDLE + 1];
+    AllocationProfile_Sites sites;
+
+    // Samples allocated since the last collection: their type is known once constructed.
+    AllocationProfile_Samples _pending;
+    // Open-addressing map from expressions to their sites.
+    AllocationProfile_Slot *_slots;
+    size_t _slots_capacity;
+} AllocationProfile;
+
+AllocationProfile allocation_profile_make(size_t sample_bytes);
+
+void allocation_profile_free(AllocationProfile *p);
+
+// Records that `obj`, allocated by `expr`, stands for `weight` samples.
+void allocation_profile_sample(AllocationProfile *p, Object *expr, Object *obj, size_t weight);
+
+// Accounts for the pending samples, after marking: unmarked ones are about to be freed.
+void allocation_profile_collect(AllocationProfile *p);
+
+// Writes heap usage by type, then by call site, the sites allocating the most bytes first.
+[[nodiscard]]
+bool allocation_profile_try_write(AllocationProfile *p, FILE *file, errno_t *error_code);
@@ -1,78 +1,136 @@
 #include "allocator.h"
 
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
 #include "utility/guards.h"
 #include "utility/slice.h"
 #include "utility/dynamic_array.h"
 #include "utility/exchange.h"
 #include "utility/pointers.h"
+#include "utility/macros.h"
 #include "vm/stack.h"
+#include "vm/tasks.h"
+#include "vm/trace.h"
 #include "vm/reader/parser.h"
 
+#define ALLOCATOR_DEFAULT_GC_TIME_TARGET 0.05
+// Objects swept before each allocation while sweeping lazily.
+#define ALLOCATOR_SWEEP_BATCH 64
+// Gray objects the mark stack holds, 64 KiB.
+#define ALLOCATOR_MARK_STACK_CAPACITY 8192
+
+static uint64_t clock_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
 ObjectAllocator allocator_make(ObjectAllocator_Config config) {
+    auto const is_profiling = config.profile_sample_bytes > 0;
+    // Reserved once, so that collecting allocates nothing; without it, marking rescans the heap.
+    auto const mark_stack = (Object **) malloc(ALLOCATOR_MARK_STACK_CAPACITY * sizeof(Object *));
     return (ObjectAllocator) {
             ._soft_limit = config.soft_limit_initial,
+            ._soft_limit_min = config.soft_limit_initial,
             ._hard_limit = config.hard_limit,
+            ._policy = config.policy,
             ._grow_factor = config.soft_limit_grow_factor,
+            ._gc_time_target = 0 == config.gc_time_target ? ALLOCATOR_DEFAULT_GC_TIME_TARGET : config.gc_time_target,
+            ._sweep_mode = config.sweep_mode,
+            ._nursery_size = is_profiling || config.debug.no_free || ALLOCATOR_NEVER_GC == config.debug.gc_mode
+                             ? 0
+                             : config.nursery_size,
+            ._mark_stack = {
+                    .data = mark_stack,
+                    .capacity = nullptr == mark_stack ? 0 : ALLOCATOR_MARK_STACK_CAPACITY
+            },
+            ._mutator_start_ns = clock_ns(),
             ._gc_mode = config.debug.gc_mode,
             ._trace = config.debug.trace,
-            ._no_free = config.debug.no_free
+            ._no_free = config.debug.no_free,
+            ._trace_events = config.trace_events,
+            ._trace_ring = config.trace,
+            ._sample_countdown = is_profiling ? config.profile_sample_bytes : SIZE_MAX,
+            ._profile = is_profiling ? allocation_profile_make(config.profile_sample_bytes) : (AllocationProfile) {0}
     };
 }
 
-void allocator_free(ObjectAllocator *a) {
-    guard_is_not_null(a);
-
-    for (auto it = a->_objects; nullptr != it;) {
-        auto const next = it->next;
-        free(it);
-        it = next;
+static void release(Object *obj) {
+    if (TYPE_HANDLE == obj->type) {
+        obj->as_handle.class->release(obj->as_handle.data);
     }
+}
 
-    *a = (ObjectAllocator) {0};
+// The nursery, allocated from `data` up to `top`.
+struct ObjectAllocator_Chunk {
+    uint8_t *top;
+    uint8_t *end;
+    uint8_t data[];
+};
+
+static_assert(0 == offsetof(ObjectAllocator_Chunk, data) % _Alignof(Object));
+
+// What an object takes in the nursery, where the next one starts aligned.
+static size_t footprint(size_t size) {
+    return (size + _Alignof(Object) - 1) / _Alignof(Object) * _Alignof(Object);
 }
 
+#define nursery_for(It, A)                                                                      \
+for (auto It = nullptr == (A)->_nursery ? nullptr : (Object *) (A)->_nursery->data;              \
+     nullptr != It && (uint8_t *) It < (A)->_nursery->top;                                      \
+     It = (Object *) ((uint8_t *) It + footprint(It->size)))
+
 #define update_root(Dst, Src, Member) ((Dst).Member = pointer_first_nonnull((Dst).Member, (Src).Member))
 
 void allocator_set_roots(ObjectAllocator *a, ObjectAllocator_Roots roots) {
     guard_is_not_null(a);
 
     update_root(a->_roots, roots, stack); // NOLINT(*-sizeof-expression)
+    update_root(a->_roots, roots, tasks); // NOLINT(*-sizeof-expression)
     update_root(a->_roots, roots, parser_stack); // NOLINT(*-sizeof-expression)
     update_root(a->_roots, roots, parser_expr);
     update_root(a->_roots, roots, globals);
     update_root(a->_roots, roots, value);
     update_root(a->_roots, roots, error);
     update_root(a->_roots, roots, exprs);
+    update_root(a->_roots, roots, module_forms);
 }
 
-[[nodiscard]]
-static bool try_mark_gray(Objects *gray, Object *obj) {
-    guard_is_not_null(gray);
+// A gray object that does not fit in the mark stack stays gray, for `rescan` to find.
+static void mark_gray(ObjectAllocator *a, Object *obj) {
+    guard_is_not_null(a);
     guard_is_not_null(obj);
     guard_is_equal(obj->color, OBJECT_WHITE);
 
-    if (false == da_try_append(gray, obj)) { // NOLINT(*-sizeof-expression)
-        return false;
-    }
-
     obj->color = OBJECT_GRAY;
-    return true;
+    if (false == slice_try_append(&a->_mark_stack, obj)) { // NOLINT(*-sizeof-expression)
+        a->_has_mark_stack_overflowed = true;
+    }
 }
 
 #define TYPE_FREED 12345
 
-[[nodiscard]]
-static bool try_mark_gray_if_white(Objects *gray, Object *obj) {
-    guard_is_not_null(gray);
+static void mark_gray_if_white(ObjectAllocator *a, Object *obj) {
+    guard_is_not_null(a);
     guard_is_not_null(obj);
 
     guard_is_not_equal((int) obj->type, TYPE_FREED);
 
     if (OBJECT_WHITE != obj->color) {
-        return true;
+        return;
     }
 
-    return try_mark_gray(gray, obj);
+    mark_gray(a, obj);
 }
 
 static void mark_black(Object *obj) {
@@ -80,225 +138,1068 @@ static void mark_black(Object *obj) {
     obj->color = OBJECT_BLACK;
 }
 
-[[nodiscard]]
-static bool try_mark_children(Objects *gray, Object *obj) {
-    guard_is_not_null(gray);
-    guard_is_not_null(obj);
-    guard_is_equal(obj->color, OBJECT_GRAY);
-
+// The slots of the objects `obj` points to; returns how many there are.
+static size_t children(Object *obj, Object **slots[4]) {
     switch (obj->type) {
         case TYPE_INT:
         case TYPE_STRING:
         case TYPE_SYMBOL:
         case TYPE_NIL:
-        case TYPE_PRIMITIVE: {
-            mark_black(obj);
-            return true;
+        case TYPE_PRIMITIVE:
+        case TYPE_HANDLE: {
+            return 0;
         }
         case TYPE_LIST: {
-            mark_black(obj);
-
-            return try_mark_gray_if_white(gray, obj->as_list.first)
-                   && try_mark_gray_if_white(gray, obj->as_list.rest);
+            slots[0] = &obj->as_list.first;
+            slots[1] = &obj->as_list.rest;
+            return 2;
         }
         case TYPE_CLOSURE:
         case TYPE_MACRO: {
-            mark_black(obj);
-
-            return try_mark_gray_if_white(gray, obj->as_closure.args)
-                   && try_mark_gray_if_white(gray, obj->as_closure.env)
-                   && try_mark_gray_if_white(gray, obj->as_closure.body);
+            slots[0] = &obj->as_closure.args;
+            slots[1] = &obj->as_closure.env;
+            slots[2] = &obj->as_closure.body;
+            return 3;
         }
         case TYPE_DICT: {
-            mark_black(obj);
-
-            return try_mark_gray_if_white(gray, obj->as_dict.key)
-                   && try_mark_gray_if_white(gray, obj->as_dict.value)
-                   && try_mark_gray_if_white(gray, obj->as_dict.left)
-                   && try_mark_gray_if_white(gray, obj->as_dict.right);
+            slots[0] = &obj->as_dict.key;
+            slots[1] = &obj->as_dict.value;
+            slots[2] = &obj->as_dict.left;
+            slots[3] = &obj->as_dict.right;
+            return 4;
         }
     }
 
     guard_unreachable();
 }
 
-[[nodiscard]]
-static bool try_mark_(ObjectAllocator *a, Objects *gray) {
+static bool has_children(Object_Type type) {
+    return TYPE_LIST == type || TYPE_CLOSURE == type || TYPE_MACRO == type || TYPE_DICT == type;
+}
+
+static void mark_children(ObjectAllocator *a, Object *obj, ObjectAllocator_Counts *marked) {
     guard_is_not_null(a);
-    guard_is_not_null(gray);
+    guard_is_not_null(obj);
+    guard_is_not_null(marked);
+    guard_is_equal(obj->color, OBJECT_GRAY);
+
+    mark_black(obj);
+    marked->objects++;
+    marked->bytes += obj->size;
+
+    // Last first: the first element of a list is popped before its rest, so that marking a long
+    // list keeps the mark stack short.
+    Object **slots[4];
+    for (auto i = children(obj, slots); i > 0; i--) {
+        mark_gray_if_white(a, *slots[i - 1]);
+    }
+}
 
-    slice_clear(gray);
+// Visits a slot holding a root; the same slot may be visited more than once.
+typedef struct {
+    bool (*try_visit)(void *context, Object **slot);
+    void *context;
+} RootVisitor;
 
-    stack_for_reversed(frame, a->_roots.stack) {
+[[nodiscard]]
+static bool try_visit_stack(RootVisitor visitor, struct Stack *stack) {
+    stack_for_reversed(frame, stack) {
         auto const ok =
-                try_mark_gray_if_white(gray, frame->expr)
-                && try_mark_gray_if_white(gray, frame->env)
-                && try_mark_gray_if_white(gray, frame->unevaluated)
-                && try_mark_gray_if_white(gray, frame->evaluated);
+                visitor.try_visit(visitor.context, &frame->expr)
+                && visitor.try_visit(visitor.context, &frame->env)
+                && visitor.try_visit(visitor.context, &frame->unevaluated)
+                && visitor.try_visit(visitor.context, &frame->evaluated)
+                && visitor.try_visit(visitor.context, &frame->body);
         if (false == ok) {
             return false;
         }
         if (nullptr != frame->results_list) {
-            if (false == try_mark_gray_if_white(gray, *frame->results_list)) {
+            if (false == visitor.try_visit(visitor.context, frame->results_list)) {
                 return false;
             }
         }
 
         slice_for_v(it, frame_locals(frame)) {
-            if (false == try_mark_gray_if_white(gray, *it)) {
+            if (false == visitor.try_visit(visitor.context, it)) {
                 return false;
             }
         }
     }
 
+    return true;
+}
+
+// Suspended tasks keep their frames out of the VM's stack.
+[[nodiscard]]
+static bool try_visit_tasks(RootVisitor visitor, struct Tasks *tasks) {
+    if (false == try_visit_stack(visitor, &tasks->main.stack)) {
+        return false;
+    }
+
+    slice_for_v(it, tasks->spawned) {
+        auto const task = *it;
+        auto const ok =
+                try_visit_stack(visitor, &task->stack)
+                && visitor.try_visit(visitor.context, &task->value)
+                && visitor.try_visit(visitor.context, &task->error);
+        if (false == ok) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+[[nodiscard]]
+static bool try_visit_roots(ObjectAllocator *a, RootVisitor visitor) {
+    if (false == try_visit_stack(visitor, a->_roots.stack) || false == try_visit_tasks(visitor, a->_roots.tasks)) {
+        return false;
+    }
+
     slice_for(it, a->_roots.parser_stack) {
-        if (false == try_mark_gray_if_white(gray, it->last)) {
+        if (false == visitor.try_visit(visitor.context, &it->last)) {
             return false;
         }
     }
 
     auto const ok =
-            try_mark_gray_if_white(gray, *a->_roots.parser_expr)
-            && try_mark_gray_if_white(gray, *a->_roots.globals)
-            && try_mark_gray_if_white(gray, *a->_roots.value)
-            && try_mark_gray_if_white(gray, *a->_roots.error)
-            && try_mark_gray_if_white(gray, *a->_roots.exprs);
+            visitor.try_visit(visitor.context, a->_roots.parser_expr)
+            && visitor.try_visit(visitor.context, a->_roots.globals)
+            && visitor.try_visit(visitor.context, a->_roots.value)
+            && visitor.try_visit(visitor.context, a->_roots.error)
+            && visitor.try_visit(visitor.context, a->_roots.exprs)
+            && visitor.try_visit(visitor.context, a->_roots.module_forms);
     if (false == ok) {
         return false;
     }
 
-    Object *obj;
-    while (slice_try_pop(gray, &obj)) {
-        if (false == try_mark_children(gray, obj)) {
+    slice_for(it, &a->_profile.sites) {
+        if (false == visitor.try_visit(visitor.context, &it->expr)) {
             return false;
         }
     }
-    guard_is_true(slice_empty(*gray));
 
     return true;
 }
 
+// Never fails: marking needs no more memory than the mark stack.
+static bool try_mark_root(void *a, Object **slot) {
+    mark_gray_if_white(a, *slot);
+    return true;
+}
+
+static void drain_mark_stack(ObjectAllocator *a, ObjectAllocator_Counts *marked) {
+    Object *obj;
+    while (slice_try_pop(&a->_mark_stack, &obj)) {
+        mark_children(a, obj, marked);
+    }
+}
+
+// Marks the gray objects the mark stack had no room for, finding them in the heap, until a whole
+// pass leaves none behind; every pass marks at least those it starts with.
+static void rescan(ObjectAllocator *a, ObjectAllocator_Counts *marked) {
+    while (exchange(a->_has_mark_stack_overflowed, false)) {
+        a->_statistics.mark_stack_overflows++;
+        for (auto it = a->_objects; nullptr != it; it = it->next) {
+            if (OBJECT_GRAY == it->color) {
+                mark_children(a, it, marked);
+                drain_mark_stack(a, marked);
+            }
+        }
+        nursery_for(it, a) {
+            if (OBJECT_GRAY == it->color) {
+                mark_children(a, it, marked);
+                drain_mark_stack(a, marked);
+            }
+        }
+    }
+}
+
+static void mark(ObjectAllocator *a, ObjectAllocator_Counts *marked) {
+    guard_is_not_null(a);
+    guard_is_not_null(marked);
+
+    *marked = (ObjectAllocator_Counts) {0};
+    slice_clear(&a->_mark_stack);
+    a->_has_mark_stack_overflowed = false;
+
+    [[maybe_unused]]
+    auto const ok = try_visit_roots(a, (RootVisitor) {.try_visit = try_mark_root, .context = a});
+    guard_is_true(ok);
+
+    drain_mark_stack(a, marked);
+    rescan(a, marked);
+    guard_is_true(slice_empty(a->_mark_stack));
+}
+
+// Objects swept together, and what sweeping them found.
+typedef struct {
+    // Still black, in no particular order: `apply_sweep` whitens them on the VM's thread.
+    Object *survivors;
+    Object *last_survivor;
+    // Dead handles, when they are left to release.
+    Object *handles;
+    ObjectAllocator_Counts freed[TYPE_HANDLE + 1];
+} Sweep;
+
+static void dispose(Object *obj, bool no_free) {
+    release(obj);
+
+    if (no_free) {
+        obj->type = TYPE_FREED;
+    } else {
+        free(obj);
+    }
+}
+
+static void sweep_object(Sweep *sweep, Object *obj, bool no_free, bool should_release) {
+    if (OBJECT_BLACK == obj->color) {
+        obj->next = exchange(sweep->survivors, obj);
+        sweep->last_survivor = pointer_first_nonnull(sweep->last_survivor, obj);
+        return;
+    }
+
+    guard_is_equal(obj->color, OBJECT_WHITE);
+    sweep->freed[obj->type].objects++;
+    sweep->freed[obj->type].bytes += obj->size;
+
+    if (TYPE_HANDLE == obj->type && false == should_release) {
+        obj->next = exchange(sweep->handles, obj);
+        return;
+    }
+
+    dispose(obj, no_free);
+}
+
+// Freed objects go back to `malloc`, which keeps their pages: give them back to the system once
+// the heap has shrunk enough for the soft limit to follow.
+static void trim_heap(ObjectAllocator *a) {
+    if (a->_no_free) {
+        return;
+    }
+
+#ifdef __GLIBC__
+    malloc_trim(0);
+    a->_statistics.heap_trims++;
+#endif
+}
+
+// The heap is trimmed once the garbage that made the soft limit shrink is freed.
+static void trim_heap_if_swept(ObjectAllocator *a) {
+    if (a->_should_trim && nullptr == a->_unswept && false == a->_is_background_sweeping) {
+        a->_should_trim = false;
+        trim_heap(a);
+    }
+}
+
+// Puts the survivors back with the other objects, white, and accounts for the rest.
+static void apply_sweep(ObjectAllocator *a, Sweep *sweep) {
+    for (auto it = sweep->survivors; nullptr != it; it = it->next) {
+        it->color = OBJECT_WHITE;
+    }
+    if (nullptr != sweep->survivors) {
+        sweep->last_survivor->next = a->_objects;
+        a->_objects = sweep->survivors;
+    }
+
+    for (auto it = sweep->handles; nullptr != it;) {
+        auto const next = it->next;
+        dispose(it, a->_no_free);
+        it = next;
+    }
+
+    for (size_t type = 0; type <= TYPE_HANDLE; type++) {
+        a->_heap_size -= sweep->freed[type].bytes;
+        a->_garbage_size -= sweep->freed[type].bytes;
+        a->_statistics.freed[type].objects += sweep->freed[type].objects;
+        a->_statistics.freed[type].bytes += sweep->freed[type].bytes;
+    }
+
+    trim_heap_if_swept(a);
+}
+
+static void sweep_some(ObjectAllocator *a, size_t count) {
+    auto sweep = (Sweep) {0};
+    for (size_t i = 0; i < count && nullptr != a->_unswept; i++) {
+        auto const obj = exchange(a->_unswept, a->_unswept->next);
+        sweep_object(&sweep, obj, a->_no_free, true);
+    }
+
+    apply_sweep(a, &sweep);
+}
+
+// Sweeps the lists the allocators hand it, one at a time, and hands back what it found. It
+// only writes the link of the survivors, which nothing else reads until they are handed back:
+// the VM's thread reads their color meanwhile, so it leaves them black for `apply_sweep`. It
+// frees the rest but handles, whose `release` may expect the VM's thread.
+struct ObjectAllocator_Sweeper {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    bool no_free;
+    bool should_stop;
+    Object *unswept;
+    atomic_bool is_done;
+    Sweep sweep;
+};
+
+static void *run_sweeper(void *arg) {
+    auto const s = (ObjectAllocator_Sweeper *) arg;
+
+    pthread_mutex_lock(&s->lock);
+    while (true) {
+        while (false == s->should_stop && nullptr == s->unswept) {
+            pthread_cond_wait(&s->changed, &s->lock);
+        }
+        if (s->should_stop) {
+            break;
+        }
+        auto unswept = exchange(s->unswept, nullptr);
+        pthread_mutex_unlock(&s->lock);
+
+        auto sweep = (Sweep) {0};
+        while (nullptr != unswept) {
+            auto const obj = exchange(unswept, unswept->next);
+            sweep_object(&sweep, obj, s->no_free, false);
+        }
+
+        pthread_mutex_lock(&s->lock);
+        s->sweep = sweep;
+        atomic_store_explicit(&s->is_done, true, memory_order_release);
+        pthread_cond_broadcast(&s->changed);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    return nullptr;
+}
+
+static bool try_start_sweeper(ObjectAllocator *a) {
+    if (nullptr != a->_sweeper) {
+        return true;
+    }
+
+    auto const s = (ObjectAllocator_Sweeper *) calloc(1, sizeof(ObjectAllocator_Sweeper));
+    if (nullptr == s) {
+        return false;
+    }
+
+    s->no_free = a->_no_free;
+    pthread_mutex_init(&s->lock, nullptr);
+    pthread_cond_init(&s->changed, nullptr);
+    if (0 != pthread_create(&s->thread, nullptr, run_sweeper, s)) {
+        pthread_cond_destroy(&s->changed);
+        pthread_mutex_destroy(&s->lock);
+        free(s);
+        return false;
+    }
+
+    a->_sweeper = s;
+    return true;
+}
+
+static void stop_sweeper(ObjectAllocator_Sweeper *s) {
+    pthread_mutex_lock(&s->lock);
+    s->should_stop = true;
+    pthread_cond_broadcast(&s->changed);
+    pthread_mutex_unlock(&s->lock);
+
+    pthread_join(s->thread, nullptr);
+    pthread_cond_destroy(&s->changed);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+}
+
+static void start_background_sweep(ObjectAllocator *a) {
+    auto const s = a->_sweeper;
+
+    pthread_mutex_lock(&s->lock);
+    s->unswept = exchange(a->_unswept, nullptr);
+    pthread_cond_broadcast(&s->changed);
+    pthread_mutex_unlock(&s->lock);
+
+    a->_is_background_sweeping = true;
+}
+
+static void take_background_sweep(ObjectAllocator *a) {
+    auto const s = a->_sweeper;
+
+    pthread_mutex_lock(&s->lock);
+    while (false == atomic_load_explicit(&s->is_done, memory_order_acquire)) {
+        pthread_cond_wait(&s->changed, &s->lock);
+    }
+    auto sweep = exchange(s->sweep, (Sweep) {0});
+    atomic_store_explicit(&s->is_done, false, memory_order_relaxed);
+    pthread_mutex_unlock(&s->lock);
+
+    a->_is_background_sweeping = false;
+    apply_sweep(a, &sweep);
+}
+
+void allocator_finish_sweep(ObjectAllocator *a) {
+    guard_is_not_null(a);
+
+    if (a->_is_background_sweeping) {
+        take_background_sweep(a);
+    }
+    sweep_some(a, SIZE_MAX);
+}
+
+void allocator_stop_sweeper(ObjectAllocator *a) {
+    guard_is_not_null(a);
+
+    allocator_finish_sweep(a);
+    if (nullptr != a->_sweeper) {
+        stop_sweeper(exchange(a->_sweeper, nullptr));
+    }
+}
+
+// Hands what a collection left to sweep to whoever sweeps it.
+static void start_sweep(ObjectAllocator *a) {
+    if (nullptr == a->_unswept) {
+        return;
+    }
+
+    switch (a->_sweep_mode) {
+        case ALLOCATOR_SWEEP_LAZY: {
+            return;
+        }
+        case ALLOCATOR_SWEEP_EAGER: {
+            sweep_some(a, SIZE_MAX);
+            return;
+        }
+        case ALLOCATOR_SWEEP_BACKGROUND: {
+            if (try_start_sweeper(a)) {
+                start_background_sweep(a);
+            }
+            return;
+        }
+    }
+
+    guard_unreachable();
+}
+
+// Sweeps some more before an allocation, taking the background sweep back once it is done.
+static void continue_sweep(ObjectAllocator *a) {
+    if (a->_is_background_sweeping) {
+        if (atomic_load_explicit(&a->_sweeper->is_done, memory_order_acquire)) {
+            take_background_sweep(a);
+        }
+        return;
+    }
+
+    if (nullptr != a->_unswept) {
+        sweep_some(a, ALLOCATOR_SWEEP_BATCH);
+    }
+}
+
+static bool is_young(ObjectAllocator const *a, Object const *obj) {
+    auto const address = (uintptr_t) obj;
+    auto const chunk = a->_nursery;
+    return nullptr != chunk && address >= (uintptr_t) chunk->data && address < (uintptr_t) chunk->top;
+}
+
+// Handles are released when they die, which the nursery would not notice; large objects would
+// leave it too little room.
+static bool is_young_allocation(ObjectAllocator const *a, Object_Type type, size_t size) {
+    return a->_is_nursery_open && TYPE_HANDLE != type && size <= a->_nursery_size / 4;
+}
+
 [[nodiscard]]
-static bool try_mark(ObjectAllocator *a) {
-    auto gray = (Objects) {0};
-    auto const ok = try_mark_(a, &gray);
-    da_free(&gray);
-    return ok;
+static bool try_allocate_young(ObjectAllocator *a, size_t size, Object **obj) {
+    auto const bytes = footprint(size);
+    auto chunk = a->_nursery;
+    if (nullptr == chunk) {
+        chunk = (ObjectAllocator_Chunk *) malloc(sizeof(ObjectAllocator_Chunk) + a->_nursery_size);
+        if (nullptr == chunk) {
+            return false;
+        }
+
+        chunk->top = chunk->data;
+        chunk->end = chunk->data + a->_nursery_size;
+        a->_nursery = chunk;
+    }
+    // Once it is full, objects go to the heap until the next safe point collects it.
+    if (bytes > (size_t) (chunk->end - chunk->top)) {
+        a->_is_nursery_full = true;
+        return false;
+    }
+
+    *obj = (Object *) chunk->top;
+    chunk->top += bytes;
+    memset(*obj, 0, size);
+    a->_nursery_bytes += size;
+    return true;
 }
 
-static void sweep(ObjectAllocator *a) {
+static void remember(ObjectAllocator *a, Object *obj) {
+    if (false == da_try_append(&a->_remembered, obj)) { // NOLINT(*-sizeof-expression)
+        a->_is_remembered_lost = true;
+    }
+}
+
+void allocator_note_write(ObjectAllocator *a, Object *obj) {
     guard_is_not_null(a);
+    guard_is_not_null(obj);
 
-    Object *prev = nullptr;
-    for (auto it = a->_objects; nullptr != it;) {
-        if (OBJECT_BLACK == it->color) {
-            it->color = OBJECT_WHITE;
-            prev = exchange(it, it->next);
-            continue;
+    if (0 == a->_nursery_bytes || OBJECT_IMMORTAL == obj->color || OBJECT_IMAGE == obj->color || is_young(a, obj)) {
+        return;
+    }
+
+    remember(a, obj);
+}
+
+static size_t count_young(ObjectAllocator *a) {
+    size_t objects = 0;
+    nursery_for(obj, a) {
+        objects++;
+    }
+
+    return objects;
+}
+
+// The objects of the nursery a collection of the heap marked, whitened again: only the heap
+// is swept.
+static ObjectAllocator_Counts whiten_nursery(ObjectAllocator *a) {
+    auto marked = (ObjectAllocator_Counts) {0};
+    nursery_for(obj, a) {
+        if (OBJECT_BLACK == obj->color) {
+            marked.objects++;
+            marked.bytes += obj->size;
         }
+        obj->color = OBJECT_WHITE;
+    }
 
-        auto const unreached = exchange(it, it->next);
-        guard_is_equal(unreached->color, OBJECT_WHITE);
+    return marked;
+}
 
-        if (nullptr == prev) {
-            a->_objects = it;
-        } else {
-            prev->next = it;
+// Forgets the remembered objects a collection of the heap found unreachable, before they are
+// swept.
+static void forget_unreachable(ObjectAllocator *a) {
+    size_t kept = 0;
+    slice_for_v(it, a->_remembered) {
+        if (OBJECT_WHITE != (*it)->color) {
+            a->_remembered.data[kept++] = *it;
         }
+    }
+    a->_remembered.count = kept;
+}
 
-        unreached->next = exchange(a->_freed, unreached);
-        a->_heap_size -= unreached->size;
+// The objects of the nursery reachable from the roots and from older objects, black.
+typedef struct {
+    ObjectAllocator *a;
+    Objects survivors;
+} Evacuation;
 
-        if (a->_no_free) {
-            unreached->type = TYPE_FREED;
-        } else {
-            free(unreached);
+static bool try_find_survivor(void *context, Object **slot) {
+    auto const e = (Evacuation *) context;
+    auto const obj = *slot;
+    // The color of older objects is not read: the background sweeper may be writing it.
+    if (false == is_young(e->a, obj) || OBJECT_WHITE != obj->color) {
+        return true;
+    }
+
+    if (false == da_try_append(&e->survivors, obj)) { // NOLINT(*-sizeof-expression)
+        return false;
+    }
+
+    obj->color = OBJECT_BLACK;
+    return true;
+}
+
+[[nodiscard]]
+static bool try_find_children_survivors(Evacuation *e, Object *obj) {
+    Object **slots[4];
+    auto const count = children(obj, slots);
+    for (size_t i = 0; i < count; i++) {
+        if (false == try_find_survivor(e, slots[i])) {
+            return false;
         }
     }
+
+    return true;
 }
 
-static size_t count_objects(ObjectAllocator *a) {
-    size_t count = 0;
-    for (auto it = a->_objects; nullptr != it; it = it->next) {
-        count++;
+// Survivors keep the address of their copy in `next`, which objects in the nursery do not use.
+static bool try_forward(void *context, Object **slot) {
+    auto const a = (ObjectAllocator const *) context;
+    if (is_young(a, *slot)) {
+        guard_is_equal((*slot)->color, OBJECT_BLACK);
+        *slot = (*slot)->next;
+    }
+
+    return true;
+}
+
+static void forward_children(ObjectAllocator *a, Object *obj) {
+    Object **slots[4];
+    auto const count = children(obj, slots);
+    for (size_t i = 0; i < count; i++) {
+        (void) try_forward(a, slots[i]);
+    }
+}
+
+[[nodiscard]]
+static bool try_find_survivors(ObjectAllocator *a, Evacuation *e) {
+    if (false == try_visit_roots(a, (RootVisitor) {.try_visit = try_find_survivor, .context = e})) {
+        return false;
+    }
+
+    if (a->_is_remembered_lost) {
+        for (auto it = a->_objects; nullptr != it; it = it->next) {
+            if (false == try_find_children_survivors(e, it)) {
+                return false;
+            }
+        }
+    } else {
+        slice_for_v(it, a->_remembered) {
+            if (false == try_find_children_survivors(e, *it)) {
+                return false;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < e->survivors.count; i++) {
+        if (false == try_find_children_survivors(e, e->survivors.data[i])) {
+            return false;
+        }
     }
 
-    return count;
+    return true;
 }
 
+// Copies are made before any object moves, so that running out of memory leaves the nursery as
+// it was.
 [[nodiscard]]
-static bool try_collect_garbage(ObjectAllocator *a) {
+static bool try_make_copies(Objects survivors) {
+    for (size_t i = 0; i < survivors.count; i++) {
+        auto const obj = survivors.data[i];
+        obj->next = (Object *) malloc(obj->size);
+        if (nullptr == obj->next) {
+            for (size_t j = 0; j < i; j++) {
+                free(survivors.data[j]->next);
+            }
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void move_to_heap(ObjectAllocator *a, Object *obj) {
+    auto const copy = obj->next;
+    memcpy(copy, obj, obj->size);
+    // Strings and symbols keep their characters after the object.
+    if (TYPE_STRING == obj->type || TYPE_SYMBOL == obj->type) {
+        copy->as_string = (char const *) copy + (obj->as_string - (char const *) obj);
+    }
+    copy->color = OBJECT_WHITE;
+    copy->next = exchange(a->_objects, copy);
+}
+
+// Everything in the nursery is now moved or dead: dead objects are accounted for, and all of
+// them are marked freed to catch pointers that were not updated.
+static void empty_nursery(ObjectAllocator *a) {
+    nursery_for(obj, a) {
+        if (OBJECT_BLACK != obj->color) {
+            a->_heap_size -= obj->size;
+            a->_statistics.freed[obj->type].objects++;
+            a->_statistics.freed[obj->type].bytes += obj->size;
+        }
+        obj->type = TYPE_FREED;
+    }
+
+    a->_nursery->top = a->_nursery->data;
+    a->_nursery_bytes = 0;
+    a->_is_nursery_full = false;
+    slice_clear(&a->_remembered);
+    a->_is_remembered_lost = false;
+}
+
+// Moves the survivors to the heap; fails, leaving the nursery as it was, if memory runs out.
+[[nodiscard]]
+static bool try_collect_nursery(ObjectAllocator *a) {
+    guard_is_false(a->_gc_is_running);
+
+    if (0 == a->_nursery_bytes) {
+        return true;
+    }
+
+    auto const start_ns = clock_ns();
+    // Older objects are found in the heap: none may be left with the sweeper.
+    if (a->_is_remembered_lost) {
+        allocator_finish_sweep(a);
+    }
+
+    auto e = (Evacuation) {.a = a};
+    auto const ok = try_find_survivors(a, &e) && try_make_copies(e.survivors);
+    if (false == ok) {
+        slice_for_v(it, e.survivors) {
+            (*it)->color = OBJECT_WHITE;
+        }
+        da_free(&e.survivors);
+        return false;
+    }
+
+    size_t promoted_bytes = 0;
+    slice_for_v(it, e.survivors) {
+        move_to_heap(a, *it);
+        promoted_bytes += (*it)->size;
+    }
+    (void) try_visit_roots(a, (RootVisitor) {.try_visit = try_forward, .context = a});
+    if (a->_is_remembered_lost) {
+        for (auto it = a->_objects; nullptr != it; it = it->next) {
+            forward_children(a, it);
+        }
+    } else {
+        slice_for_v(it, a->_remembered) {
+            forward_children(a, *it);
+        }
+        slice_for_v(it, e.survivors) {
+            forward_children(a, (*it)->next);
+        }
+    }
+    empty_nursery(a);
+    da_free(&e.survivors);
+
+    auto const pause_ns = clock_ns() - start_ns;
+    auto const statistics = &a->_statistics;
+    statistics->nursery_collections++;
+    statistics->nursery_pause_ns_total += pause_ns;
+    statistics->nursery_pause_ns_max = max(statistics->nursery_pause_ns_max, pause_ns);
+    statistics->promoted_bytes += promoted_bytes;
+    return true;
+}
+
+void allocator_open_nursery(ObjectAllocator *a) {
+    guard_is_not_null(a);
+
+    a->_is_nursery_open = a->_nursery_size > 0;
+}
+
+// If the nursery cannot be collected, what it holds stays there: older objects allocated
+// meanwhile are remembered.
+void allocator_close_nursery(ObjectAllocator *a) {
+    guard_is_not_null(a);
+
+    a->_is_nursery_open = false;
+    (void) try_collect_nursery(a);
+}
+
+void allocator_safepoint(ObjectAllocator *a) {
+    guard_is_not_null(a);
+
+    if (0 == a->_nursery_bytes) {
+        return;
+    }
+
+    auto const chunk = a->_nursery;
+    auto const is_full = a->_is_nursery_full || (size_t) (chunk->end - chunk->top) < a->_nursery_size / 8;
+    if (is_full || ALLOCATOR_ALWAYS_GC == a->_gc_mode) {
+        (void) try_collect_nursery(a);
+    }
+}
+
+void allocator_free(ObjectAllocator *a) {
+    guard_is_not_null(a);
+
+    allocator_stop_sweeper(a);
+
+    for (auto it = a->_objects; nullptr != it;) {
+        auto const next = it->next;
+        release(it);
+        free(it);
+        it = next;
+    }
+    free(a->_nursery);
+    da_free(&a->_remembered);
+    da_free(&a->_mark_stack);
+    allocation_profile_free(&a->_profile);
+    if (nullptr != a->_trace_events) {
+        fprintf(a->_trace_events, "%s", a->_has_trace_events ? "\n]\n" : "[]\n");
+    }
+
+    *a = (ObjectAllocator) {0};
+}
+
+static size_t pause_bucket(uint64_t ns) {
+    if (ns < 4) {
+        return (size_t) ns;
+    }
+
+    auto const log = (size_t) (63 - __builtin_clzll(ns));
+    auto const sub = (size_t) (ns >> (log - 2)) & 3;
+    return min(4 * (log - 1) + sub, (size_t) ALLOCATOR_PAUSE_BUCKETS - 1);
+}
+
+static uint64_t pause_bucket_end_ns(size_t bucket) {
+    if (bucket < 4) {
+        return bucket + 1;
+    }
+
+    auto const log = bucket / 4 + 1;
+    return (uint64_t) (4 + bucket % 4 + 1) << (log - 2);
+}
+
+static size_t allocated_objects(ObjectAllocator_Statistics const *statistics) {
+    size_t objects = 0;
+    for (size_t type = 0; type <= TYPE_HANDLE; type++) {
+        objects += statistics->allocated[type].objects;
+    }
+
+    return objects;
+}
+
+static size_t freed_objects(ObjectAllocator_Statistics const *statistics) {
+    size_t objects = 0;
+    for (size_t type = 0; type <= TYPE_HANDLE; type++) {
+        objects += statistics->freed[type].objects;
+    }
+
+    return objects;
+}
+
+static void append_trace_event(FILE *file, bool *has_events, char const *format, ...) {
+    fprintf(file, "%s", *has_events ? ",\n" : "[\n");
+    *has_events = true;
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(file, format, args);
+    va_end(args);
+}
+
+static void trace_collection(ObjectAllocator *a, uint64_t start_ns, uint64_t end_ns, size_t freed_bytes, size_t freed) {
+    append_trace_event(
+            a->_trace_events, &a->_has_trace_events,
+            "{\"name\": \"gc\", \"cat\": \"gc\", \"ph\": \"X\", \"pid\": %d, \"tid\": 1, "
+            "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"freed_bytes\": %zu, \"freed_objects\": %zu, "
+            "\"live_bytes\": %zu}}",
+            (int) getpid(), (double) start_ns / 1e3, (double) (end_ns - start_ns) / 1e3,
+            freed_bytes, freed, a->_statistics.live_bytes
+    );
+}
+
+static void trace_heap(ObjectAllocator *a) {
+    append_trace_event(
+            a->_trace_events, &a->_has_trace_events,
+            "{\"name\": \"heap\", \"ph\": \"C\", \"pid\": %d, \"tid\": 1, \"ts\": %.3f, "
+            "\"args\": {\"live_bytes\": %zu, \"soft_limit\": %zu}}",
+            (int) getpid(), (double) clock_ns() / 1e3, a->_statistics.live_bytes, a->_soft_limit
+    );
+}
+
+typedef struct {
+    // Since the collection before, and the bytes allocated meanwhile.
+    uint64_t mutator_ns;
+    size_t allocated_bytes;
+    uint64_t pause_ns;
+    // The heap the collection started with.
+    size_t heap_bytes;
+} Collection;
+
+static void collect_garbage(ObjectAllocator *a, Collection *collection) {
     guard_is_not_null(a);
+    guard_is_not_null(collection);
     guard_is_false(a->_gc_is_running);
 
     a->_gc_is_running = true;
 
+    auto const statistics = &a->_statistics;
+    auto const start_ns = clock_ns();
+    if (nullptr != a->_trace_ring) {
+        trace_record(a->_trace_ring, TRACE_GC_BEGIN, TRACE_NO_TASK, 0);
+    }
+
+    // Marking needs every object white: what the last collection left to sweep is swept first.
+    allocator_finish_sweep(a);
     auto const heap_size_initial = a->_heap_size;
-    size_t count_initial, count_final;
+    auto const objects_initial = allocated_objects(statistics) - freed_objects(statistics);
 
-    if (a->_trace) {
-        count_initial = count_objects(a);
+    ObjectAllocator_Counts marked;
+    mark(a, &marked);
+    if (a->_profile.sample_bytes > 0) {
+        allocation_profile_collect(&a->_profile);
     }
+    // The nursery is only freed by collecting it, at the next safe point.
+    auto const young = (ObjectAllocator_Counts) {.objects = count_young(a), .bytes = a->_nursery_bytes};
+    auto const young_marked = whiten_nursery(a);
+    forget_unreachable(a);
+    a->_unswept = exchange(a->_objects, nullptr);
+    auto const garbage_bytes = (heap_size_initial - young.bytes) - (marked.bytes - young_marked.bytes);
+    a->_garbage_size = garbage_bytes;
+    start_sweep(a);
 
-    if (false == try_mark(a)) {
-        return false;
+    auto const end_ns = clock_ns();
+    auto const pause_ns = end_ns - start_ns;
+    statistics->collections++;
+    statistics->pause_ns_total += pause_ns;
+    statistics->pause_ns_max = max(statistics->pause_ns_max, pause_ns);
+    statistics->pause_buckets[pause_bucket(pause_ns)]++;
+    statistics->live_bytes = marked.bytes;
+    statistics->live_bytes_max = max(statistics->live_bytes_max, marked.bytes);
+    statistics->heap_bytes_max = max(statistics->heap_bytes_max, heap_size_initial);
+    statistics->survival_percent = 0 == heap_size_initial ? 0 : 100 * marked.bytes / heap_size_initial;
+
+    *collection = (Collection) {
+            .mutator_ns = start_ns - a->_mutator_start_ns,
+            .allocated_bytes = a->_allocated_since_gc,
+            .pause_ns = pause_ns,
+            .heap_bytes = heap_size_initial
+    };
+    a->_mutator_start_ns = end_ns;
+    a->_allocated_since_gc = 0;
+
+    // What is unreachable is freed as it is swept, but known now.
+    auto const freed = (objects_initial - young.objects) - (marked.objects - young_marked.objects);
+    auto const freed_bytes = garbage_bytes;
+    if (nullptr != a->_trace_ring) {
+        trace_record(a->_trace_ring, TRACE_GC_END, TRACE_NO_TASK, (uint32_t) min(freed, (size_t) UINT32_MAX));
+    }
+    if (nullptr != a->_trace_events) {
+        trace_collection(a, start_ns, end_ns, freed_bytes, freed);
     }
-    sweep(a);
 
-    if (a->_trace && (count_final = count_objects(a)) < count_initial) {
-        printf(
-                "GC: freed %zu objects (%zu bytes total)\n",
-                count_initial - count_final, heap_size_initial - a->_heap_size
-        );
+    if (a->_trace && freed > 0) {
+        printf("GC: freed %zu objects (%zu bytes total)\n", freed, freed_bytes);
     }
 
     a->_gc_is_running = false;
-    return true;
 }
 
-static void adjust_soft_limit(ObjectAllocator *a, size_t size) {
+// Collecting a heap of H bytes took P ns, p = P / H per byte, and the program allocated at n ns
+// per byte since the collection before. Of the heap, L bytes survived: the survival rate times H.
+// Allocating B more bytes before the next collection, which then finds a heap of L + B, spends
+// p (L + B) / (p (L + B) + n B) of the time collecting; for a target share t, that is
+// B = p L (1 - t) / (t n - p (1 - t)). When collecting costs more than allocating allows, there
+// is no such B and the heap grows as far as it may. The limit at most doubles or halves at each
+// collection, so that one unusual pause does not throw it off.
+static size_t adaptive_soft_limit(ObjectAllocator const *a, Collection const *collection) {
+    if (0 == collection->allocated_bytes || 0 == collection->heap_bytes) {
+        return a->_soft_limit;
+    }
+
+    auto const t = a->_gc_time_target;
+    auto const live = (double) a->_statistics.live_bytes;
+    auto const p = (double) collection->pause_ns / (double) collection->heap_bytes;
+    auto const n = (double) collection->mutator_ns / (double) collection->allocated_bytes;
+    auto const denominator = t * n - p * (1 - t);
+    auto const budget = denominator > 0 ? p * live * (1 - t) / denominator : (double) a->_hard_limit;
+
+    auto const soft_limit = (double) a->_soft_limit;
+    return (size_t) min(max(live + budget, soft_limit / 2), min(soft_limit * 2, (double) a->_hard_limit));
+}
+
+static void adjust_soft_limit(ObjectAllocator *a, Collection const *collection, size_t size) {
     guard_is_not_null(a);
+    guard_is_not_null(collection);
+
+    size_t soft_limit;
+    switch (a->_policy) {
+        case ALLOCATOR_POLICY_GROW: {
+            soft_limit = min(size + a->_soft_limit * a->_grow_factor, a->_hard_limit);
+            break;
+        }
+        case ALLOCATOR_POLICY_ADAPTIVE: {
+            auto const least = min(max(a->_soft_limit_min, a->_statistics.live_bytes + size), a->_hard_limit);
+            soft_limit = max(adaptive_soft_limit(a, collection), least);
+            break;
+        }
+        default: {
+            guard_unreachable();
+        }
+    }
+    if (soft_limit == a->_soft_limit) {
+        return;
+    }
 
-    a->_soft_limit = min(size + a->_soft_limit * a->_grow_factor, a->_hard_limit);
+    auto const is_shrinking = soft_limit <= a->_soft_limit / 4 * 3;
+    a->_soft_limit = soft_limit;
+    a->_statistics.soft_limit_changes++;
+    if (is_shrinking) {
+        a->_should_trim = true;
+        trim_heap_if_swept(a);
+    }
+    if (nullptr != a->_trace_events) {
+        trace_heap(a);
+    }
 }
 
+// Only guards call it, which may be compiled out.
+[[maybe_unused]]
 static bool all_roots_set(ObjectAllocator const *a) {
     return nullptr != a->_roots.stack
+           && nullptr != a->_roots.tasks
            && nullptr != a->_roots.parser_stack
            && nullptr != a->_roots.parser_expr
            && nullptr != a->_roots.globals
            && nullptr != a->_roots.value
            && nullptr != a->_roots.error
-           && nullptr != a->_roots.exprs;
+           && nullptr != a->_roots.exprs
+           && nullptr != a->_roots.module_forms;
+}
+
+// Samples the allocation of every `sample_bytes`-th byte: an object spanning several of them
+// stands for as many samples.
+static void sample(ObjectAllocator *a, Object *obj, size_t size) {
+    auto const sample_bytes = a->_profile.sample_bytes;
+    auto const past = size - a->_sample_countdown;
+    a->_sample_countdown = sample_bytes - past % sample_bytes;
+
+    auto const stack = a->_roots.stack;
+    auto const expr = stack_is_empty(stack) ? OBJECT_NIL : stack_top(stack)->expr;
+    allocation_profile_sample(&a->_profile, expr, obj, 1 + past / sample_bytes);
 }
 
-bool allocator_try_allocate(ObjectAllocator *a, size_t size, Object **obj) {
+bool allocator_try_allocate(ObjectAllocator *a, Object_Type type, size_t size, Object **obj) {
     guard_is_not_null(a);
     guard_is_greater(size, 0);
     guard_is_true(all_roots_set(a));
 
+    continue_sweep(a);
+
+    // Garbage left to sweep is as good as freed.
     auto const should_collect =
             ALLOCATOR_NEVER_GC != a->_gc_mode
-            && (ALLOCATOR_ALWAYS_GC == a->_gc_mode || a->_heap_size + size >= a->_soft_limit);
+            && (ALLOCATOR_ALWAYS_GC == a->_gc_mode || a->_heap_size - a->_garbage_size + size >= a->_soft_limit);
     if (should_collect) {
-        if (false == try_collect_garbage(a)) {
-            return false;
-        }
-        adjust_soft_limit(a, size);
+        Collection collection;
+        collect_garbage(a, &collection);
+        adjust_soft_limit(a, &collection, size);
     }
 
     if (a->_heap_size + size >= a->_hard_limit) {
-        return false;
+        allocator_finish_sweep(a);
+        if (a->_heap_size + size >= a->_hard_limit) {
+            return false;
+        }
     }
 
-    auto const new_obj = (Object *) calloc(size, 1);
-    if (nullptr == new_obj) {
-        return false;
+    Object *new_obj;
+    if (false == is_young_allocation(a, type, size) || false == try_allocate_young(a, size, &new_obj)) {
+        new_obj = (Object *) calloc(size, 1);
+        if (nullptr == new_obj) {
+            return false;
+        }
+
+        new_obj->next = exchange(a->_objects, new_obj);
+        // It is written to as it is made: it may point to the nursery until the next safe point.
+        if (has_children(type) && (a->_is_nursery_open || a->_nursery_bytes > 0)) {
+            remember(a, new_obj);
+        }
     }
 
-    new_obj->next = exchange(a->_objects, new_obj);
     new_obj->size = size;
+    new_obj->type = type;
     a->_heap_size += size;
+    a->_allocated_since_gc += size;
+    a->_statistics.allocated[type].objects++;
+    a->_statistics.allocated[type].bytes += size;
+
+    if (size >= a->_sample_countdown) {
+        sample(a, new_obj, size);
+    } else {
+        a->_sample_countdown -= size;
+    }
 
     *obj = new_obj;
 
@@ -306,7 +1207,9 @@ bool allocator_try_allocate(ObjectAllocator *a, size_t size, Object **obj) {
 }
 
 void allocator_print_statistics(ObjectAllocator *a, FILE *file) {
-    size_t objects = 0;
+    allocator_finish_sweep(a);
+
+    auto objects = count_young(a);
     for (auto it = a->_objects; nullptr != it; it = it->next) {
         objects++;
     }
@@ -316,3 +1219,42 @@ void allocator_print_statistics(ObjectAllocator *a, FILE *file) {
     fprintf(file, "        Heap size: %zu bytes\n", a->_heap_size);
     fprintf(file, "  Heap size limit: %zu bytes\n", a->_hard_limit);
 }
+
+bool allocator_try_write_profile(ObjectAllocator *a, FILE *file, errno_t *error_code) {
+    guard_is_not_null(a);
+    guard_is_greater(a->_profile.sample_bytes, 0);
+
+    return allocation_profile_try_write(&a->_profile, file, error_code);
+}
+
+ObjectAllocator_Statistics allocator_statistics(ObjectAllocator *a) {
+    guard_is_not_null(a);
+
+    allocator_finish_sweep(a);
+
+    auto statistics = a->_statistics;
+    statistics.heap_bytes = a->_heap_size;
+    statistics.soft_limit = a->_soft_limit;
+    statistics.heap_bytes_max = max(statistics.heap_bytes_max, a->_heap_size);
+    return statistics;
+}
+
+uint64_t allocator_pause_percentile_ns(ObjectAllocator_Statistics const *statistics, double percentile) {
+    guard_is_not_null(statistics);
+    guard_is_in_range(percentile, 0, 1);
+
+    if (0 == statistics->collections) {
+        return 0;
+    }
+
+    auto const rank = (size_t) (percentile * (double) (statistics->collections - 1)) + 1;
+    size_t seen = 0;
+    for (size_t bucket = 0; bucket < ALLOCATOR_PAUSE_BUCKETS; bucket++) {
+        seen += statistics->pause_buckets[bucket];
+        if (seen >= rank) {
+            return min(pause_bucket_end_ns(bucket), statistics->pause_ns_max);
+        }
+    }
+
+    return statistics->pause_ns_max;
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <errno.h>
+
 #include "object.h"
+#include "allocation_profile.h"
 
 typedef enum {
     ALLOCATOR_SOFT_GC,
@@ -8,39 +11,154 @@ typedef enum {
     ALLOCATOR_NEVER_GC,
 } ObjectAllocator_GarbageCollectionMode;
 
+// How the soft limit, the heap size that triggers a collection, follows the heap.
+typedef enum {
+    // Grows by `soft_limit_grow_factor` at every collection, and never shrinks.
+    ALLOCATOR_POLICY_GROW,
+    // Grows or shrinks at every collection so that collections take `gc_time_target` of the time,
+    // as predicted from the pause, the survival rate and the allocation rate of the last one.
+    ALLOCATOR_POLICY_ADAPTIVE,
+} ObjectAllocator_HeapPolicy;
+
+// When the objects a collection found unreachable are freed.
+typedef enum {
+    // A few at every allocation after the collection, the rest at the start of the next one.
+    ALLOCATOR_SWEEP_LAZY,
+    // All of them during the collection.
+    ALLOCATOR_SWEEP_EAGER,
+    // On a thread of the allocator's own, while the program runs; dead handles are still
+    // released on the VM's thread. Falls back to lazy sweeping if the thread cannot start.
+    ALLOCATOR_SWEEP_BACKGROUND,
+} ObjectAllocator_SweepMode;
+
 struct Stack;
+struct Tasks;
 struct Parser_ExpressionsStack;
 
 typedef struct {
     struct Stack *stack;
+    struct Tasks *tasks;
     struct Parser_ExpressionsStack *parser_stack;
     Object **parser_expr;
     Object **globals;
     Object **value;
     Object **error;
     Object **exprs;
+    Object **module_forms;
 } ObjectAllocator_Roots;
 
+// Pause times are counted on a log-linear scale: four buckets per power of two nanoseconds.
+#define ALLOCATOR_PAUSE_BUCKETS 160
+
+typedef struct {
+    size_t objects;
+    size_t bytes;
+} ObjectAllocator_Counts;
+
+typedef struct {
+    size_t collections;
+    uint64_t pause_ns_total;
+    uint64_t pause_ns_max;
+    size_t pause_buckets[ALLOCATOR_PAUSE_BUCKETS];
+    ObjectAllocator_Counts allocated[TYPE_HANDLE + 1];
+    ObjectAllocator_Counts freed[TYPE_HANDLE + 1];
+    // The heap size after the last collection, and the largest one.
+    size_t live_bytes;
+    size_t live_bytes_max;
+    size_t soft_limit_changes;
+    // The share of the heap that survived the last collection, in percent.
+    size_t survival_percent;
+    // Times freed memory was returned to the system as the soft limit shrank.
+    size_t heap_trims;
+    // Collections of the nursery, how long they took, and the bytes of the objects they moved to
+    // the heap.
+    size_t nursery_collections;
+    uint64_t nursery_pause_ns_total;
+    uint64_t nursery_pause_ns_max;
+    size_t promoted_bytes;
+    // Times marking ran out of mark stack and rescanned the heap for the objects left gray.
+    size_t mark_stack_overflows;
+    // The largest heap, as seen before a collection or now.
+    size_t heap_bytes_max;
+    // Filled in by `allocator_statistics`.
+    size_t heap_bytes;
+    size_t soft_limit;
+} ObjectAllocator_Statistics;
+
 typedef struct ObjectAllocator ObjectAllocator;
+typedef struct ObjectAllocator_Sweeper ObjectAllocator_Sweeper;
+typedef struct ObjectAllocator_Chunk ObjectAllocator_Chunk;
 
 struct ObjectAllocator {
     Object *_objects;
-    Object *_freed;
+    // What the last collection left to sweep: survivors are black, the rest is garbage.
+    Object *_unswept;
+    ObjectAllocator_SweepMode _sweep_mode;
+    // Started on the first background sweep; `_unswept` is then with it until it is taken back.
+    ObjectAllocator_Sweeper *_sweeper;
+    bool _is_background_sweeping;
+    bool _should_trim;
+    // Bytes the last collection found unreachable and that are not swept yet.
+    size_t _garbage_size;
+    // Null until it is first used; once an object did not fit, the rest go to the heap until it is
+    // collected.
+    ObjectAllocator_Chunk *_nursery;
+    // 0 if the allocator has no nursery.
+    size_t _nursery_size;
+    bool _is_nursery_open;
+    // Bytes of the objects in the nursery.
+    size_t _nursery_bytes;
+    bool _is_nursery_full;
+    // Older objects that may point into the nursery; all of them if one could not be added.
+    Objects _remembered;
+    bool _is_remembered_lost;
+    // Gray objects left to mark, with a capacity fixed when the allocator is made; those that did
+    // not fit are left gray in the heap.
+    Objects _mark_stack;
+    bool _has_mark_stack_overflowed;
     ObjectAllocator_Roots _roots;
     ObjectAllocator_GarbageCollectionMode _gc_mode;
     bool _trace;
     bool _no_free;
     bool _gc_is_running;
+    FILE *_trace_events;
+    bool _has_trace_events;
+    struct Trace *_trace_ring;
     size_t _heap_size;
     size_t _hard_limit;
     size_t _soft_limit;
+    size_t _soft_limit_min;
+    ObjectAllocator_HeapPolicy _policy;
     double _grow_factor;
+    double _gc_time_target;
+    // When the last collection ended, and the bytes allocated since then.
+    uint64_t _mutator_start_ns;
+    size_t _allocated_since_gc;
+    // Bytes left to allocate before the next sample, `SIZE_MAX` unless profiling.
+    size_t _sample_countdown;
+    AllocationProfile _profile;
+    ObjectAllocator_Statistics _statistics;
 };
 
 typedef struct {
     size_t hard_limit;
+    // Also the smallest soft limit of the adaptive policy.
     size_t soft_limit_initial;
+    ObjectAllocator_HeapPolicy policy;
     double soft_limit_grow_factor;
+    // The share of time the adaptive policy aims to spend collecting, 0.05 if 0.
+    double gc_time_target;
+    ObjectAllocator_SweepMode sweep_mode;
+    // The size of the nursery young objects are allocated in, see `allocator_open_nursery`; 0
+    // for none. There is none while profiling allocations or without collections or frees.
+    size_t nursery_size;
+    // Samples an allocation every so many bytes, see `allocation_profile.h`; 0 disables it.
+    size_t profile_sample_bytes;
+    // Records collections, see `vm/trace.h`; null unless tracing.
+    struct Trace *trace;
+    // Receives a Chrome trace event (the JSON array format) for every collection, if not null;
+    // the array is closed by `allocator_free`.
+    FILE *trace_events;
 
     struct {
         ObjectAllocator_GarbageCollectionMode gc_mode;
@@ -55,7 +173,43 @@ void allocator_free(ObjectAllocator *a);
 
 void allocator_set_roots(ObjectAllocator *a, ObjectAllocator_Roots roots);
 
+// Allocates an object of `type`, setting its type.
 [[nodiscard]]
-bool allocator_try_allocate(ObjectAllocator *a, size_t size, Object **obj);
+bool allocator_try_allocate(ObjectAllocator *a, Object_Type type, size_t size, Object **obj);
 
+// While the nursery is open, objects are allocated in it by bumping a pointer, but for handles
+// and large objects. Collecting the nursery moves the objects that survive to the heap and frees
+// the rest at once, so it only happens at safe points, where every object still in use is
+// reachable from the roots; between two of them, objects stay where they are.
+void allocator_open_nursery(ObjectAllocator *a);
+
+// Collects the nursery, which is a safe point, and allocates in the heap until it is opened
+// again.
+void allocator_close_nursery(ObjectAllocator *a);
+
+// Collects the nursery if it is nearly full, or at every safe point with `ALLOCATOR_ALWAYS_GC`.
+void allocator_safepoint(ObjectAllocator *a);
+
+// The write barrier: call it after storing in `obj` a pointer to an object that may be younger,
+// unless `obj` was allocated since the last safe point.
+void allocator_note_write(ObjectAllocator *a, Object *obj);
+
+// Finishes sweeping, so that the heap only holds live objects until the next allocation.
+void allocator_finish_sweep(ObjectAllocator *a);
+
+// Finishes sweeping and stops the background sweeper, which the next background sweep starts
+// again.
+void allocator_stop_sweeper(ObjectAllocator *a);
+
+// Finishes sweeping first.
 void allocator_print_statistics(ObjectAllocator *a, FILE *file);
+
+// Finishes sweeping first.
+ObjectAllocator_Statistics allocator_statistics(ObjectAllocator *a);
+
+// An upper bound of the pause time of the given share of collections (0.5 for the median).
+uint64_t allocator_pause_percentile_ns(ObjectAllocator_Statistics const *statistics, double percentile);
+
+// Writes the allocation profile; the allocator must have been made with `profile_sample_bytes`.
+[[nodiscard]]
+bool allocator_try_write_profile(ObjectAllocator *a, FILE *file, errno_t *error_code);
@@ -73,6 +73,13 @@ Object_CompareResult object_compare(Object *a, Object *b) { // NOLINT(*-no-recur
         case TYPE_MACRO: {
             return compare_closure(a->as_closure, b->as_closure);
         }
+        case TYPE_HANDLE: {
+            if (a->as_handle.data == b->as_handle.data) {
+                return OBJECT_EQUALS;
+            }
+
+            return (uintptr_t) a->as_handle.data > (uintptr_t) b->as_handle.data ? OBJECT_GREATER : OBJECT_LESS;
+        }
     }
 
     guard_unreachable();
@@ -38,15 +38,18 @@ static size_t size_dict(void) {
     return object_offsetof_end(as_dict);
 }
 
+static size_t size_handle(void) {
+    return object_offsetof_end(as_handle);
+}
+
 bool object_try_make_int(ObjectAllocator *a, int64_t value, Object **obj) {
     guard_is_not_null(a);
     guard_is_not_null(obj);
 
-    if (false == allocator_try_allocate(a, size_int(), obj)) {
+    if (false == allocator_try_allocate(a, TYPE_INT, size_int(), obj)) {
         return false;
     }
 
-    (*obj)->type = TYPE_INT;
     (*obj)->as_int = value;
     return true;
 }
@@ -57,14 +60,13 @@ bool object_try_make_string(ObjectAllocator *a, char const *s, Object **obj) {
     guard_is_not_null(obj);
 
     auto const len = strlen(s);
-    if (false == allocator_try_allocate(a, size_string(len), obj)) {
+    if (false == allocator_try_allocate(a, TYPE_STRING, size_string(len), obj)) {
         return false;
     }
 
     auto const chars = (((uint8_t *) *obj) + object_offsetof_end(as_string));
     guard_is_less_or_equal(chars + len + 1, ((uint8_t *) *obj) + (*obj)->size);
 
-    (*obj)->type = TYPE_STRING;
     (*obj)->as_string = (char *) chars;
     memcpy(chars, s, len + 1);
 
@@ -77,14 +79,13 @@ bool object_try_make_symbol(ObjectAllocator *a, char const *s, Object **obj) {
     guard_is_not_null(obj);
 
     auto const len = strlen(s);
-    if (false == allocator_try_allocate(a, size_symbol(len), obj)) {
+    if (false == allocator_try_allocate(a, TYPE_SYMBOL, size_symbol(len), obj)) {
         return false;
     }
 
     auto const chars = (((uint8_t *) *obj) + object_offsetof_end(as_symbol));
     guard_is_less_or_equal(chars + len + 1, ((uint8_t *) *obj) + (*obj)->size);
 
-    (*obj)->type = TYPE_SYMBOL;
     (*obj)->as_symbol = (char *) chars;
     memcpy(chars, s, len + 1);
 
@@ -97,11 +98,10 @@ bool object_try_make_list(ObjectAllocator *a, Object *first, Object *rest, Objec
     guard_is_not_null(rest);
     guard_is_not_null(obj);
 
-    if (false == allocator_try_allocate(a, size_list(), obj)) {
+    if (false == allocator_try_allocate(a, TYPE_LIST, size_list(), obj)) {
         return false;
     }
 
-    (*obj)->type = TYPE_LIST;
     (*obj)->as_list = ((Object_List) {
             .first = first,
             .rest = rest
@@ -113,15 +113,30 @@ bool object_try_make_primitive(ObjectAllocator *a, Object_Primitive fn, Object *
     guard_is_not_null(a);
     guard_is_not_null(obj);
 
-    if (false == allocator_try_allocate(a, size_primitive(), obj)) {
+    if (false == allocator_try_allocate(a, TYPE_PRIMITIVE, size_primitive(), obj)) {
         return false;
     }
 
-    (*obj)->type = TYPE_PRIMITIVE;
     (*obj)->as_primitive = fn;
     return true;
 }
 
+bool object_try_make_handle(ObjectAllocator *a, Object_HandleClass const *class, void *data, Object **obj) {
+    guard_is_not_null(a);
+    guard_is_not_null(class);
+    guard_is_not_null(obj);
+
+    if (false == allocator_try_allocate(a, TYPE_HANDLE, size_handle(), obj)) {
+        return false;
+    }
+
+    (*obj)->as_handle = ((Object_Handle) {
+            .class = class,
+            .data = data
+    });
+    return true;
+}
+
 bool object_try_make_closure(ObjectAllocator *a, Object *env, Object *args, Object *body, Object **obj) {
     guard_is_not_null(a);
     guard_is_not_null(env);
@@ -129,11 +144,10 @@ bool object_try_make_closure(ObjectAllocator *a, Object *env, Object *args, Obje
     guard_is_not_null(body);
     guard_is_not_null(obj);
 
-    if (false == allocator_try_allocate(a, size_closure(), obj)) {
+    if (false == allocator_try_allocate(a, TYPE_CLOSURE, size_closure(), obj)) {
         return false;
     }
 
-    (*obj)->type = TYPE_CLOSURE;
     (*obj)->as_closure = ((Object_Closure) {
             .env = env,
             .args = args,
@@ -149,11 +163,10 @@ bool object_try_make_macro(ObjectAllocator *a, Object *env, Object *args, Object
     guard_is_not_null(body);
     guard_is_not_null(obj);
 
-    if (false == allocator_try_allocate(a, size_closure(), obj)) {
+    if (false == allocator_try_allocate(a, TYPE_MACRO, size_closure(), obj)) {
         return false;
     }
 
-    (*obj)->type = TYPE_MACRO;
     (*obj)->as_closure = ((Object_Closure) {
             .env = env,
             .args = args,
@@ -172,11 +185,10 @@ bool object_try_make_dict(ObjectAllocator *a, Object *key, Object *value, Object
     guard_is_one_of(left->type, TYPE_NIL, TYPE_DICT);
     guard_is_one_of(right->type, TYPE_NIL, TYPE_DICT);
 
-    if (false == allocator_try_allocate(a, size_dict(), obj)) {
+    if (false == allocator_try_allocate(a, TYPE_DICT, size_dict(), obj)) {
         return false;
     }
 
-    (*obj)->type = TYPE_DICT;
     (*obj)->as_dict = ((Object_Dict) {
             .key = key,
             .value = value,
@@ -205,6 +217,7 @@ bool object_try_deep_copy(ObjectAllocator *a, Object *obj, Object **copy) { // N
         case TYPE_STRING:
         case TYPE_SYMBOL:
         case TYPE_PRIMITIVE:
+        case TYPE_HANDLE:
         case TYPE_NIL: {
             return object_try_shallow_copy(a, obj, copy);
         }
@@ -264,7 +277,9 @@ bool object_try_shallow_copy(ObjectAllocator *a, Object *obj, Object **copy) {
         case TYPE_MACRO: {
             return object_try_make_macro(a, obj->as_closure.env, obj->as_closure.args, obj->as_closure.body, copy);
         }
-        case TYPE_NIL: {
+        case TYPE_NIL:
+        case TYPE_HANDLE: {
+            // A handle owns its resource, copies would release it more than once.
             *copy = obj;
             return true;
         }
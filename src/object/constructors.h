@@ -18,6 +18,11 @@ bool object_try_make_list(ObjectAllocator *a, Object *first, Object *rest, Objec
 [[nodiscard]]
 bool object_try_make_primitive(ObjectAllocator *a, Object_Primitive fn, Object **obj);
 
+// On success the handle owns `data`, which is released by `class->release` once the handle
+// is collected.
+[[nodiscard]]
+bool object_try_make_handle(ObjectAllocator *a, Object_HandleClass const *class, void *data, Object **obj);
+
 [[nodiscard]]
 bool object_try_make_closure(ObjectAllocator *a, Object *env, Object *args, Object *body, Object **obj);
 
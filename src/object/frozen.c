@@ -0,0 +1,213 @@
+#include "frozen.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utility/guards.h"
+#include "utility/slice.h"
+#include "transfer.h"
+
+static pthread_mutex_t region_lock = PTHREAD_MUTEX_INITIALIZER;
+static Arena region = {0};
+
+#define object_offsetof_end(Field) offsetof(Object, Field) + sizeof(((Object) {0}).Field)
+
+static size_t aligned(size_t size) {
+    return (size + alignof(Object) - 1) / alignof(Object) * alignof(Object);
+}
+
+static size_t entry_size(Transfer_Message const *message, Transfer_Entry const *entry) {
+    switch (entry->type) {
+        case TYPE_INT: {
+            return aligned(object_offsetof_end(as_int));
+        }
+        case TYPE_STRING:
+        case TYPE_SYMBOL: {
+            return aligned(object_offsetof_end(as_string) + strlen(transfer_entry_chars(message, entry)) + 1);
+        }
+        case TYPE_LIST: {
+            return aligned(object_offsetof_end(as_list));
+        }
+        case TYPE_DICT: {
+            return aligned(object_offsetof_end(as_dict));
+        }
+        case TYPE_PRIMITIVE: {
+            return aligned(object_offsetof_end(as_primitive));
+        }
+        case TYPE_NIL:
+        case TYPE_CLOSURE:
+        case TYPE_MACRO:
+        case TYPE_HANDLE: {
+            guard_unreachable();
+        }
+    }
+
+    guard_unreachable();
+}
+
+// Closures refer to environments that are updated by `define`; handles are released
+// when collected. Neither can live in the region.
+static bool can_freeze(Transfer_Message const *message) {
+    slice_for_v(entry, *message) {
+        if (TYPE_CLOSURE == entry->type || TYPE_MACRO == entry->type || TYPE_HANDLE == entry->type) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static Object *resolve(Object **objects, Transfer_Ref ref) {
+    return transfer_ref_is_entry(ref) ? objects[transfer_ref_index(ref)] : (Object *) ref;
+}
+
+static void init_object(Transfer_Message const *message, Transfer_Entry const *entry, size_t size, Object *obj) {
+    // Smaller than `Object`: only the fields of its type fit.
+    memset(obj, 0, size);
+    obj->size = size;
+    obj->color = OBJECT_IMMORTAL;
+    obj->type = entry->type;
+
+    switch (entry->type) {
+        case TYPE_INT: {
+            obj->as_int = entry->as_int;
+            return;
+        }
+        case TYPE_STRING:
+        case TYPE_SYMBOL: {
+            auto const chars = (char *) obj + object_offsetof_end(as_string);
+            strcpy(chars, transfer_entry_chars(message, entry));
+            obj->as_string = chars;
+            return;
+        }
+        case TYPE_PRIMITIVE: {
+            obj->as_primitive = entry->as_primitive;
+            return;
+        }
+        case TYPE_DICT: {
+            obj->as_dict.height = entry->as_dict.height;
+            obj->as_dict.size = entry->as_dict.size;
+            return;
+        }
+        case TYPE_LIST: {
+            return;
+        }
+        case TYPE_NIL:
+        case TYPE_CLOSURE:
+        case TYPE_MACRO:
+        case TYPE_HANDLE: {
+            guard_unreachable();
+        }
+    }
+
+    guard_unreachable();
+}
+
+static void link_object(Object **objects, Transfer_Entry const *entry, Object *obj) {
+    switch (entry->type) {
+        case TYPE_LIST: {
+            obj->as_list.first = resolve(objects, entry->refs[0]);
+            obj->as_list.rest = resolve(objects, entry->refs[1]);
+            return;
+        }
+        case TYPE_DICT: {
+            obj->as_dict.key = resolve(objects, entry->refs[0]);
+            obj->as_dict.value = resolve(objects, entry->refs[1]);
+            obj->as_dict.left = resolve(objects, entry->refs[2]);
+            obj->as_dict.right = resolve(objects, entry->refs[3]);
+            return;
+        }
+        case TYPE_INT:
+        case TYPE_STRING:
+        case TYPE_SYMBOL:
+        case TYPE_PRIMITIVE: {
+            return;
+        }
+        case TYPE_NIL:
+        case TYPE_CLOSURE:
+        case TYPE_MACRO:
+        case TYPE_HANDLE: {
+            guard_unreachable();
+        }
+    }
+
+    guard_unreachable();
+}
+
+// The graph is flattened by `transfer_try_pack`, which also finds shared objects, and then
+// laid out in a single block of the region.
+static bool try_build(Transfer_Message const *message, Transfer_Ref root, Object **frozen, errno_t *error_code) {
+    errno = 0;
+    auto const objects = (Object **) calloc(message->count, sizeof(Object *));
+    auto const sizes = (size_t *) calloc(message->count, sizeof(size_t));
+    if (nullptr == objects || nullptr == sizes) {
+        *error_code = errno;
+        free(sizes);
+        free(objects);
+        return false;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < message->count; i++) {
+        sizes[i] = entry_size(message, &message->data[i]);
+        total += sizes[i];
+    }
+
+    pthread_mutex_lock(&region_lock);
+    void *block;
+    auto const ok = arena_try_allocate(&region, alignof(Object), total, &block, error_code);
+    pthread_mutex_unlock(&region_lock);
+
+    if (ok) {
+        auto top = (char *) block;
+        for (size_t i = 0; i < message->count; i++) {
+            objects[i] = (Object *) top;
+            init_object(message, &message->data[i], sizes[i], objects[i]);
+            top += sizes[i];
+        }
+
+        for (size_t i = 0; i < message->count; i++) {
+            link_object(objects, &message->data[i], objects[i]);
+        }
+
+        *frozen = resolve(objects, root);
+    }
+
+    free(sizes);
+    free(objects);
+    return ok;
+}
+
+bool frozen_try_freeze(Object *obj, Object **frozen, errno_t *error_code) {
+    guard_is_not_null(obj);
+    guard_is_not_null(frozen);
+    guard_is_not_null(error_code);
+
+    if (OBJECT_IMMORTAL == obj->color) {
+        *frozen = obj;
+        return true;
+    }
+
+    auto message = (Transfer_Message) {0};
+    Transfer_Ref root;
+    auto ok = transfer_try_pack(&message, obj, &root, error_code);
+    if (ok && false == can_freeze(&message)) {
+        *error_code = EINVAL;
+        ok = false;
+    }
+
+    ok = ok && try_build(&message, root, frozen, error_code);
+    transfer_message_free(&message);
+
+    return ok;
+}
+
+Arena_Statistics frozen_statistics(void) {
+    pthread_mutex_lock(&region_lock);
+    auto const statistics = arena_statistics(&region);
+    pthread_mutex_unlock(&region_lock);
+
+    return statistics;
+}
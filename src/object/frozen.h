@@ -0,0 +1,19 @@
+#pragma once
+
+#include <errno.h>
+
+#include "utility/arena.h"
+#include "object.h"
+
+// A process-wide region of immortal objects. Freezing copies an object graph into it once;
+// every VM can then read the copy without copying it again (transfers pass immortal objects
+// by reference) and no collector ever marks or sweeps it. The region lives until the process
+// exits.
+
+// Freezes everything reachable from `obj`; already immortal objects are shared, not copied, but
+// for those of an image.
+// Fails with `EINVAL` if a closure, a macro or a handle is reachable from `obj`.
+[[nodiscard]]
+bool frozen_try_freeze(Object *obj, Object **frozen, errno_t *error_code);
+
+Arena_Statistics frozen_statistics(void);
@@ -0,0 +1,157 @@
+#include "heap_config.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utility/guards.h"
+
+[[nodiscard]]
+static bool try_parse_size(char const *value, size_t *size) {
+    char *end;
+    errno = 0;
+    auto const parsed = strtoull(value, &end, 10);
+    if (0 != errno || end == value || '-' == value[0]) {
+        return false;
+    }
+
+    unsigned long long unit = 1;
+    switch (*end) {
+        case 'K': {
+            unit = 1024ull;
+            end++;
+            break;
+        }
+        case 'M': {
+            unit = 1024ull * 1024;
+            end++;
+            break;
+        }
+        case 'G': {
+            unit = 1024ull * 1024 * 1024;
+            end++;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+    if ('\0' != *end || 0 == parsed || parsed > SIZE_MAX / unit) {
+        return false;
+    }
+
+    *size = (size_t) (parsed * unit);
+    return true;
+}
+
+[[nodiscard]]
+static bool try_parse_double(char const *value, double min, double max, double *result) {
+    char *end;
+    errno = 0;
+    auto const parsed = strtod(value, &end);
+    if (0 != errno || end == value || '\0' != *end || parsed <= min || parsed > max) {
+        return false;
+    }
+
+    *result = parsed;
+    return true;
+}
+
+[[nodiscard]]
+static bool try_set_gc_mode(ObjectAllocator_Config *config, char const *value) {
+    if (0 == strcmp("soft", value)) {
+        config->debug.gc_mode = ALLOCATOR_SOFT_GC;
+        config->debug.no_free = false;
+    } else if (0 == strcmp("always", value)) {
+        config->debug.gc_mode = ALLOCATOR_ALWAYS_GC;
+        config->debug.no_free = false;
+    } else if (0 == strcmp("never", value)) {
+        config->debug.gc_mode = ALLOCATOR_NEVER_GC;
+        config->debug.no_free = false;
+    } else if (0 == strcmp("debug", value)) {
+        config->debug.gc_mode = ALLOCATOR_ALWAYS_GC;
+        config->debug.no_free = true;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+[[nodiscard]]
+static bool try_set_sweep_mode(ObjectAllocator_Config *config, char const *value) {
+    if (0 == strcmp("lazy", value)) {
+        config->sweep_mode = ALLOCATOR_SWEEP_LAZY;
+    } else if (0 == strcmp("eager", value)) {
+        config->sweep_mode = ALLOCATOR_SWEEP_EAGER;
+    } else if (0 == strcmp("background", value)) {
+        config->sweep_mode = ALLOCATOR_SWEEP_BACKGROUND;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool heap_config_try_set(ObjectAllocator_Config *config, char const *name, char const *value) {
+    guard_is_not_null(config);
+    guard_is_not_null(name);
+    guard_is_not_null(value);
+
+    if (0 == strcmp("limit", name)) {
+        return try_parse_size(value, &config->hard_limit);
+    }
+    if (0 == strcmp("initial", name)) {
+        return try_parse_size(value, &config->soft_limit_initial);
+    }
+    if (0 == strcmp("grow", name)) {
+        config->policy = ALLOCATOR_POLICY_GROW;
+        return try_parse_double(value, 0, 1e6, &config->soft_limit_grow_factor);
+    }
+    if (0 == strcmp("gc-target", name)) {
+        config->policy = ALLOCATOR_POLICY_ADAPTIVE;
+        return try_parse_double(value, 0, 1 - 1e-9, &config->gc_time_target);
+    }
+    if (0 == strcmp("gc", name)) {
+        return try_set_gc_mode(config, value);
+    }
+    if (0 == strcmp("sweep", name)) {
+        return try_set_sweep_mode(config, value);
+    }
+    if (0 == strcmp("nursery", name)) {
+        if (0 == strcmp("0", value)) {
+            config->nursery_size = 0;
+            return true;
+        }
+        return try_parse_size(value, &config->nursery_size);
+    }
+
+    return false;
+}
+
+bool heap_config_try_read_environment(ObjectAllocator_Config *config, char const **variable) {
+    guard_is_not_null(config);
+    guard_is_not_null(variable);
+
+    static struct {
+        char const *name;
+        char const *variable;
+    } const SETTINGS[] = {
+            {"limit",     "PERSIMMON_HEAP_LIMIT"},
+            {"initial",   "PERSIMMON_HEAP_INITIAL"},
+            {"grow",      "PERSIMMON_HEAP_GROW"},
+            {"gc-target", "PERSIMMON_HEAP_GC_TARGET"},
+            {"gc",        "PERSIMMON_HEAP_GC"},
+            {"sweep",     "PERSIMMON_HEAP_SWEEP"},
+            {"nursery",   "PERSIMMON_HEAP_NURSERY"},
+    };
+    for (size_t i = 0; i < sizeof(SETTINGS) / sizeof(SETTINGS[0]); i++) {
+        auto const value = getenv(SETTINGS[i].variable);
+        if (nullptr != value && false == heap_config_try_set(config, SETTINGS[i].name, value)) {
+            *variable = SETTINGS[i].variable;
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "allocator.h"
+
+// Heap settings given at run time, each named `NAME` in option `--heap-NAME VALUE` and
+// environment variable `PERSIMMON_HEAP_NAME` (upper case, `_` for `-`):
+//   - `limit` SIZE, the hard limit;
+//   - `initial` SIZE, the initial soft limit, also the smallest the adaptive policy sets;
+//   - `grow` FACTOR, grows the soft limit by FACTOR at every collection;
+//   - `gc-target` SHARE, adapts the soft limit to spend SHARE (between 0 and 1) of the time
+//     collecting, see `ALLOCATOR_POLICY_ADAPTIVE`;
+//   - `gc` MODE, `soft` (collect as the heap outgrows its soft limit), `always` (before every
+//     allocation), `never`, or `debug`: `always`, and freed objects are kept to catch their use;
+//   - `sweep` MODE, `lazy`, `eager` or `background`, see `ObjectAllocator_SweepMode`;
+//   - `nursery` SIZE, 0 for none, see `allocator_open_nursery`.
+// Sizes are bytes, or KiB, MiB and GiB with a `K`, `M` or `G` suffix.
+
+// Applies setting `name`; fails if there is no such setting or `value` is not valid for it.
+[[nodiscard]]
+bool heap_config_try_set(ObjectAllocator_Config *config, char const *name, char const *value);
+
+// Applies the settings found in the environment; on failure, `variable` is the first one that
+// is not valid.
+[[nodiscard]]
+bool heap_config_try_read_environment(ObjectAllocator_Config *config, char const **variable);
@@ -23,11 +23,20 @@ bool object_list_try_append_inplace(ObjectAllocator *a, Object *value, Object **
     guard_is_not_null(*list);
     guard_is_one_of((*list)->type, TYPE_NIL, TYPE_LIST);
 
+    Object *last = nullptr;
     while (OBJECT_NIL != *list) {
+        last = *list;
         list = (Object **) &(*list)->as_list.rest;
     }
 
-    return object_try_make_list(a, value, OBJECT_NIL, list);
+    if (false == object_try_make_list(a, value, OBJECT_NIL, list)) {
+        return false;
+    }
+
+    if (nullptr != last) {
+        allocator_note_write(a, last);
+    }
+    return true;
 }
 
 void object_list_concat_inplace(Object **head, Object *tail) {
@@ -66,7 +75,8 @@ Object *object_list_shift(Object **list) {
     guard_is_equal((*list)->type, TYPE_LIST);
 
     Object *head;
-    guard_is_true(try_shift(list, &head));
+    auto const is_shifted = try_shift(list, &head);
+    guard_is_true(is_shifted);
     return head;
 }
 
@@ -142,7 +152,7 @@ Object **object_list_nth_mutable(size_t n, Object *list) {
         return &it->as_list.first;
     }
 
-    guard_assert(false, "list index %zu is out of range for prim_list_list of %zu elements", n, i);
+    guard_unreachable("list index %zu is out of range for prim_list_list of %zu elements", n, i);
 }
 
 Object **object_list_end_mutable(Object **list) {
@@ -177,7 +187,7 @@ Object *object_list_skip(size_t n, Object *list) {
         return OBJECT_NIL;
     }
 
-    guard_assert(false, "cannot skip %zu elements for prim_list_list of %zu elements", n, i);
+    guard_unreachable("cannot skip %zu elements for prim_list_list of %zu elements", n, i);
 }
 
 bool object_list_try_unpack_2(Object **_1, Object **_2, Object *list) {
@@ -28,6 +28,9 @@ char const *object_type_str(Object_Type type) {
         case TYPE_MACRO: {
             return "macro";
         }
+        case TYPE_HANDLE: {
+            return "handle";
+        }
         case TYPE_NIL: {
             return "nil";
         }
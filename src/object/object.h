@@ -15,6 +15,7 @@ typedef enum {
     TYPE_PRIMITIVE,
     TYPE_CLOSURE,
     TYPE_MACRO,
+    TYPE_HANDLE,
 } Object_Type;
 
 char const *object_type_str(Object_Type type);
@@ -23,6 +24,9 @@ typedef struct Object Object;
 
 extern Object *const OBJECT_NIL;
 
+// The object `OBJECT_NIL` points to, for static initializers in other translation units.
+extern Object OBJECT_NIL_STORAGE;
+
 extern Object *const OBJECT_TRUE;
 
 typedef struct {
@@ -40,6 +44,22 @@ typedef struct {
     Object *body;
 } Object_Closure;
 
+// Describes a kind of native resource wrapped by a handle object.
+typedef struct {
+    // The name reported by `type` and `repr`.
+    char const *name;
+    // Called once the handle is collected or its heap is freed.
+    void (*release)(void *data);
+    // Takes another reference to `data` for a copy of the handle in another VM (see
+    // `object/transfer.h`); handles of classes without it stay in the VM that made them.
+    void (*retain)(void *data);
+} Object_HandleClass;
+
+typedef struct {
+    Object_HandleClass const *class;
+    void *data;
+} Object_Handle;
+
 typedef struct {
     Object *key;
     Object *value;
@@ -52,7 +72,14 @@ typedef struct {
 typedef enum {
     OBJECT_WHITE,
     OBJECT_GRAY,
-    OBJECT_BLACK
+    OBJECT_BLACK,
+    // Objects outside the GC-managed heap (static objects, the prelude, frozen objects): never
+    // marked, traversed or swept, so they are never written to and can be shared by VMs running
+    // on different threads; they may only point to objects that are kept alive otherwise.
+    OBJECT_IMMORTAL,
+    // Objects loaded from an image: immortal, but they belong to the VM that loaded them, whose
+    // globals they may point to, so they are copied rather than shared with other VMs.
+    OBJECT_IMAGE
 } Object_Color;
 
 struct Object {
@@ -70,6 +97,7 @@ struct Object {
         Object_Primitive as_primitive;
         Object_Closure as_closure;
         Object_Dict as_dict;
+        Object_Handle as_handle;
     };
 };
 
@@ -40,7 +40,7 @@ static bool dict_try_write_repr_(Writer w, Object *obj, bool *is_min, errno_t *e
         return false;
     }
 
-    if (false == *is_min && false == writer_try_printf(w, error_code, ", ")) {
+    if (false == *is_min && false == writer_try_append_str(w, ", ", error_code)) {
         return false;
     }
 
@@ -49,7 +49,7 @@ static bool dict_try_write_repr_(Writer w, Object *obj, bool *is_min, errno_t *e
     }
 
     return object_try_write_repr(w, obj->as_dict.key, error_code)
-           && writer_try_printf(w, error_code, " ")
+           && writer_try_append_char(w, ' ', error_code)
            && object_try_write_repr(w, obj->as_dict.value, error_code)
            && dict_try_write_repr_(w, obj->as_dict.right, is_min, error_code);
 }
@@ -68,22 +68,25 @@ static bool object_try_write_repr(Writer w, Object *obj, errno_t *error_code) {
             return writer_try_printf(w, error_code, "%" PRId64, obj->as_int);
         }
         case TYPE_STRING: {
-            if (false == writer_try_printf(w, error_code, "\"")) {
+            if (false == writer_try_append_char(w, '"', error_code)) {
                 return false;
             }
 
+            auto run = obj->as_string;
             string_for(it, obj->as_string) {
                 char const *escape_sequence;
-                if (string_try_repr_escape_seq(*it, &escape_sequence)) {
-                    if (false == writer_try_printf(w, error_code, "%s", escape_sequence)) {
-                        return false;
-                    }
-
+                auto const has_escape_sequence = string_try_repr_escape_seq(*it, &escape_sequence);
+                if (false == has_escape_sequence && isprint(*it)) {
                     continue;
                 }
 
-                if (isprint(*it)) {
-                    if (false == writer_try_printf(w, error_code, "%c", *it)) {
+                if (false == writer_try_append_bytes(w, run, it - run, error_code)) {
+                    return false;
+                }
+                run = it + 1;
+
+                if (has_escape_sequence) {
+                    if (false == writer_try_append_str(w, escape_sequence, error_code)) {
                         return false;
                     }
 
@@ -95,19 +98,20 @@ static bool object_try_write_repr(Writer w, Object *obj, errno_t *error_code) {
                 }
             }
 
-            return writer_try_printf(w, error_code, "\"");
+            return writer_try_append_str(w, run, error_code)
+                   && writer_try_append_char(w, '"', error_code);
         }
         case TYPE_SYMBOL: {
-            return writer_try_printf(w, error_code, "%s", obj->as_symbol);
+            return writer_try_append_str(w, obj->as_symbol, error_code);
         }
         case TYPE_LIST: {
             Object *quoted;
             if (is_quote(obj, &quoted)) {
-                return writer_try_printf(w, error_code, "'")
+                return writer_try_append_char(w, '\'', error_code)
                        && object_try_write_repr(w, quoted, error_code);
             }
 
-            if (false == writer_try_printf(w, error_code, "(")) {
+            if (false == writer_try_append_char(w, '(', error_code)) {
                 return false;
             }
 
@@ -116,7 +120,7 @@ static bool object_try_write_repr(Writer w, Object *obj, errno_t *error_code) {
             }
 
             object_list_for(it, obj->as_list.rest) {
-                if (false == writer_try_printf(w, error_code, " ")) {
+                if (false == writer_try_append_char(w, ' ', error_code)) {
                     return false;
                 }
 
@@ -125,21 +129,24 @@ static bool object_try_write_repr(Writer w, Object *obj, errno_t *error_code) {
                 }
             }
 
-            return writer_try_printf(w, error_code, ")");
+            return writer_try_append_char(w, ')', error_code);
         }
         case TYPE_DICT: {
-            return writer_try_printf(w, error_code, "{")
+            return writer_try_append_char(w, '{', error_code)
                    && dict_try_write_repr(w, obj, error_code)
-                   && writer_try_printf(w, error_code, "}");
+                   && writer_try_append_char(w, '}', error_code);
         }
         case TYPE_NIL: {
-            return writer_try_printf(w, error_code, "()");
+            return writer_try_append_str(w, "()", error_code);
         }
         case TYPE_PRIMITIVE:
         case TYPE_CLOSURE:
         case TYPE_MACRO: {
             return writer_try_printf(w, error_code, "<%s>", object_type_str(obj->type));
         }
+        case TYPE_HANDLE: {
+            return writer_try_printf(w, error_code, "<%s>", obj->as_handle.class->name);
+        }
     }
 
     guard_unreachable();
@@ -151,7 +158,7 @@ static bool object_try_write_str(Writer w, Object *obj, errno_t *error_code) {
 
     switch (obj->type) {
         case TYPE_STRING: {
-            return writer_try_printf(w, error_code, "%s", obj->as_string);
+            return writer_try_append_str(w, obj->as_string, error_code);
         }
         case TYPE_INT:
         case TYPE_SYMBOL:
@@ -160,7 +167,8 @@ static bool object_try_write_str(Writer w, Object *obj, errno_t *error_code) {
         case TYPE_NIL:
         case TYPE_PRIMITIVE:
         case TYPE_CLOSURE:
-        case TYPE_MACRO: {
+        case TYPE_MACRO:
+        case TYPE_HANDLE: {
             return object_try_write_repr(w, obj, error_code);
         }
     }
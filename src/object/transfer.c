@@ -0,0 +1,484 @@
+#include "transfer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utility/guards.h"
+#include "utility/dynamic_array.h"
+#include "utility/slice.h"
+#include "constructors.h"
+
+#define TRANSFER_INDEX_TAG 1
+
+typedef struct {
+    Transfer_Slot *data;
+    size_t count;
+    size_t capacity;
+} Transfer_Pending;
+
+static Transfer_Ref ref_of_index(size_t index) {
+    return (Transfer_Ref) index << 1 | TRANSFER_INDEX_TAG;
+}
+
+static bool ref_is_index(Transfer_Ref ref) {
+    return TRANSFER_INDEX_TAG == (ref & TRANSFER_INDEX_TAG);
+}
+
+static size_t ref_index(Transfer_Ref ref) {
+    return (size_t) (ref >> 1);
+}
+
+static size_t slot_index(Transfer_Message const *m, Object *key) {
+    auto const hash = ((uint64_t) (uintptr_t) key >> 3) * 0x9e3779b97f4a7c15;
+    return (size_t) (hash >> 32) & (m->_slots_capacity - 1);
+}
+
+static Transfer_Slot *slot_find(Transfer_Message const *m, Object *key) {
+    auto index = slot_index(m, key);
+    while (nullptr != m->_slots[index].key && key != m->_slots[index].key) {
+        index = (index + 1) & (m->_slots_capacity - 1);
+    }
+
+    return &m->_slots[index];
+}
+
+static bool slots_try_grow(Transfer_Message *m, errno_t *error_code) {
+    auto const capacity = 0 == m->_slots_capacity ? 16 : m->_slots_capacity * 2;
+
+    errno = 0;
+    auto const slots = (Transfer_Slot *) calloc(capacity, sizeof(Transfer_Slot));
+    if (nullptr == slots) {
+        *error_code = errno;
+        return false;
+    }
+
+    auto const old_slots = m->_slots;
+    auto const old_capacity = m->_slots_capacity;
+    m->_slots = slots;
+    m->_slots_capacity = capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (nullptr != old_slots[i].key) {
+            *slot_find(m, old_slots[i].key) = old_slots[i];
+        }
+    }
+    free(old_slots);
+
+    return true;
+}
+
+static bool try_make_entry(Transfer_Message *m, Object *obj, Transfer_Entry *entry, errno_t *error_code) {
+    *entry = (Transfer_Entry) {.type = obj->type};
+
+    switch (obj->type) {
+        case TYPE_INT: {
+            entry->as_int = obj->as_int;
+            return true;
+        }
+        case TYPE_STRING:
+        case TYPE_SYMBOL: {
+            entry->as_chars = m->_chars.length;
+            return sb_try_append_bytes(&m->_chars, error_code, obj->as_string, strlen(obj->as_string) + 1);
+        }
+        case TYPE_PRIMITIVE: {
+            entry->as_primitive = obj->as_primitive;
+            return true;
+        }
+        case TYPE_DICT: {
+            entry->as_dict.height = obj->as_dict.height;
+            entry->as_dict.size = obj->as_dict.size;
+            return true;
+        }
+        case TYPE_LIST:
+        case TYPE_CLOSURE:
+        case TYPE_MACRO: {
+            return true;
+        }
+        case TYPE_HANDLE: {
+            if (nullptr == obj->as_handle.class->retain) {
+                *error_code = EINVAL;
+                return false;
+            }
+
+            entry->as_handle = obj->as_handle;
+            return true;
+        }
+        case TYPE_NIL: {
+            guard_unreachable();
+        }
+    }
+
+    guard_unreachable();
+}
+
+static bool try_reserve_slot(Transfer_Message *m, errno_t *error_code) {
+    return 2 * (m->_slots_count + 1) <= m->_slots_capacity || slots_try_grow(m, error_code);
+}
+
+static bool try_ref(
+        Transfer_Message *m,
+        Transfer_Pending *pending,
+        Object *obj,
+        Transfer_Ref *ref,
+        errno_t *error_code
+) {
+    if (OBJECT_IMMORTAL == obj->color) {
+        *ref = (Transfer_Ref) obj;
+        return true;
+    }
+
+    if (false == try_reserve_slot(m, error_code)) {
+        return false;
+    }
+
+    auto const slot = slot_find(m, obj);
+    if (nullptr != slot->key) {
+        *ref = ref_of_index(slot->index);
+        return true;
+    }
+
+    Transfer_Entry entry;
+    if (false == try_make_entry(m, obj, &entry, error_code)) {
+        return false;
+    }
+
+    auto const index = m->count;
+    if (false == da_try_append(m, entry) || false == da_try_append(pending, ((Transfer_Slot) {obj, index}))) {
+        *error_code = errno;
+        return false;
+    }
+
+    *slot = (Transfer_Slot) {.key = obj, .index = index};
+    m->_slots_count++;
+
+    if (TYPE_HANDLE == obj->type) {
+        obj->as_handle.class->retain(obj->as_handle.data);
+    }
+
+    *ref = ref_of_index(index);
+    return true;
+}
+
+static bool try_ref_children(Transfer_Message *m, Transfer_Pending *pending, Transfer_Slot packed, errno_t *error_code) {
+    Object *children[4] = {0};
+    auto const obj = packed.key;
+
+    switch (obj->type) {
+        case TYPE_LIST: {
+            children[0] = obj->as_list.first;
+            children[1] = obj->as_list.rest;
+            break;
+        }
+        case TYPE_CLOSURE:
+        case TYPE_MACRO: {
+            children[0] = obj->as_closure.env;
+            children[1] = obj->as_closure.args;
+            children[2] = obj->as_closure.body;
+            break;
+        }
+        case TYPE_DICT: {
+            children[0] = obj->as_dict.key;
+            children[1] = obj->as_dict.value;
+            children[2] = obj->as_dict.left;
+            children[3] = obj->as_dict.right;
+            break;
+        }
+        case TYPE_INT:
+        case TYPE_STRING:
+        case TYPE_SYMBOL:
+        case TYPE_PRIMITIVE:
+        case TYPE_HANDLE: {
+            return true;
+        }
+        case TYPE_NIL: {
+            guard_unreachable();
+        }
+    }
+
+    for (size_t i = 0; i < 4 && nullptr != children[i]; i++) {
+        Transfer_Ref ref;
+        if (false == try_ref(m, pending, children[i], &ref, error_code)) {
+            return false;
+        }
+
+        // `try_ref` may have moved the entries.
+        m->data[packed.index].refs[i] = ref;
+    }
+
+    return true;
+}
+
+bool transfer_try_pack(Transfer_Message *message, Object *obj, Transfer_Ref *ref, errno_t *error_code) {
+    guard_is_not_null(message);
+    guard_is_not_null(obj);
+    guard_is_not_null(ref);
+    guard_is_not_null(error_code);
+
+    auto pending = (Transfer_Pending) {0};
+    auto ok = try_ref(message, &pending, obj, ref, error_code);
+
+    Transfer_Slot packed;
+    while (ok && slice_try_pop(&pending, &packed)) {
+        ok = try_ref_children(message, &pending, packed, error_code);
+    }
+
+    da_free(&pending);
+    return ok;
+}
+
+bool transfer_try_refer(Transfer_Message *message, Object *obj, Transfer_Ref *ref, errno_t *error_code) {
+    guard_is_not_null(message);
+    guard_is_not_null(obj);
+    guard_is_not_null(ref);
+    guard_is_not_null(error_code);
+    guard_is_not_equal(obj->color, OBJECT_IMMORTAL);
+
+    if (false == try_reserve_slot(message, error_code)) {
+        return false;
+    }
+
+    auto const slot = slot_find(message, obj);
+    guard_is_equal(slot->key, nullptr);
+
+    auto const index = message->count;
+    if (false == da_try_append(message, ((Transfer_Entry) {.type = TYPE_NIL}))) {
+        *error_code = errno;
+        return false;
+    }
+
+    *slot = (Transfer_Slot) {.key = obj, .index = index};
+    message->_slots_count++;
+
+    *ref = ref_of_index(index);
+    return true;
+}
+
+void transfer_message_free(Transfer_Message *message) {
+    guard_is_not_null(message);
+
+    slice_for_v(entry, *message) {
+        if (TYPE_HANDLE == entry->type) {
+            entry->as_handle.class->release(entry->as_handle.data);
+        }
+    }
+
+    free(message->data);
+    free(message->_slots);
+    sb_free(&message->_chars);
+
+    *message = (Transfer_Message) {0};
+}
+
+bool transfer_ref_is_entry(Transfer_Ref ref) {
+    return ref_is_index(ref);
+}
+
+size_t transfer_ref_index(Transfer_Ref ref) {
+    guard_is_true(ref_is_index(ref));
+
+    return ref_index(ref);
+}
+
+Transfer_Ref transfer_entry_ref(size_t index) {
+    return ref_of_index(index);
+}
+
+char const *transfer_entry_chars(Transfer_Message const *message, Transfer_Entry const *entry) {
+    guard_is_not_null(message);
+    guard_is_not_null(entry);
+    guard_is_one_of(entry->type, TYPE_STRING, TYPE_SYMBOL);
+
+    return message->_chars.str + entry->as_chars;
+}
+
+bool transfer_unpacker_try_init(Transfer_Unpacker *u, Transfer_Message const *message, errno_t *error_code) {
+    guard_is_not_null(u);
+    guard_is_not_null(message);
+    guard_is_not_null(error_code);
+
+    // Every entry is unpacked at most once, so it is pending at most once.
+    errno = 0;
+    *u = (Transfer_Unpacker) {
+            ._message = message,
+            ._objects = (Object **) calloc(message->count + 1, sizeof(Object *)),
+            ._pending = (size_t *) calloc(message->count + 1, sizeof(size_t)),
+            ._unpacked = (size_t *) calloc(message->count + 1, sizeof(size_t))
+    };
+    if (nullptr == u->_objects || nullptr == u->_pending || nullptr == u->_unpacked) {
+        *error_code = errno;
+        transfer_unpacker_free(u);
+        return false;
+    }
+
+    return true;
+}
+
+void transfer_unpacker_free(Transfer_Unpacker *u) {
+    guard_is_not_null(u);
+
+    free(u->_objects);
+    free(u->_pending);
+    free(u->_unpacked);
+
+    *u = (Transfer_Unpacker) {0};
+}
+
+static bool try_make_object(Transfer_Unpacker const *u, ObjectAllocator *a, Transfer_Entry const *entry, Object **obj) {
+    auto const nil = OBJECT_NIL;
+
+    switch (entry->type) {
+        case TYPE_INT: {
+            return object_try_make_int(a, entry->as_int, obj);
+        }
+        case TYPE_STRING: {
+            return object_try_make_string(a, u->_message->_chars.str + entry->as_chars, obj);
+        }
+        case TYPE_SYMBOL: {
+            return object_try_make_symbol(a, u->_message->_chars.str + entry->as_chars, obj);
+        }
+        case TYPE_PRIMITIVE: {
+            return object_try_make_primitive(a, entry->as_primitive, obj);
+        }
+        case TYPE_LIST: {
+            return object_try_make_list(a, nil, nil, obj);
+        }
+        case TYPE_CLOSURE: {
+            return object_try_make_closure(a, nil, nil, nil, obj);
+        }
+        case TYPE_MACRO: {
+            return object_try_make_macro(a, nil, nil, nil, obj);
+        }
+        case TYPE_DICT: {
+            if (false == object_try_make_dict(a, nil, nil, nil, nil, obj)) {
+                return false;
+            }
+
+            (*obj)->as_dict.height = entry->as_dict.height;
+            (*obj)->as_dict.size = entry->as_dict.size;
+            return true;
+        }
+        case TYPE_HANDLE: {
+            auto const handle = entry->as_handle;
+            if (false == object_try_make_handle(a, handle.class, handle.data, obj)) {
+                return false;
+            }
+
+            handle.class->retain(handle.data);
+            return true;
+        }
+        case TYPE_NIL: {
+            guard_unreachable();
+        }
+    }
+
+    guard_unreachable();
+}
+
+// Children are created directly in the fields of their already reachable parents,
+// so that nothing is collected half-built.
+static bool try_resolve(Transfer_Unpacker *u, ObjectAllocator *a, Transfer_Ref ref, Object **slot) {
+    if (false == ref_is_index(ref)) {
+        *slot = (Object *) ref;
+        return true;
+    }
+
+    auto const index = ref_index(ref);
+    guard_is_less(index, u->_message->count);
+
+    if (nullptr != u->_objects[index]) {
+        *slot = u->_objects[index];
+        return true;
+    }
+
+    if (false == try_make_object(u, a, &u->_message->data[index], slot)) {
+        return false;
+    }
+
+    u->_objects[index] = *slot;
+    u->_pending[u->_pending_count++] = index;
+    u->_unpacked[u->_unpacked_count++] = index;
+    return true;
+}
+
+static bool try_resolve_children(Transfer_Unpacker *u, ObjectAllocator *a, size_t index) {
+    auto const obj = u->_objects[index];
+    auto const refs = u->_message->data[index].refs;
+
+    switch (obj->type) {
+        case TYPE_LIST: {
+            return try_resolve(u, a, refs[0], &obj->as_list.first)
+                   && try_resolve(u, a, refs[1], &obj->as_list.rest);
+        }
+        case TYPE_CLOSURE:
+        case TYPE_MACRO: {
+            return try_resolve(u, a, refs[0], &obj->as_closure.env)
+                   && try_resolve(u, a, refs[1], &obj->as_closure.args)
+                   && try_resolve(u, a, refs[2], &obj->as_closure.body);
+        }
+        case TYPE_DICT: {
+            return try_resolve(u, a, refs[0], &obj->as_dict.key)
+                   && try_resolve(u, a, refs[1], &obj->as_dict.value)
+                   && try_resolve(u, a, refs[2], &obj->as_dict.left)
+                   && try_resolve(u, a, refs[3], &obj->as_dict.right);
+        }
+        case TYPE_INT:
+        case TYPE_STRING:
+        case TYPE_SYMBOL:
+        case TYPE_PRIMITIVE:
+        case TYPE_HANDLE: {
+            return true;
+        }
+        case TYPE_NIL: {
+            guard_unreachable();
+        }
+    }
+
+    guard_unreachable();
+}
+
+bool transfer_try_unpack(Transfer_Unpacker *u, ObjectAllocator *a, Transfer_Ref ref, Object **slot, errno_t *error_code) {
+    guard_is_not_null(u);
+    guard_is_not_null(a);
+    guard_is_not_null(slot);
+    guard_is_not_null(error_code);
+
+    if (false == try_resolve(u, a, ref, slot)) {
+        *error_code = ENOMEM;
+        return false;
+    }
+
+    while (u->_pending_count > 0) {
+        if (false == try_resolve_children(u, a, u->_pending[--u->_pending_count])) {
+            *error_code = ENOMEM;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void transfer_unpacker_provide(Transfer_Unpacker *u, Transfer_Ref ref, Object *obj) {
+    guard_is_not_null(u);
+    guard_is_not_null(obj);
+
+    auto const index = transfer_ref_index(ref);
+    guard_is_less(index, u->_message->count);
+    guard_is_equal(u->_message->data[index].type, TYPE_NIL);
+
+    u->_objects[index] = obj;
+}
+
+size_t transfer_unpacker_checkpoint(Transfer_Unpacker const *u) {
+    guard_is_not_null(u);
+
+    return u->_unpacked_count;
+}
+
+void transfer_unpacker_forget(Transfer_Unpacker *u, size_t checkpoint) {
+    guard_is_not_null(u);
+    guard_is_less_or_equal(checkpoint, u->_unpacked_count);
+
+    for (; u->_unpacked_count > checkpoint; u->_unpacked_count--) {
+        u->_objects[u->_unpacked[u->_unpacked_count - 1]] = nullptr;
+    }
+    u->_pending_count = 0;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utility/string_builder.h"
+#include "allocator.h"
+#include "object.h"
+
+// Moves object graphs between heaps, possibly owned by VMs on different threads.
+// Packing flattens everything reachable from an object into a message that shares nothing
+// with the source heap; unpacking rebuilds it in another heap. Immortal objects are referred
+// to rather than copied, but for those of an image (see `OBJECT_IMAGE`). Shared objects and
+// cycles (through closure environments) are preserved. An object can also be left out, and
+// stand for one the unpacker provides, see `transfer_try_refer`.
+// Handles are moved only if their class can retain them: the copy refers to the same resource.
+
+// An immortal object or, with the lowest bit set, the index of an entry of the message.
+typedef uintptr_t Transfer_Ref;
+
+typedef struct {
+    // `TYPE_NIL` for an object the unpacker provides.
+    Object_Type type;
+
+    union {
+        int64_t as_int;
+        // Offset of the characters of a string or a symbol in the message.
+        size_t as_chars;
+        Object_Primitive as_primitive;
+        // Retained by the message.
+        Object_Handle as_handle;
+
+        struct {
+            int64_t height;
+            size_t size;
+        } as_dict;
+    };
+
+    Transfer_Ref refs[4];
+} Transfer_Entry;
+
+typedef struct {
+    Object *key;
+    size_t index;
+} Transfer_Slot;
+
+typedef struct {
+    Transfer_Entry *data;
+    size_t count;
+    size_t capacity;
+
+    StringBuilder _chars;
+    // Open-addressing map from packed objects to their entries.
+    Transfer_Slot *_slots;
+    size_t _slots_count;
+    size_t _slots_capacity;
+} Transfer_Message;
+
+// Adds `obj` to the message; objects packed by previous calls are shared.
+// Fails with `EINVAL` if a handle that can not be retained is reachable from `obj`.
+[[nodiscard]]
+bool transfer_try_pack(Transfer_Message *message, Object *obj, Transfer_Ref *ref, errno_t *error_code);
+
+// Adds an entry for `obj`, which must not be packed yet, without its children: it is packed as a
+// reference to the object the unpacker provides for it, see `transfer_unpacker_provide`.
+[[nodiscard]]
+bool transfer_try_refer(Transfer_Message *message, Object *obj, Transfer_Ref *ref, errno_t *error_code);
+
+void transfer_message_free(Transfer_Message *message);
+
+// Whether `ref` refers to an entry of its message rather than to an immortal object.
+bool transfer_ref_is_entry(Transfer_Ref ref);
+
+size_t transfer_ref_index(Transfer_Ref ref);
+
+Transfer_Ref transfer_entry_ref(size_t index);
+
+// The characters of a string or symbol entry.
+char const *transfer_entry_chars(Transfer_Message const *message, Transfer_Entry const *entry);
+
+typedef struct {
+    Transfer_Message const *_message;
+    Object **_objects;
+    size_t *_pending;
+    size_t _pending_count;
+    // The entries unpacked so far, in order.
+    size_t *_unpacked;
+    size_t _unpacked_count;
+} Transfer_Unpacker;
+
+[[nodiscard]]
+bool transfer_unpacker_try_init(Transfer_Unpacker *u, Transfer_Message const *message, errno_t *error_code);
+
+// Rebuilds the object `ref` refers to in `*slot`, which must stay reachable from a GC root while
+// the unpacker is used: objects unpacked by previous calls are shared rather than rebuilt.
+[[nodiscard]]
+bool transfer_try_unpack(Transfer_Unpacker *u, ObjectAllocator *a, Transfer_Ref ref, Object **slot, errno_t *error_code);
+
+// Unpacks `obj` wherever the entry `ref`, added by `transfer_try_refer`, is reached.
+void transfer_unpacker_provide(Transfer_Unpacker *u, Transfer_Ref ref, Object *obj);
+
+// How many objects were unpacked so far, to pass to `transfer_unpacker_forget`.
+size_t transfer_unpacker_checkpoint(Transfer_Unpacker const *u);
+
+// Forgets the objects unpacked since `checkpoint`, once their slots no longer keep them alive:
+// the next calls rebuild them.
+void transfer_unpacker_forget(Transfer_Unpacker *u, size_t checkpoint);
+
+void transfer_unpacker_free(Transfer_Unpacker *u);
@@ -0,0 +1,101 @@
+#include "client.h"
+
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "utility/guards.h"
+
+bool client_try_connect(char const *socket_path, int *fd, errno_t *error_code) {
+    guard_is_not_null(socket_path);
+    guard_is_not_null(fd);
+    guard_is_not_null(error_code);
+
+    auto address = (struct sockaddr_un) {.sun_family = AF_UNIX};
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        *error_code = ENAMETOOLONG;
+        return false;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    auto const socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket_fd < 0) {
+        *error_code = errno;
+        return false;
+    }
+
+    if (0 != connect(socket_fd, (struct sockaddr *) &address, sizeof(address))) {
+        *error_code = errno;
+        close(socket_fd);
+        return false;
+    }
+
+    *fd = socket_fd;
+    return true;
+}
+
+static bool try_send_all(int fd, char const *data, size_t size, errno_t *error_code) {
+    while (size > 0) {
+        auto const sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+
+            *error_code = errno;
+            return false;
+        }
+
+        data += sent;
+        size -= (size_t) sent;
+    }
+
+    return true;
+}
+
+static bool try_receive_all(int fd, FILE *out, errno_t *error_code) {
+    char buffer[4096];
+    while (true) {
+        auto const received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+
+            *error_code = errno;
+            return false;
+        }
+
+        if (0 == received) {
+            return true;
+        }
+
+        if (nullptr != out && (size_t) received != fwrite(buffer, 1, (size_t) received, out)) {
+            *error_code = EIO;
+            return false;
+        }
+    }
+}
+
+bool client_try_eval(int fd, char const *source, size_t size, FILE *out, errno_t *error_code) {
+    guard_is_not_null(source);
+    guard_is_not_null(error_code);
+
+    if (false == try_send_all(fd, source, size, error_code)) {
+        close(fd);
+        return false;
+    }
+
+    // End of the request.
+    if (0 != shutdown(fd, SHUT_WR)) {
+        *error_code = errno;
+        close(fd);
+        return false;
+    }
+
+    auto const ok = try_receive_all(fd, out, error_code);
+    close(fd);
+
+    return ok;
+}
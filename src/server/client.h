@@ -0,0 +1,15 @@
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Client side of the evaluation server protocol, see `server.h`.
+
+[[nodiscard]]
+bool client_try_connect(char const *socket_path, int *fd, errno_t *error_code);
+
+// Sends `source` and copies the response to `out`, or discards it if `out` is null;
+// closes `fd`.
+[[nodiscard]]
+bool client_try_eval(int fd, char const *source, size_t size, FILE *out, errno_t *error_code);
@@ -0,0 +1,180 @@
+#include "server.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "utility/guards.h"
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void request_stop(int) {
+    stop_requested = 1;
+}
+
+static bool try_listen(char const *path, int *fd, errno_t *error_code) {
+    auto address = (struct sockaddr_un) {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        *error_code = ENAMETOOLONG;
+        return false;
+    }
+    strcpy(address.sun_path, path);
+
+    // A socket left behind by a server that was killed; anything else is not ours to remove.
+    struct stat st;
+    if (0 == lstat(path, &st) && S_ISSOCK(st.st_mode)) {
+        unlink(path);
+    }
+
+    auto const socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket_fd < 0) {
+        *error_code = errno;
+        return false;
+    }
+
+    if (0 != bind(socket_fd, (struct sockaddr *) &address, sizeof(address))
+        || 0 != listen(socket_fd, SOMAXCONN)) {
+        *error_code = errno;
+        close(socket_fd);
+        return false;
+    }
+
+    *fd = socket_fd;
+    return true;
+}
+
+[[noreturn]]
+static void serve_one(VirtualMachine *vm, int listen_fd, Server_Handler handler) {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+
+    int connection;
+    do {
+        connection = accept(listen_fd, nullptr, nullptr);
+    } while (connection < 0 && EINTR == errno);
+    close(listen_fd);
+
+    if (connection < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    // Everything the script prints is the response.
+    if (dup2(connection, STDOUT_FILENO) < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    auto const request = fdopen(connection, "rb");
+    if (nullptr == request) {
+        exit(EXIT_FAILURE);
+    }
+
+    auto const ok = handler(vm, (NamedFile) {.name = "<request>", .handle = request});
+    fflush(stdout);
+    fclose(request);
+
+    exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+static bool try_spawn(VirtualMachine *vm, int listen_fd, Server_Handler handler, pid_t *pid, errno_t *error_code) {
+    // Otherwise buffered output would be written once by every worker.
+    fflush(stdout);
+    // A pool the VM started would wait for threads the worker does not have.
+    vm_stop_threads(vm);
+
+    auto const child = fork();
+    if (child < 0) {
+        *error_code = errno;
+        return false;
+    }
+
+    if (0 == child) {
+        serve_one(vm, listen_fd, handler);
+    }
+
+    *pid = child;
+    return true;
+}
+
+static void stop_workers(pid_t *pids, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (pids[i] > 0) {
+            kill(pids[i], SIGTERM);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (pids[i] > 0) {
+            waitpid(pids[i], nullptr, 0);
+            pids[i] = 0;
+        }
+    }
+}
+
+bool server_try_run(VirtualMachine *vm, Server_Config config, Server_Handler handler, errno_t *error_code) {
+    guard_is_not_null(vm);
+    guard_is_not_null(config.socket_path);
+    guard_is_greater(config.workers, 0);
+    guard_is_not_null(handler);
+    guard_is_not_null(error_code);
+
+    errno = 0;
+    auto const pids = (pid_t *) calloc(config.workers, sizeof(pid_t));
+    if (nullptr == pids) {
+        *error_code = errno;
+        return false;
+    }
+
+    int listen_fd;
+    if (false == try_listen(config.socket_path, &listen_fd, error_code)) {
+        free(pids);
+        return false;
+    }
+
+    // Not restarted, so that `waitpid` returns as soon as a stop is requested.
+    struct sigaction stop_action = {.sa_handler = request_stop};
+    sigemptyset(&stop_action.sa_mask);
+    struct sigaction previous_int, previous_term;
+    sigaction(SIGINT, &stop_action, &previous_int);
+    sigaction(SIGTERM, &stop_action, &previous_term);
+
+    auto ok = true;
+    for (size_t i = 0; ok && i < config.workers; i++) {
+        ok = try_spawn(vm, listen_fd, handler, &pids[i], error_code);
+    }
+
+    while (ok && 0 == stop_requested) {
+        auto const pid = waitpid(-1, nullptr, 0);
+        if (pid < 0 && ECHILD == errno) {
+            // Every fork has failed, back off before trying again.
+            sleep(1);
+        }
+
+        for (size_t i = 0; i < config.workers; i++) {
+            if (pid > 0 && pid == pids[i]) {
+                pids[i] = 0;
+            }
+
+            // A failed fork is retried when the next worker exits.
+            errno_t spawn_error;
+            if (0 == pids[i] && 0 == stop_requested) {
+                (void) try_spawn(vm, listen_fd, handler, &pids[i], &spawn_error);
+            }
+        }
+    }
+
+    stop_workers(pids, config.workers);
+    sigaction(SIGINT, &previous_int, nullptr);
+    sigaction(SIGTERM, &previous_term, nullptr);
+    stop_requested = 0;
+
+    close(listen_fd);
+    unlink(config.socket_path);
+    free(pids);
+
+    return ok;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+
+#include "vm/reader/named_file.h"
+#include "vm/virtual_machine.h"
+
+// Pre-forking evaluation server. The parent keeps a pool of workers forked from a fully
+// initialized VM, so each worker starts with the prelude and everything evaluated before
+// the server was started, sharing the parent's heap copy-on-write.
+//
+// Protocol: a client connects to the Unix domain socket, writes the source and shuts down
+// its writing side; the response is everything the script prints, the worker closes the
+// connection when it is done. Every worker serves exactly one request and is then replaced,
+// so requests never observe each other's definitions.
+
+typedef bool (*Server_Handler)(VirtualMachine *vm, NamedFile file);
+
+typedef struct {
+    char const *socket_path;
+    size_t workers;
+} Server_Config;
+
+// Serves requests until the process receives SIGINT or SIGTERM.
+[[nodiscard]]
+bool server_try_run(VirtualMachine *vm, Server_Config config, Server_Handler handler, errno_t *error_code);
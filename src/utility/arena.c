@@ -98,7 +98,8 @@ bool arena_try_allocate(Arena *a, size_t alignment, size_t size, void **p, errno
         return false;
     }
 
-    guard_is_true(region_try_allocate(a->_regions, alignment, size, p));
+    auto const is_allocated = region_try_allocate(a->_regions, alignment, size, p);
+    guard_is_true(is_allocated);
     return true;
 }
 
@@ -4,19 +4,55 @@
 #include <string.h>
 #include <stdlib.h>
 
+// How many guards are compiled in, set for the whole build (see `PERSIMMON_GUARDS` in
+// CMakeLists.txt): all of them, only those that cost a single comparison, or none.
+// `guard_unreachable` and `guard_todo` stay in every level, and `guard_succeeds` always calls.
+// Guards check the invariants of the runtime, not what programs do: user-facing errors, such as
+// `type_error`, do not depend on the level.
+#define GUARD_LEVEL_NONE    0
+#define GUARD_LEVEL_CHEAP   1
+#define GUARD_LEVEL_FULL    2
+
+#ifndef GUARD_LEVEL
+#define GUARD_LEVEL GUARD_LEVEL_FULL
+#endif
+
+#if GUARD_LEVEL >= GUARD_LEVEL_FULL
+#define GUARD_LEVEL_NAME "full"
+#elif GUARD_LEVEL >= GUARD_LEVEL_CHEAP
+#define GUARD_LEVEL_NAME "cheap"
+#else
+#define GUARD_LEVEL_NAME "none"
+#endif
+
 #define GUARD__print_error(Format, ...)                                                                 \
 do {                                                                                                    \
     fprintf(stderr, "[%s:%d] %s - " Format "\n", __FILE_NAME__, __LINE__, __FUNCTION__, ##__VA_ARGS__); \
 } while (false)
 
-#define guard_assert(Cond, ...)             \
-do {                                        \
-    if (!(Cond)) {                          \
-        GUARD__print_error(__VA_ARGS__);    \
-        exit(EXIT_FAILURE);                 \
-    }                                       \
+#define GUARD__fail(...)                \
+do {                                    \
+    GUARD__print_error(__VA_ARGS__);    \
+    exit(EXIT_FAILURE);                 \
+} while (false)
+
+// A disabled guard does not evaluate its condition, which still has to compile.
+#define GUARD__ignore(Cond)     \
+do {                            \
+    (void) sizeof(!(Cond));     \
 } while (false)
 
+#if GUARD_LEVEL >= GUARD_LEVEL_CHEAP
+#define guard_assert(Cond, ...)     \
+do {                                \
+    if (!(Cond)) {                  \
+        GUARD__fail(__VA_ARGS__);   \
+    }                               \
+} while (false)
+#else
+#define guard_assert(Cond, ...) GUARD__ignore(Cond)
+#endif
+
 #define guard_is_true(Val) guard_assert((Val), "expected %s to be true", #Val)
 
 #define guard_is_false(Val) guard_assert(!(Val), "expected %s to be false", #Val)
@@ -27,6 +63,7 @@ do {                                        \
 
 #define GUARD__varargs_to_str(...) "{" #__VA_ARGS__ "}"
 
+#if GUARD_LEVEL >= GUARD_LEVEL_FULL
 #define guard_is_one_of(It, _0, ...)                                \
 do {                                                                \
     auto const _it = (It);                                          \
@@ -47,6 +84,9 @@ do {                                                                \
         #It, GUARD__varargs_to_str(_0, ##__VA_ARGS__)               \
     );                                                              \
 } while (false)
+#else
+#define guard_is_one_of(It, _0, ...) GUARD__ignore((It) == (_0))
+#endif
 
 #define guard_is_not_equal(It, Value)       \
 guard_assert(                               \
@@ -82,6 +122,7 @@ guard_assert(                                           \
     #It, #Value                                         \
 )
 
+#if GUARD_LEVEL >= GUARD_LEVEL_FULL
 #define guard_is_in_range(It, StartInclusive, EndInclusive) \
 do {                                                        \
     auto const _it = (It);                                  \
@@ -92,7 +133,12 @@ do {                                                        \
         #It, #StartInclusive, #EndInclusive                 \
     );                                                      \
 } while (false)
+#else
+#define guard_is_in_range(It, StartInclusive, EndInclusive) \
+    GUARD__ignore((It) >= (typeof(It)) (StartInclusive) && (It) <= (typeof(It)) (EndInclusive))
+#endif
 
+#if GUARD_LEVEL >= GUARD_LEVEL_CHEAP
 #define guard_succeeds(Callee, ArgsList)    \
 ({                                          \
     errno = 0;                              \
@@ -104,7 +150,10 @@ do {                                                        \
     );                                      \
     _r;                                     \
 })
+#else
+#define guard_succeeds(Callee, ArgsList) (Callee ArgsList)
+#endif
 
-#define guard_unreachable(...) guard_assert(false, "this code must never be reached: " __VA_ARGS__)
+#define guard_unreachable(...) GUARD__fail("this code must never be reached: " __VA_ARGS__)
 
 #define guard_todo() guard_unreachable("TODO")
\ No newline at end of file
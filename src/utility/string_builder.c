@@ -5,6 +5,9 @@
 #include <memory.h>
 
 #include "guards.h"
+#include "math.h"
+
+#define SB_MIN_CAPACITY 16
 
 void sb_free(StringBuilder *sb) {
     guard_is_not_null(sb);
@@ -15,15 +18,18 @@ void sb_free(StringBuilder *sb) {
 
 void sb_clear(StringBuilder *sb) {
     guard_is_not_null(sb);
+
     sb->length = 0;
-    memset(sb->str, 0, sb->_max_length);
+    if (nullptr != sb->str) {
+        sb->str[0] = '\0';
+    }
 }
 
 bool sb_try_reserve(StringBuilder *sb, size_t max_length, errno_t *error_code) {
     guard_is_not_null(sb);
     guard_is_not_null(error_code);
 
-    if (max_length <= sb->_max_length) {
+    if (max_length <= sb->_max_length && nullptr != sb->str) {
         return true;
     }
 
@@ -34,12 +40,29 @@ bool sb_try_reserve(StringBuilder *sb, size_t max_length, errno_t *error_code) {
         return false;
     }
 
+    auto const is_new = nullptr == sb->str;
     sb->str = str;
     sb->_max_length = max_length;
 
+    if (is_new) {
+        sb->str[0] = '\0';
+    }
+
     return true;
 }
 
+static bool sb_try_grow(StringBuilder *sb, size_t min_length, errno_t *error_code) {
+    guard_is_not_null(sb);
+    guard_is_not_null(error_code);
+
+    if (min_length <= sb->_max_length && nullptr != sb->str) {
+        return true;
+    }
+
+    auto const grown = max(sb->_max_length * 2, (size_t) SB_MIN_CAPACITY);
+    return sb_try_reserve(sb, max(grown, min_length), error_code);
+}
+
 static void sb_format(StringBuilder *sb, char const *format, va_list args) {
     guard_is_not_null(sb);
     guard_is_not_null(sb->str);
@@ -47,7 +70,6 @@ static void sb_format(StringBuilder *sb, char const *format, va_list args) {
 
     auto const dst = sb->str + sb->length;
     auto const available = sb->_max_length - sb->length + 1;
-    memset(dst, 0, available);
 
     auto const written = vsnprintf(dst, available, format, args);
 
@@ -58,6 +80,15 @@ static void sb_format(StringBuilder *sb, char const *format, va_list args) {
     guard_is_equal(sb->str[sb->length], '\0');
 }
 
+static void sb_append(StringBuilder *sb, char const *bytes, size_t count) {
+    guard_is_not_null(sb->str);
+    guard_is_less_or_equal(sb->length + count, sb->_max_length);
+
+    memcpy(sb->str + sb->length, bytes, count);
+    sb->length += count;
+    sb->str[sb->length] = '\0';
+}
+
 bool sb_try_printf_(StringBuilder *sb, char const *format, ...) {
     guard_is_not_null(sb);
     guard_is_not_null(format);
@@ -93,18 +124,63 @@ bool sb_try_printf_reallocate_(StringBuilder *sb, errno_t *error_code, char cons
     va_end(args);
     guard_is_greater_or_equal(to_be_written, 0);
 
-    auto const new_length = sb->length + to_be_written;
-    if (new_length > sb->_max_length) {
-        if (false == sb_try_reserve(sb, new_length, error_code)) {
-            return false;
-        }
+    if (false == sb_try_grow(sb, sb->length + to_be_written, error_code)) {
+        return false;
     }
 
-    guard_is_not_null(sb->str);
-
     va_start(args, format);
     sb_format(sb, format, args);
     va_end(args);
 
     return true;
 }
+
+bool sb_try_append_char_(StringBuilder *sb, char c) {
+    guard_is_not_null(sb);
+
+    if (sb->length >= sb->_max_length) {
+        return false;
+    }
+
+    sb->str[sb->length++] = c;
+    sb->str[sb->length] = '\0';
+    return true;
+}
+
+bool sb_try_append_char_reallocate_(StringBuilder *sb, errno_t *error_code, char c) {
+    guard_is_not_null(sb);
+    guard_is_not_null(error_code);
+
+    if (false == sb_try_grow(sb, sb->length + 1, error_code)) {
+        return false;
+    }
+
+    sb->str[sb->length++] = c;
+    sb->str[sb->length] = '\0';
+    return true;
+}
+
+bool sb_try_append_bytes_(StringBuilder *sb, char const *bytes, size_t count) {
+    guard_is_not_null(sb);
+    guard_is_not_null(bytes);
+
+    if (sb->length + count > sb->_max_length) {
+        return false;
+    }
+
+    sb_append(sb, bytes, count);
+    return true;
+}
+
+bool sb_try_append_bytes_reallocate_(StringBuilder *sb, errno_t *error_code, char const *bytes, size_t count) {
+    guard_is_not_null(sb);
+    guard_is_not_null(error_code);
+    guard_is_not_null(bytes);
+
+    if (false == sb_try_grow(sb, sb->length + count, error_code)) {
+        return false;
+    }
+
+    sb_append(sb, bytes, count);
+    return true;
+}
@@ -30,3 +30,28 @@ bool sb_try_printf_reallocate_(StringBuilder *sb, errno_t *error_code, char cons
     char const * : sb_try_printf_,              \
     char *       : sb_try_printf_               \
 )((SB), (_0), __VA_ARGS__))
+
+[[nodiscard]]
+bool sb_try_append_char_(StringBuilder *sb, char c);
+
+[[nodiscard]]
+bool sb_try_append_char_reallocate_(StringBuilder *sb, errno_t *error_code, char c);
+
+#define sb_try_append_char(SB, _0, ...)                 \
+(_Generic((_0),                                         \
+    errno_t * : sb_try_append_char_reallocate_,         \
+    default   : sb_try_append_char_                     \
+)((SB), (_0) __VA_OPT__(,) __VA_ARGS__))
+
+[[nodiscard]]
+bool sb_try_append_bytes_(StringBuilder *sb, char const *bytes, size_t count);
+
+[[nodiscard]]
+bool sb_try_append_bytes_reallocate_(StringBuilder *sb, errno_t *error_code, char const *bytes, size_t count);
+
+#define sb_try_append_bytes(SB, _0, ...)                \
+(_Generic((_0),                                         \
+    errno_t *    : sb_try_append_bytes_reallocate_,     \
+    char const * : sb_try_append_bytes_,                \
+    char *       : sb_try_append_bytes_                 \
+)((SB), (_0), __VA_ARGS__))
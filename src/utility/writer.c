@@ -1,5 +1,9 @@
 #include "writer.h"
 
+#include <string.h>
+
+#include "guards.h"
+
 Writer writer_make_from_file_(FILE *file) {
     return (Writer) {
             .type = WRITER_FILE,
@@ -13,3 +17,52 @@ Writer writer_make_from_sb_(StringBuilder *sb) {
             .as_sb = sb
     };
 }
+
+bool writer_try_append_char(Writer w, char c, errno_t *error_code) {
+    guard_is_not_null(error_code);
+
+    switch (w.type) {
+        case WRITER_FILE: {
+            errno = 0;
+            if (EOF == fputc(c, w.as_file)) {
+                *error_code = errno;
+                return false;
+            }
+
+            return true;
+        }
+        case WRITER_SB: {
+            return sb_try_append_char(w.as_sb, error_code, c);
+        }
+    }
+
+    guard_unreachable();
+}
+
+bool writer_try_append_bytes(Writer w, char const *bytes, size_t count, errno_t *error_code) {
+    guard_is_not_null(bytes);
+    guard_is_not_null(error_code);
+
+    switch (w.type) {
+        case WRITER_FILE: {
+            errno = 0;
+            if (count != fwrite(bytes, 1, count, w.as_file)) {
+                *error_code = errno;
+                return false;
+            }
+
+            return true;
+        }
+        case WRITER_SB: {
+            return sb_try_append_bytes(w.as_sb, error_code, bytes, count);
+        }
+    }
+
+    guard_unreachable();
+}
+
+bool writer_try_append_str(Writer w, char const *str, errno_t *error_code) {
+    guard_is_not_null(str);
+
+    return writer_try_append_bytes(w, str, strlen(str), error_code);
+}
@@ -28,6 +28,15 @@ Writer writer_make_from_sb_(StringBuilder *sb);
     StringBuilder * : writer_make_from_sb_      \
 )((FileOrBuilder)))
 
+[[nodiscard]]
+bool writer_try_append_char(Writer w, char c, errno_t *error_code);
+
+[[nodiscard]]
+bool writer_try_append_bytes(Writer w, char const *bytes, size_t count, errno_t *error_code);
+
+[[nodiscard]]
+bool writer_try_append_str(Writer w, char const *str, errno_t *error_code);
+
 #define writer_try_printf(Writer_, ErrorCode, Format, ...)  \
 ({                                                          \
     auto const _w = (Writer_);                              \
@@ -50,7 +50,8 @@ bool binding_is_valid_target(Object *target, BindingTargetError *error) { // NOL
         case TYPE_DICT:
         case TYPE_PRIMITIVE:
         case TYPE_CLOSURE:
-        case TYPE_MACRO: {
+        case TYPE_MACRO:
+        case TYPE_HANDLE: {
             *error = (BindingTargetError) {
                     .type = BINDING_INVALID_TARGET_TYPE,
                     .as_invalid_target = {
@@ -148,7 +149,8 @@ static bool is_valid_value(Object *target, Object *value, BindingValueError *err
         case TYPE_DICT:
         case TYPE_PRIMITIVE:
         case TYPE_CLOSURE:
-        case TYPE_MACRO: {
+        case TYPE_MACRO:
+        case TYPE_HANDLE: {
             guard_unreachable();
         }
     }
@@ -199,7 +201,8 @@ static bool env_try_bind_(ObjectAllocator *a, Object *env, Object *target, Objec
         case TYPE_DICT:
         case TYPE_PRIMITIVE:
         case TYPE_CLOSURE:
-        case TYPE_MACRO: {
+        case TYPE_MACRO:
+        case TYPE_HANDLE: {
             guard_unreachable();
         }
     }
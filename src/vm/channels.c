@@ -0,0 +1,375 @@
+#include "channels.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "utility/guards.h"
+#include "object/constructors.h"
+#include "object/transfer.h"
+#include "virtual_machine.h"
+#include "errors.h"
+
+#define CHANNEL_CACHE_LINE 64
+
+typedef struct {
+    atomic_size_t sequence;
+    Transfer_Message message;
+    Transfer_Ref value;
+} Channel_Cell;
+
+typedef struct Channel Channel;
+typedef struct Channel_Waiter Channel_Waiter;
+
+// A task suspended on a channel, in its list of waiters until the channel changes.
+struct Channel_Waiter {
+    Channel *channel;
+    Tasks *tasks;
+    Task *task;
+    Channel_Waiter *next;
+    Channel_Waiter **link;
+};
+
+// A bounded multi-producer multi-consumer ring (D. Vyukov's): the cell at `position` is free
+// for a sender when its sequence is `position`, and holds a value for a receiver when it is
+// `position + 1`. Senders and receivers only contend on their own end of the ring.
+struct Channel {
+    alignas(CHANNEL_CACHE_LINE) atomic_size_t send_position;
+    alignas(CHANNEL_CACHE_LINE) atomic_size_t recv_position;
+    alignas(CHANNEL_CACHE_LINE) atomic_size_t references;
+    Channel_Cell *cells;
+    size_t mask;
+
+    // Waiting is the slow path: the lock is only taken by tasks that found the ring full or
+    // empty, and by those that make progress while any of them waits.
+    atomic_size_t waiting;
+    pthread_mutex_t lock;
+    Channel_Waiter *waiters;
+};
+
+static bool try_push(Channel *ch, Transfer_Message const *message, Transfer_Ref value) {
+    auto position = atomic_load_explicit(&ch->send_position, memory_order_relaxed);
+    while (true) {
+        auto const cell = &ch->cells[position & ch->mask];
+        auto const sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        auto const diff = (intptr_t) sequence - (intptr_t) position;
+
+        if (diff < 0) {
+            return false;
+        }
+
+        if (diff > 0) {
+            position = atomic_load_explicit(&ch->send_position, memory_order_relaxed);
+            continue;
+        }
+
+        auto const claimed = atomic_compare_exchange_weak_explicit(
+                &ch->send_position, &position, position + 1,
+                memory_order_relaxed, memory_order_relaxed
+        );
+        if (claimed) {
+            cell->message = *message;
+            cell->value = value;
+            atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+            return true;
+        }
+    }
+}
+
+static bool try_pop(Channel *ch, Transfer_Message *message, Transfer_Ref *value) {
+    auto position = atomic_load_explicit(&ch->recv_position, memory_order_relaxed);
+    while (true) {
+        auto const cell = &ch->cells[position & ch->mask];
+        auto const sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        auto const diff = (intptr_t) sequence - (intptr_t) (position + 1);
+
+        if (diff < 0) {
+            return false;
+        }
+
+        if (diff > 0) {
+            position = atomic_load_explicit(&ch->recv_position, memory_order_relaxed);
+            continue;
+        }
+
+        auto const claimed = atomic_compare_exchange_weak_explicit(
+                &ch->recv_position, &position, position + 1,
+                memory_order_relaxed, memory_order_relaxed
+        );
+        if (claimed) {
+            *message = cell->message;
+            *value = cell->value;
+            atomic_store_explicit(&cell->sequence, position + ch->mask + 1, memory_order_release);
+            return true;
+        }
+    }
+}
+
+static void unlink_waiter(Channel_Waiter *w) {
+    *w->link = w->next;
+    if (nullptr != w->next) {
+        w->next->link = w->link;
+    }
+    w->link = nullptr;
+    atomic_fetch_sub(&w->channel->waiting, 1);
+}
+
+// Every waiter is woken up, to try again; called with the lock held.
+static void wake_waiters(Channel *ch) {
+    while (nullptr != ch->waiters) {
+        auto const w = ch->waiters;
+        unlink_waiter(w);
+        tasks_wake(w->tasks, w->task, w);
+    }
+}
+
+// Pairs with the increment of `waiting` in `try_wait`: either the waiter sees the change
+// when it retries, or this sees the waiter and wakes it up.
+static void notify(Channel *ch) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (0 == atomic_load_explicit(&ch->waiting, memory_order_relaxed)) {
+        return;
+    }
+
+    pthread_mutex_lock(&ch->lock);
+    wake_waiters(ch);
+    pthread_mutex_unlock(&ch->lock);
+}
+
+// Another VM, or a message on its way to one, holds the channel and may still wake the task.
+static bool can_wake(void *context) {
+    Channel_Waiter const *w = context;
+    return atomic_load(&w->channel->references) > 1;
+}
+
+static void cancel(void *context) {
+    Channel_Waiter *w = context;
+    auto const ch = w->channel;
+    pthread_mutex_lock(&ch->lock);
+    if (nullptr != w->link) {
+        unlink_waiter(w);
+    }
+    pthread_mutex_unlock(&ch->lock);
+    free(w);
+}
+
+static Tasks_Wait const CHANNEL_WAIT = {.can_wake = can_wake, .cancel = cancel};
+
+// Suspends the running task until the channel changes, unless `try_change` succeeds once the
+// task is among the waiters; the task makes its call again when it resumes.
+[[nodiscard]]
+static bool try_wait(
+        VirtualMachine *vm,
+        Channel *ch,
+        bool (*try_change)(Channel *ch, Transfer_Message *message, Transfer_Ref *value),
+        Transfer_Message *message,
+        Transfer_Ref *value,
+        bool *is_changed
+) {
+    auto const w = (Channel_Waiter *) calloc(1, sizeof(Channel_Waiter));
+    if (nullptr == w) {
+        out_of_memory_error(vm);
+    }
+
+    pthread_mutex_lock(&ch->lock);
+    atomic_fetch_add(&ch->waiting, 1);
+    *is_changed = try_change(ch, message, value);
+    if (*is_changed) {
+        atomic_fetch_sub(&ch->waiting, 1);
+        pthread_mutex_unlock(&ch->lock);
+        free(w);
+        notify(ch);
+        return true;
+    }
+
+    *w = (Channel_Waiter) {
+            .channel = ch,
+            .tasks = &vm->tasks,
+            .next = ch->waiters,
+            .link = &ch->waiters,
+    };
+    if (nullptr != ch->waiters) {
+        ch->waiters->link = &w->next;
+    }
+    ch->waiters = w;
+    w->task = tasks_suspend(vm, &CHANNEL_WAIT, w);
+    pthread_mutex_unlock(&ch->lock);
+    return true;
+}
+
+static bool try_push_message(Channel *ch, Transfer_Message *message, Transfer_Ref *value) {
+    return try_push(ch, message, *value);
+}
+
+// A task resumed by `notify` frees its place among the waiters, and fails if it was resumed
+// because every task waits.
+[[nodiscard]]
+static bool try_resume(VirtualMachine *vm) {
+    void *wakeup;
+    if (tasks_try_take_wakeup(&vm->tasks, &wakeup)) {
+        free(wakeup);
+    }
+    if (tasks_take_deadlock(&vm->tasks)) {
+        value_error(vm, "deadlock: every task is waiting for another");
+    }
+
+    return true;
+}
+
+static void retain_channel(void *data) {
+    Channel *ch = data;
+    atomic_fetch_add(&ch->references, 1);
+}
+
+static void release_channel(void *data) {
+    Channel *ch = data;
+    // Under the lock, so that the last release waits for the one before to let go of it.
+    pthread_mutex_lock(&ch->lock);
+    auto const references = atomic_fetch_sub(&ch->references, 1);
+    if (2 == references) {
+        // The tasks waiting on the channel may now be waiting for one another.
+        wake_waiters(ch);
+    }
+    pthread_mutex_unlock(&ch->lock);
+    if (1 != references) {
+        return;
+    }
+
+    // Values nobody received; they may hold the last references to other channels.
+    Transfer_Message message;
+    Transfer_Ref value;
+    while (try_pop(ch, &message, &value)) {
+        transfer_message_free(&message);
+    }
+
+    pthread_mutex_destroy(&ch->lock);
+    free(ch->cells);
+    free(ch);
+}
+
+static Object_HandleClass const CHANNEL_CLASS = {.name = "channel", .release = release_channel, .retain = retain_channel};
+
+bool channel_try_make(VirtualMachine *vm, size_t capacity, Object **channel) {
+    guard_is_not_null(vm);
+    guard_is_not_null(channel);
+
+    if (0 == capacity || capacity > CHANNEL_MAX_CAPACITY) {
+        value_error(vm, "channel capacity out of range");
+    }
+
+    // A ring of one cell cannot tell full from empty: its sequence is `position + 1` either way.
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+
+    auto const ch = (Channel *) aligned_alloc(alignof(Channel), sizeof(Channel));
+    auto const cells = (Channel_Cell *) calloc(size, sizeof(Channel_Cell));
+    if (nullptr == ch || nullptr == cells) {
+        free(cells);
+        free(ch);
+        out_of_memory_error(vm);
+    }
+
+    *ch = (Channel) {.cells = cells, .mask = size - 1};
+    atomic_init(&ch->send_position, 0);
+    atomic_init(&ch->recv_position, 0);
+    atomic_init(&ch->references, 1);
+    atomic_init(&ch->waiting, 0);
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&cells[i].sequence, i);
+    }
+    pthread_mutex_init(&ch->lock, nullptr);
+
+    if (false == object_try_make_handle(&vm->allocator, &CHANNEL_CLASS, ch, channel)) {
+        release_channel(ch);
+        out_of_memory_error(vm);
+    }
+
+    return true;
+}
+
+static bool is_channel(Object *obj) {
+    return TYPE_HANDLE == obj->type && &CHANNEL_CLASS == obj->as_handle.class;
+}
+
+bool channel_try_send(VirtualMachine *vm, Object *channel, Object *value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(channel);
+    guard_is_not_null(value);
+
+    if (false == is_channel(channel)) {
+        type_error(vm, channel->type, TYPE_HANDLE);
+    }
+    if (false == try_resume(vm)) {
+        return false;
+    }
+
+    auto message = (Transfer_Message) {0};
+    Transfer_Ref ref;
+    errno_t error_code;
+    if (false == transfer_try_pack(&message, value, &ref, &error_code)) {
+        transfer_message_free(&message);
+        transfer_error(vm, error_code);
+    }
+
+    Channel *ch = channel->as_handle.data;
+    if (try_push(ch, &message, ref)) {
+        notify(ch);
+        return true;
+    }
+
+    // Packed again when the call is made again.
+    auto is_sent = false;
+    if (false == try_wait(vm, ch, try_push_message, &message, &ref, &is_sent)) {
+        transfer_message_free(&message);
+        return false;
+    }
+    if (false == is_sent) {
+        transfer_message_free(&message);
+    }
+
+    return true;
+}
+
+bool channel_try_recv(VirtualMachine *vm, Object *channel, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(channel);
+    guard_is_not_null(value);
+
+    if (false == is_channel(channel)) {
+        type_error(vm, channel->type, TYPE_HANDLE);
+    }
+    if (false == try_resume(vm)) {
+        return false;
+    }
+
+    Channel *ch = channel->as_handle.data;
+    Transfer_Message message;
+    Transfer_Ref ref;
+    if (try_pop(ch, &message, &ref)) {
+        notify(ch);
+    } else {
+        auto is_received = false;
+        if (false == try_wait(vm, ch, try_pop, &message, &ref, &is_received)) {
+            return false;
+        }
+        if (false == is_received) {
+            *value = OBJECT_NIL;
+            return true;
+        }
+    }
+
+    Transfer_Unpacker u;
+    errno_t error_code;
+    auto const ok = transfer_unpacker_try_init(&u, &message, &error_code)
+                    && transfer_try_unpack(&u, &vm->allocator, ref, value, &error_code);
+    transfer_unpacker_free(&u);
+    transfer_message_free(&message);
+    if (false == ok) {
+        transfer_error(vm, error_code);
+    }
+
+    return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "object/object.h"
+
+// Bounded queues of values between VMs. A channel is a handle that can be passed to other VMs
+// (through `pmap`, `future` or another channel); values go through it as transfer messages
+// (see `object/transfer.h`), so senders and receivers never see each other's heaps.
+
+struct VirtualMachine;
+
+#define CHANNEL_MAX_CAPACITY ((size_t) 1 << 20)
+
+// Makes a channel buffering up to `capacity` values, rounded up to a power of two (at least 2).
+[[nodiscard]]
+bool channel_try_make(struct VirtualMachine *vm, size_t capacity, Object **channel);
+
+// Suspends the running task while the channel is full. Fails if nothing else may ever take a
+// value out: every task of the VM is waiting, and no other VM holds the channel.
+[[nodiscard]]
+bool channel_try_send(struct VirtualMachine *vm, Object *channel, Object *value);
+
+// Suspends the running task while the channel is empty. Fails if nothing else may ever put a
+// value in, as `channel_try_send` does.
+[[nodiscard]]
+bool channel_try_recv(struct VirtualMachine *vm, Object *channel, Object **value);
@@ -4,9 +4,9 @@
 #include "object/accessors.h"
 #include "env.h"
 
-static auto const SYMBOL_TRUE = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "true"};
-static auto const SYMBOL_FALSE = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "false"};
-static auto const SYMBOL_NIL = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "nil"};
+static auto const SYMBOL_TRUE = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "true"};
+static auto const SYMBOL_FALSE = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "false"};
+static auto const SYMBOL_NIL = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "nil"};
 
 bool try_define_constants(ObjectAllocator *a, Object *env) {
     guard_is_not_null(a);
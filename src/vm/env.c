@@ -24,7 +24,12 @@ bool env_try_define(ObjectAllocator *a, Object *env, Object *name, Object *value
     auto const scope = &env->as_list.first;
     guard_is_one_of((*scope)->type, TYPE_NIL, TYPE_DICT);
 
-    return object_dict_try_put(a, *scope, name, value, scope);
+    if (false == object_dict_try_put(a, *scope, name, value, scope)) {
+        return false;
+    }
+
+    allocator_note_write(a, env);
+    return true;
 }
 
 bool env_try_find(Object *env, Object *name, Object **value) {
@@ -19,9 +19,9 @@
 
 #define MESSAGE_MIN_CAPACITY 512
 
-Object *const ERROR_KEY_TYPE = &(Object) {.type = TYPE_SYMBOL, .as_symbol = ERROR_KEY_NAME_TYPE};
-Object *const ERROR_KEY_MESSAGE = &(Object) {.type = TYPE_SYMBOL, .as_symbol = ERROR_KEY_NAME_MESSAGE};
-Object *const ERROR_KEY_TRACEBACK = &(Object) {.type = TYPE_SYMBOL, .as_symbol = ERROR_KEY_NAME_TRACEBACK};
+Object *const ERROR_KEY_TYPE = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = ERROR_KEY_NAME_TYPE};
+Object *const ERROR_KEY_MESSAGE = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = ERROR_KEY_NAME_MESSAGE};
+Object *const ERROR_KEY_TRACEBACK = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = ERROR_KEY_NAME_TRACEBACK};
 
 extern Object *const OBJECT_ERROR_OUT_OF_MEMORY;
 
@@ -119,7 +119,7 @@ static void set_error(VirtualMachine *vm, Object *error_type, char const *messag
     vm->error = *tmp_error;
 }
 
-static auto const SYMBOL_OS_ERROR = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "OSError"};
+static auto const SYMBOL_OS_ERROR = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "OSError"};
 
 void set_os_error(VirtualMachine *vm, errno_t error_code) {
     guard_is_not_null(vm);
@@ -127,7 +127,7 @@ void set_os_error(VirtualMachine *vm, errno_t error_code) {
     set_error(vm, SYMBOL_OS_ERROR, strerror(error_code));
 }
 
-static auto const SYMBOL_TYPE_ERROR = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "TypeError"};
+static auto const SYMBOL_TYPE_ERROR = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "TypeError"};
 
 static bool try_format_type_expected_types_message(
         StringBuilder *sb,
@@ -190,7 +190,7 @@ void set_type_error_(
     sb_free(&sb);
 }
 
-static auto const SYMBOL_SYNTAX_ERROR = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "SyntaxError"};
+static auto const SYMBOL_SYNTAX_ERROR = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "SyntaxError"};
 
 static bool try_pad(StringBuilder *sb, errno_t *error_code, size_t padding) {
     guard_is_not_null(sb);
@@ -322,7 +322,7 @@ void set_special_syntax_error_(
     sb_free(&sb);
 }
 
-static auto const SYMBOL_CALL_ERROR = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "CallError"};
+static auto const SYMBOL_CALL_ERROR = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "CallError"};
 
 void set_call_args_count_error(VirtualMachine *vm, char const *name, size_t expected, size_t got) {
     guard_is_not_null(vm);
@@ -343,7 +343,7 @@ void set_call_args_count_error(VirtualMachine *vm, char const *name, size_t expe
     sb_free(&sb);
 }
 
-static auto const SYMBOL_NAME_ERROR = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "NameError"};
+static auto const SYMBOL_NAME_ERROR = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "NameError"};
 
 void set_name_error(VirtualMachine *vm, char const *name) {
     guard_is_not_null(vm);
@@ -365,7 +365,7 @@ void set_name_error(VirtualMachine *vm, char const *name) {
     sb_free(&sb);
 }
 
-static auto const SYMBOL_ZERO_DIVISION_ERROR = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "ZeroDivisionError"};
+static auto const SYMBOL_ZERO_DIVISION_ERROR = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "ZeroDivisionError"};
 
 void set_zero_division_error(VirtualMachine *vm) {
     guard_is_not_null(vm);
@@ -378,13 +378,13 @@ void set_out_of_memory_error(VirtualMachine *vm) {
 
     vm->error = OBJECT_ERROR_OUT_OF_MEMORY;
 
-    object_print(OBJECT_ERROR_OUT_OF_MEMORY->as_dict.value, stdout);
-    printf("\n");
+    object_print(OBJECT_ERROR_OUT_OF_MEMORY->as_dict.value, vm->output);
+    fprintf(vm->output, "\n");
     allocator_print_statistics(&vm->allocator, stderr);
     traceback_print_from_stack(&vm->stack, stderr);
 }
 
-static auto const SYMBOL_STACK_OVERFLOW_ERROR = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "StackOverflowError"};
+static auto const SYMBOL_STACK_OVERFLOW_ERROR = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "StackOverflowError"};
 
 void set_stack_overflow_error(VirtualMachine *vm) {
     guard_is_not_null(vm);
@@ -392,7 +392,7 @@ void set_stack_overflow_error(VirtualMachine *vm) {
     set_error(vm, SYMBOL_STACK_OVERFLOW_ERROR, "stack capacity exceeded");
 }
 
-static auto const SYMBOL_BINDING_ERROR = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "BindingError"};
+static auto const SYMBOL_BINDING_ERROR = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "BindingError"};
 
 static void set_binding_count_error(VirtualMachine *vm, size_t expected, bool is_variadic, size_t got) {
     guard_is_not_null(vm);
@@ -485,7 +485,7 @@ void set_binding_error(VirtualMachine *vm, BindingError error) {
     guard_unreachable();
 }
 
-static auto const SYMBOL_KEY_ERROR = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "KeyError"};
+static auto const SYMBOL_KEY_ERROR = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "KeyError"};
 
 void set_key_error(VirtualMachine *vm, Object *key) {
     guard_is_not_null(vm);
@@ -506,3 +506,26 @@ void set_key_error(VirtualMachine *vm, Object *key) {
     set_error(vm, error_type, sb.str);
     sb_free(&sb);
 }
+
+static auto const SYMBOL_TRANSFER_ERROR = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "TransferError"};
+
+void set_transfer_error(VirtualMachine *vm, errno_t error_code) {
+    guard_is_not_null(vm);
+
+    if (ENOMEM == error_code) {
+        set_out_of_memory_error(vm);
+        return;
+    }
+
+    auto const message = EINVAL == error_code ? "value can not be moved to another VM" : strerror(error_code);
+    set_error(vm, SYMBOL_TRANSFER_ERROR, message);
+}
+
+static auto const SYMBOL_VALUE_ERROR = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "ValueError"};
+
+void set_value_error(VirtualMachine *vm, char const *message) {
+    guard_is_not_null(vm);
+    guard_is_not_null(message);
+
+    set_error(vm, SYMBOL_VALUE_ERROR, message);
+}
@@ -90,3 +90,11 @@ void set_binding_error(VirtualMachine *vm, BindingError error);
 void set_key_error(VirtualMachine *vm, Object *key);
 
 #define key_error(VM, Key) ERRORS__error(set_key_error, (VM), (Key))
+
+void set_transfer_error(VirtualMachine *vm, errno_t error_code);
+
+#define transfer_error(VM, Errno) ERRORS__error(set_transfer_error, (VM), (Errno))
+
+void set_value_error(VirtualMachine *vm, char const *message);
+
+#define value_error(VM, Message) ERRORS__error(set_value_error, (VM), (Message))
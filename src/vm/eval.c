@@ -13,14 +13,52 @@
 #include "stack.h"
 #include "errors.h"
 #include "variadic.h"
+#include "modules.h"
+#include "tasks.h"
+#include "profiler.h"
+#include "trace.h"
+#include "primitives.h"
 
-static auto const SYMBOL_DO = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "do"};
+static auto const SYMBOL_DO = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "do"};
 
 typedef enum : bool {
     EVAL_FRAME_KEEP,
     EVAL_FRAME_REMOVE
 } EvalFrameKeepOrRemove;
 
+// Pushing, popping and swapping frames are recorded if the VM is tracing.
+static bool try_push_frame(VirtualMachine *vm, Stack_Frame frame) {
+    if (false == stack_try_push_frame(&vm->stack, frame)) {
+        return false;
+    }
+
+    auto const trace = vm->config.trace;
+    if (nullptr != trace) {
+        trace_record(trace, TRACE_FRAME_PUSH, tasks_running_id(&vm->tasks), frame.type);
+    }
+    return true;
+}
+
+static void pop_frame(VirtualMachine *vm) {
+    auto const trace = vm->config.trace;
+    if (nullptr != trace) {
+        trace_record(trace, TRACE_FRAME_POP, tasks_running_id(&vm->tasks), stack_top(&vm->stack)->type);
+    }
+
+    stack_pop(&vm->stack);
+}
+
+static void swap_top_frame(VirtualMachine *vm, Stack_Frame frame) {
+    auto const trace = vm->config.trace;
+    if (nullptr != trace) {
+        auto const task = tasks_running_id(&vm->tasks);
+        trace_record(trace, TRACE_FRAME_POP, task, stack_top(&vm->stack)->type);
+        trace_record(trace, TRACE_FRAME_PUSH, task, frame.type);
+    }
+
+    stack_swap_top(&vm->stack, frame);
+}
+
 static bool try_save_result(VirtualMachine *vm, Object **results_list, Object *value) {
     guard_is_not_null(value);
 
@@ -46,12 +84,12 @@ static bool try_save_result_and_pop(
 
     auto const frame = stack_top(&vm->stack);
     if (nullptr == frame->results_list) {
-        stack_pop(&vm->stack);
+        pop_frame(vm);
         return true;
     }
 
     if (try_save_result(vm, results_list, value)) {
-        stack_pop(&vm->stack);
+        pop_frame(vm);
         return true;
     }
 
@@ -129,10 +167,6 @@ static bool try_begin_eval(
     guard_is_not_null(env);
     guard_is_not_null(expr);
 
-#ifdef EVAL_TRACE
-    printf("[depth = %zu] evaluating %s\n", stack->count, object_repr(allocator, expr));
-#endif
-
     auto const s = &vm->stack;
 
     switch (expr->type) {
@@ -142,6 +176,7 @@ static bool try_begin_eval(
         case TYPE_PRIMITIVE:
         case TYPE_CLOSURE:
         case TYPE_MACRO:
+        case TYPE_HANDLE:
         case TYPE_NIL: {
             if (EVAL_FRAME_REMOVE == current) {
                 return try_save_result_and_pop(vm, results_list, expr);
@@ -163,7 +198,7 @@ static bool try_begin_eval(
         }
         case TYPE_LIST: {
             Stack_FrameType type;
-            auto const frame =
+            auto frame =
                     try_get_special_type(expr, &type)
                     ? frame_make(
                             type,
@@ -177,11 +212,12 @@ static bool try_begin_eval(
                     );
 
             if (EVAL_FRAME_REMOVE == current) {
-                stack_swap_top(s, frame);
+                frame.body = stack_top(s)->body;
+                swap_top_frame(vm, frame);
                 return true;
             }
 
-            if (stack_try_push_frame(s, frame)) {
+            if (try_push_frame(vm, frame)) {
                 return true;
             }
 
@@ -192,6 +228,30 @@ static bool try_begin_eval(
     guard_unreachable();
 }
 
+// Bodies are `do` forms, so their evaluation always begins with a frame of its own.
+static bool try_begin_body(
+        VirtualMachine *vm,
+        EvalFrameKeepOrRemove current,
+        Object *env,
+        Object *body,
+        Object **results_list
+) {
+    if (false == try_begin_eval(vm, current, env, body, results_list)) {
+        return false;
+    }
+
+    stack_top(&vm->stack)->body = body;
+    return true;
+}
+
+// A list evaluated over several steps may have moved to the heap in part: reversed, its cells
+// point to younger ones.
+static void note_list_writes(VirtualMachine *vm, Object *list) {
+    for (auto it = list; TYPE_LIST == it->type; it = it->as_list.rest) {
+        allocator_note_write(&vm->allocator, it);
+    }
+}
+
 static bool try_step_call(VirtualMachine *vm) {
     guard_is_not_null(vm);
 
@@ -220,15 +280,11 @@ static bool try_step_call(VirtualMachine *vm) {
             binding_error(vm, error);
         }
 
-        stack_swap_top(s, frame_make(
-                FRAME_DO,
-                frame->expr,
-                frame->env,
-                frame->results_list,
-                OBJECT_NIL
-        ));
+        auto expansion = frame_make(FRAME_DO, frame->expr, frame->env, frame->results_list, OBJECT_NIL);
+        expansion.body = frame->body;
+        swap_top_frame(vm, expansion);
 
-        return try_begin_eval(
+        return try_begin_body(
                 vm, EVAL_FRAME_KEEP,
                 *arg_bindings, fn->as_closure.body,
                 &frame->unevaluated
@@ -247,6 +303,7 @@ static bool try_step_call(VirtualMachine *vm) {
         object_list_concat_inplace(extra_args, object_list_skip(1, frame->evaluated));
 
         frame->evaluated = object_list_nth(0, frame->evaluated);
+        note_list_writes(vm, frame->evaluated);
         frame->unevaluated = OBJECT_NIL;
 
         return true;
@@ -276,6 +333,7 @@ static bool try_step_call(VirtualMachine *vm) {
     }
 
     object_list_reverse_inplace(&frame->evaluated);
+    note_list_writes(vm, frame->evaluated);
     guard_is_not_equal(frame->evaluated, OBJECT_NIL);
 
     auto const fn = object_as_list(frame->evaluated).first;
@@ -287,10 +345,30 @@ static bool try_step_call(VirtualMachine *vm) {
             stack_overflow_error(vm);
         }
 
-        if (false == fn->as_primitive(vm, actual_args, value)) {
+        // Recorded as the task that made the call, which other tasks may run during.
+        auto const trace = vm->config.trace;
+        size_t index;
+        auto const is_traced = nullptr != trace && primitive_try_get_index(fn->as_primitive, &index);
+        auto const task = is_traced ? tasks_running_id(&vm->tasks) : 0;
+        if (is_traced) {
+            trace_record(trace, TRACE_PRIMITIVE_BEGIN, task, (uint32_t) index);
+        }
+
+        auto const ok = fn->as_primitive(vm, actual_args, value);
+        if (is_traced) {
+            trace_record(trace, TRACE_PRIMITIVE_END, task, (uint32_t) index);
+        }
+        if (false == ok) {
             return false;
         }
 
+        // `join` waits for a task: the call is made again when the running task resumes.
+        if (tasks_is_blocked(&vm->tasks)) {
+            object_list_reverse_inplace(&frame->evaluated);
+            note_list_writes(vm, frame->evaluated);
+            return true;
+        }
+
         return try_save_result_and_pop(vm, frame->results_list, *value);
     }
 
@@ -313,7 +391,7 @@ static bool try_step_call(VirtualMachine *vm) {
         binding_error(vm, error);
     }
 
-    return try_begin_eval(vm, EVAL_FRAME_REMOVE, *arg_bindings, fn->as_closure.body, frame->results_list);
+    return try_begin_body(vm, EVAL_FRAME_REMOVE, *arg_bindings, fn->as_closure.body, frame->results_list);
 }
 
 static bool is_parameters_declaration_valid(Object *args) {
@@ -466,6 +544,66 @@ static bool try_step_define(VirtualMachine *vm) {
     return try_save_result_and_pop(vm, frame->results_list, value);
 }
 
+// Evaluates the forms of the module at `index` below the import frame, which marks the module
+// evaluated once they all are: a module that fails is evaluated again by the next import.
+static bool try_begin_import_eval(VirtualMachine *vm, size_t index) {
+    guard_is_not_null(vm);
+
+    auto const s = &vm->stack;
+    auto const a = &vm->allocator;
+    auto const frame = stack_top(s);
+
+    Object **body;
+    if (false == stack_try_create_local(stack_locals(s), &body)) {
+        stack_overflow_error(vm);
+    }
+
+    auto const forms = object_list_nth(index, vm->module_forms);
+    if (false == object_try_make_list(a, SYMBOL_DO, forms, body)) {
+        out_of_memory_error(vm);
+    }
+    if (false == object_try_make_int(a, (int64_t) index, &frame->unevaluated)) {
+        out_of_memory_error(vm);
+    }
+
+    return try_begin_eval(vm, EVAL_FRAME_KEEP, frame->env, *body, &frame->evaluated);
+}
+
+static bool try_import_store(
+        VirtualMachine *vm,
+        Module module,
+        bool is_cached,
+        size_t index,
+        Object *exprs
+) {
+    guard_is_not_null(vm);
+    guard_is_not_null(exprs);
+
+    auto const modules = &vm->modules;
+    // Set once the forms are evaluated in the global scope, see `try_begin_import_eval`.
+    module.is_evaluated = false;
+
+    if (is_cached) {
+        module_free(&modules->data[index]);
+        modules->data[index] = module;
+        *object_list_nth_mutable(index, vm->module_forms) = exprs;
+        allocator_note_write(&vm->allocator, object_list_skip(index, vm->module_forms));
+        return true;
+    }
+
+    errno_t error_code;
+    if (false == modules_try_append(modules, module, &error_code)) {
+        return false;
+    }
+
+    if (object_list_try_append_inplace(&vm->allocator, exprs, &vm->module_forms)) {
+        return true;
+    }
+
+    modules->count--;
+    return false;
+}
+
 static bool try_step_import(VirtualMachine *vm) {
     guard_is_not_null(vm);
 
@@ -474,6 +612,14 @@ static bool try_step_import(VirtualMachine *vm) {
     auto const frame = stack_top(s);
     guard_is_equal(frame->type, FRAME_IMPORT);
 
+    // The forms of the module were evaluated: `unevaluated` is its index.
+    if (OBJECT_NIL != frame->evaluated) {
+        if (vm->globals == frame->env) {
+            vm->modules.data[frame->unevaluated->as_int].is_evaluated = true;
+        }
+        return try_save_result_and_pop(vm, frame->results_list, object_as_list(frame->evaluated).first);
+    }
+
     size_t const expected = 1;
     if (expected != object_list_count(frame->unevaluated)) {
         special_syntax_error(vm, "import", "(import path)");
@@ -489,23 +635,57 @@ static bool try_step_import(VirtualMachine *vm) {
         stack_overflow_error(vm);
     }
 
+    errno_t error_code;
+    Module module;
+    if (false == module_try_stat(file_name->as_string, &module, &error_code)) {
+        os_error(vm, error_code);
+    }
+
+    auto const modules = &vm->modules;
+    size_t index;
+    auto const is_cached = modules_find(modules, module.path, &index);
+    if (is_cached && module_is_unchanged(&modules->data[index], &module)) {
+        module_free(&module);
+        modules->statistics.hits++;
+        modules->statistics.parse_ns_saved += modules->data[index].parse_ns;
+
+        // Already evaluated in the global scope: its definitions are there.
+        if (vm->globals == frame->env && modules->data[index].is_evaluated) {
+            return try_save_result_and_pop(vm, frame->results_list, OBJECT_NIL);
+        }
+        return try_begin_import_eval(vm, index);
+    }
+
     NamedFile file;
     if (false == named_file_try_open(file_name->as_string, "rb", &file)) {
-        os_error(vm, errno);
+        error_code = errno;
+        module_free(&module);
+        os_error(vm, error_code);
     }
 
+    auto const parse_start = modules_clock_ns();
     auto const read_ok = object_reader_try_read_all(&vm->reader, file, exprs);
     named_file_close(&file);
     if (false == read_ok) {
+        module_free(&module);
         return false;
     }
 
     if (false == object_list_try_append_inplace(a, OBJECT_NIL, exprs)) {
+        module_free(&module);
         out_of_memory_error(vm);
     }
 
-    stack_swap_top(s, frame_make(FRAME_DO, frame->expr, frame->env, frame->results_list, *exprs));
-    return true;
+    module.parse_ns = modules_clock_ns() - parse_start;
+    modules->statistics.misses++;
+    modules->statistics.parse_ns += module.parse_ns;
+
+    if (false == try_import_store(vm, module, is_cached, index, *exprs)) {
+        module_free(&module);
+        out_of_memory_error(vm);
+    }
+
+    return try_begin_import_eval(vm, is_cached ? index : modules->count - 1);
 }
 
 static bool try_step_quote(VirtualMachine *vm) {
@@ -689,13 +869,12 @@ static bool try_step(VirtualMachine *vm) {
     guard_unreachable();
 }
 
-bool try_eval(VirtualMachine *vm, Object *env, Object *expr) {
-    guard_is_not_null(vm);
-    guard_is_not_null(env);
-    guard_is_not_null(expr);
-
+static bool try_eval_(VirtualMachine *vm, Object *env, Object *expr) {
     auto const s = &vm->stack;
+    auto const tasks = &vm->tasks;
+    auto const profiler = vm->config.profiler;
     guard_is_true(stack_is_empty(s));
+    guard_is_true(tasks_is_main_running(tasks));
 
     vm->value = OBJECT_NIL;
     vm->error = OBJECT_NIL;
@@ -703,13 +882,35 @@ bool try_eval(VirtualMachine *vm, Object *env, Object *expr) {
         return false;
     }
 
-    while (false == stack_is_empty(s)) {
+    // The stack is the running task's: the loop ends when it is the main task's and empty.
+    while (true) {
+        // Between steps, every object in use is in a frame, its locals, a task or the VM.
+        allocator_safepoint(&vm->allocator);
+
+        if (stack_is_empty(s)) {
+            if (tasks_is_main_running(tasks)) {
+                break;
+            }
+
+            tasks_finish(vm, false);
+            continue;
+        }
+
         if (try_step(vm)) {
+            if (nullptr != profiler && profiler_is_due()) {
+                profiler_sample(profiler, s, tasks_is_main_running(tasks));
+            }
+            if (tasks_should_switch(tasks)) {
+                tasks_switch(vm);
+            }
             continue;
         }
 
         auto const error_frame = stack_top(s);
         guard_is_not_equal(vm->error, OBJECT_NIL);
+        if (nullptr != vm->config.trace) {
+            trace_record(vm->config.trace, TRACE_ERROR, tasks_running_id(tasks), 0);
+        }
 
         while (false == stack_is_empty(s)) {
             auto const current_frame = stack_top(s);
@@ -717,11 +918,16 @@ bool try_eval(VirtualMachine *vm, Object *env, Object *expr) {
                 break;
             }
 
-            stack_pop(s);
+            pop_frame(vm);
         }
 
         if (stack_is_empty(s)) {
-            return false;
+            if (tasks_is_main_running(tasks)) {
+                return false;
+            }
+
+            tasks_finish(vm, true);
+            continue;
         }
 
         if (FRAME_CATCH == stack_top(s)->type) {
@@ -735,3 +941,15 @@ bool try_eval(VirtualMachine *vm, Object *env, Object *expr) {
     vm->value = object_as_list(vm->value).first;
     return true;
 }
+
+// Objects only move within `try_eval_`: the caller's are older than the nursery.
+bool try_eval(VirtualMachine *vm, Object *env, Object *expr) {
+    guard_is_not_null(vm);
+    guard_is_not_null(env);
+    guard_is_not_null(expr);
+
+    allocator_open_nursery(&vm->allocator);
+    auto const ok = try_eval_(vm, env, expr);
+    allocator_close_nursery(&vm->allocator);
+    return ok;
+}
@@ -0,0 +1,451 @@
+#include "files.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utility/guards.h"
+#include "utility/exchange.h"
+#include "object/constructors.h"
+#include "object/list.h"
+#include "virtual_machine.h"
+#include "tasks.h"
+#include "errors.h"
+
+#define FILES_DEFAULT_THREADS 4
+#define FILES_MIN_BUFFER_SIZE 4096
+
+typedef enum {
+    FILES_READ,
+    FILES_WRITE,
+} Files_Operation;
+
+typedef struct Files_Job Files_Job;
+
+struct Files_Job {
+    Files_Operation operation;
+    char *path;
+    // The contents to write, or those read, null-terminated.
+    char *data;
+    size_t size;
+    errno_t error_code;
+    Task *task;
+
+    // Links the job into the queue while it waits for a thread.
+    Files_Job *next_queued;
+    // Links the job into the jobs of the pool until its task collects it.
+    Files_Job *prev;
+    Files_Job *next;
+};
+
+struct Files {
+    Tasks *tasks;
+
+    pthread_mutex_t lock;
+    pthread_cond_t has_work;
+    Files_Job *queue_head;
+    Files_Job *queue_tail;
+    Files_Job *jobs;
+    bool is_stopping;
+
+    pthread_t *threads;
+    size_t count;
+};
+
+static void job_free(Files_Job *job) {
+    free(job->data);
+    free(job->path);
+    free(job);
+}
+
+static void read_file(Files_Job *job) {
+    errno = 0;
+    auto const fd = open(job->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        job->error_code = errno;
+        return;
+    }
+
+    // Files in `/proc` and pipes report no size: the buffer grows as needed.
+    struct stat st;
+    size_t capacity = FILES_MIN_BUFFER_SIZE;
+    if (0 == fstat(fd, &st) && st.st_size >= FILES_MIN_BUFFER_SIZE) {
+        capacity = (size_t) st.st_size + 1;
+    }
+
+    char *data = malloc(capacity);
+    size_t size = 0;
+    while (nullptr != data) {
+        if (size + 1 == capacity) {
+            capacity *= 2;
+            auto const grown = (char *) realloc(data, capacity);
+            if (nullptr == grown) {
+                free(data);
+                data = nullptr;
+                break;
+            }
+            data = grown;
+        }
+
+        auto const got = read(fd, data + size, capacity - 1 - size);
+        if (got < 0) {
+            job->error_code = errno;
+            break;
+        }
+        if (0 == got) {
+            break;
+        }
+        size += (size_t) got;
+    }
+    if (nullptr == data) {
+        job->error_code = ENOMEM;
+    }
+    close(fd);
+
+    if (0 != job->error_code) {
+        free(data);
+        return;
+    }
+
+    data[size] = '\0';
+    job->data = data;
+    job->size = size;
+}
+
+static void write_file(Files_Job *job) {
+    errno = 0;
+    auto const fd = open(job->path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        job->error_code = errno;
+        return;
+    }
+
+    size_t written = 0;
+    while (written < job->size) {
+        auto const put = write(fd, job->data + written, job->size - written);
+        if (put < 0) {
+            job->error_code = errno;
+            break;
+        }
+        written += (size_t) put;
+    }
+
+    if (0 != close(fd) && 0 == job->error_code) {
+        job->error_code = errno;
+    }
+}
+
+static void *run_thread(void *arg) {
+    Files *files = arg;
+
+    pthread_mutex_lock(&files->lock);
+    while (true) {
+        while (nullptr == files->queue_head && false == files->is_stopping) {
+            pthread_cond_wait(&files->has_work, &files->lock);
+        }
+
+        auto const job = files->queue_head;
+        if (nullptr == job) {
+            break;
+        }
+        files->queue_head = job->next_queued;
+        if (nullptr == files->queue_head) {
+            files->queue_tail = nullptr;
+        }
+        pthread_mutex_unlock(&files->lock);
+
+        switch (job->operation) {
+            case FILES_READ: {
+                read_file(job);
+                break;
+            }
+            case FILES_WRITE: {
+                write_file(job);
+                break;
+            }
+        }
+        tasks_wake(files->tasks, job->task, job);
+
+        pthread_mutex_lock(&files->lock);
+    }
+    pthread_mutex_unlock(&files->lock);
+
+    return nullptr;
+}
+
+// Starts the threads of the pool, and the pool itself the first time; the jobs of a pool that
+// was stopped are still to be collected by their tasks.
+static bool try_start(VirtualMachine *vm, Files **files) {
+    if (nullptr != vm->files && vm->files->count > 0) {
+        *files = vm->files;
+        return true;
+    }
+
+    auto const count = 0 == vm->config.file_threads ? FILES_DEFAULT_THREADS : vm->config.file_threads;
+    if (nullptr == vm->files) {
+        auto const pool = (Files *) calloc(1, sizeof(Files));
+        auto const threads = (pthread_t *) calloc(count, sizeof(pthread_t));
+        if (nullptr == pool || nullptr == threads) {
+            free(threads);
+            free(pool);
+            out_of_memory_error(vm);
+        }
+
+        pthread_mutex_init(&pool->lock, nullptr);
+        pthread_cond_init(&pool->has_work, nullptr);
+        pool->tasks = &vm->tasks;
+        pool->threads = threads;
+        vm->files = pool;
+    }
+
+    auto const pool = vm->files;
+    for (size_t i = 0; i < count; i++) {
+        errno_t const error_code = pthread_create(&pool->threads[i], nullptr, run_thread, pool);
+        if (0 != error_code) {
+            files_stop(pool);
+            os_error(vm, error_code);
+        }
+
+        pool->count = i + 1;
+    }
+
+    *files = pool;
+    return true;
+}
+
+void files_stop(Files *files) {
+    if (nullptr == files) {
+        return;
+    }
+
+    pthread_mutex_lock(&files->lock);
+    files->is_stopping = true;
+    pthread_cond_broadcast(&files->has_work);
+    pthread_mutex_unlock(&files->lock);
+
+    for (size_t i = 0; i < files->count; i++) {
+        pthread_join(files->threads[i], nullptr);
+    }
+    files->count = 0;
+    files->is_stopping = false;
+}
+
+void files_free(Files *files) {
+    if (nullptr == files) {
+        return;
+    }
+
+    files_stop(files);
+
+    // Done, but their tasks never resumed.
+    for (auto job = files->jobs; nullptr != job;) {
+        auto const next = job->next;
+        job_free(job);
+        job = next;
+    }
+
+    pthread_cond_destroy(&files->has_work);
+    pthread_mutex_destroy(&files->lock);
+    free(files->threads);
+    free(files);
+}
+
+static bool try_submit(VirtualMachine *vm, Files_Operation operation, Object *path, Object *contents) {
+    Files *pool;
+    if (false == try_start(vm, &pool)) {
+        return false;
+    }
+
+    auto const job = (Files_Job *) calloc(1, sizeof(Files_Job));
+    if (nullptr == job) {
+        out_of_memory_error(vm);
+    }
+
+    job->operation = operation;
+    job->path = strdup(path->as_string);
+    if (nullptr != contents) {
+        job->size = strlen(contents->as_string);
+        job->data = strdup(contents->as_string);
+    }
+    if (nullptr == job->path || (nullptr != contents && nullptr == job->data)) {
+        job_free(job);
+        out_of_memory_error(vm);
+    }
+
+    job->task = tasks_suspend(vm, nullptr, nullptr);
+
+    pthread_mutex_lock(&pool->lock);
+    job->next = pool->jobs;
+    if (nullptr != pool->jobs) {
+        pool->jobs->prev = job;
+    }
+    pool->jobs = job;
+
+    if (nullptr == pool->queue_tail) {
+        pool->queue_head = job;
+    } else {
+        pool->queue_tail->next_queued = job;
+    }
+    pool->queue_tail = job;
+    pthread_cond_signal(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    return true;
+}
+
+static Files_Job *collect(VirtualMachine *vm, void *wakeup) {
+    auto const pool = vm->files;
+    Files_Job *job = wakeup;
+
+    pthread_mutex_lock(&pool->lock);
+    if (nullptr != job->prev) {
+        job->prev->next = job->next;
+    } else {
+        pool->jobs = job->next;
+    }
+    if (nullptr != job->next) {
+        job->next->prev = job->prev;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return job;
+}
+
+// The first call submits the operation and suspends the running task; the call is made again
+// when the task resumes, and then returns the finished job.
+static bool try_run(
+        VirtualMachine *vm,
+        Files_Operation operation,
+        Object *path,
+        Object *contents,
+        Files_Job **job
+) {
+    if (TYPE_STRING != path->type) {
+        type_error(vm, path->type, TYPE_STRING);
+    }
+    if (nullptr != contents && TYPE_STRING != contents->type) {
+        type_error(vm, contents->type, TYPE_STRING);
+    }
+
+    void *wakeup;
+    if (tasks_try_take_wakeup(&vm->tasks, &wakeup)) {
+        *job = collect(vm, wakeup);
+        return true;
+    }
+
+    *job = nullptr;
+    return try_submit(vm, operation, path, contents);
+}
+
+bool files_try_read(VirtualMachine *vm, Object *path, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(path);
+    guard_is_not_null(value);
+
+    Files_Job *job;
+    if (false == try_run(vm, FILES_READ, path, nullptr, &job)) {
+        return false;
+    }
+
+    *value = OBJECT_NIL;
+    if (nullptr == job) {
+        return true;
+    }
+
+    auto const error_code = job->error_code;
+    auto const ok = 0 == error_code && object_try_make_string(&vm->allocator, job->data, value);
+    job_free(job);
+    if (0 != error_code) {
+        os_error(vm, error_code);
+    }
+    if (false == ok) {
+        out_of_memory_error(vm);
+    }
+
+    return true;
+}
+
+// Builds the list in place, so that `lines` keeps every string reachable.
+static bool try_make_lines(VirtualMachine *vm, char *data, Object **lines) {
+    auto const a = &vm->allocator;
+    *lines = OBJECT_NIL;
+
+    auto line = data;
+    while ('\0' != *line) {
+        auto const end = strchr(line, '\n');
+        if (nullptr != end) {
+            *end = '\0';
+        }
+
+        if (false == object_try_make_list(a, OBJECT_NIL, *lines, lines)) {
+            return false;
+        }
+        if (false == object_try_make_string(a, line, &(*lines)->as_list.first)) {
+            return false;
+        }
+
+        if (nullptr == end) {
+            break;
+        }
+        line = end + 1;
+    }
+
+    object_list_reverse_inplace(lines);
+    return true;
+}
+
+bool files_try_read_lines(VirtualMachine *vm, Object *path, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(path);
+    guard_is_not_null(value);
+
+    Files_Job *job;
+    if (false == try_run(vm, FILES_READ, path, nullptr, &job)) {
+        return false;
+    }
+
+    *value = OBJECT_NIL;
+    if (nullptr == job) {
+        return true;
+    }
+
+    auto const error_code = job->error_code;
+    auto const ok = 0 == error_code && try_make_lines(vm, job->data, value);
+    job_free(job);
+    if (0 != error_code) {
+        os_error(vm, error_code);
+    }
+    if (false == ok) {
+        out_of_memory_error(vm);
+    }
+
+    return true;
+}
+
+bool files_try_write(VirtualMachine *vm, Object *path, Object *contents, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(path);
+    guard_is_not_null(contents);
+    guard_is_not_null(value);
+
+    Files_Job *job;
+    if (false == try_run(vm, FILES_WRITE, path, contents, &job)) {
+        return false;
+    }
+
+    *value = OBJECT_NIL;
+    if (nullptr == job) {
+        return true;
+    }
+
+    auto const error_code = job->error_code;
+    job_free(job);
+    if (0 != error_code) {
+        os_error(vm, error_code);
+    }
+
+    return true;
+}
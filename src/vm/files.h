@@ -0,0 +1,30 @@
+#pragma once
+
+#include "object/object.h"
+
+// Reads and writes whole files on a pool of threads, so that the evaluator never blocks on
+// them: a call suspends the running task (see `tasks.h`) until its file is done, and other
+// tasks run meanwhile. Outside of spawned tasks, a call simply waits.
+
+struct VirtualMachine;
+
+typedef struct Files Files;
+
+// Returns the contents of the file at `path` as a string.
+[[nodiscard]]
+bool files_try_read(struct VirtualMachine *vm, Object *path, Object **value);
+
+// Returns the lines of the file at `path` as a list of strings, without line endings.
+[[nodiscard]]
+bool files_try_read_lines(struct VirtualMachine *vm, Object *path, Object **value);
+
+// Replaces the contents of the file at `path` with `contents`, creating the file if needed.
+[[nodiscard]]
+bool files_try_write(struct VirtualMachine *vm, Object *path, Object *contents, Object **value);
+
+// Finishes all submitted operations and stops the threads of the pool, which the next operation
+// starts again; their tasks still collect them. Accepts null.
+void files_stop(Files *files);
+
+// Finishes all submitted operations and stops the pool; accepts null.
+void files_free(Files *files);
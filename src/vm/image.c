@@ -0,0 +1,701 @@
+#include "image.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "utility/guards.h"
+#include "utility/dynamic_array.h"
+#include "object/list.h"
+#include "virtual_machine.h"
+#include "primitives.h"
+
+#define IMAGE_MAGIC "PSMI"
+#define IMAGE_VERSION 4
+#define IMAGE_ALIGNMENT alignof(Object)
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    // See `build_identity`.
+    uint64_t build;
+    uint64_t objects_size;
+    uint64_t globals_scope;
+    uint64_t modules_count;
+} Image_Header;
+
+static uint64_t hash_bytes(uint64_t hash, void const *bytes, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= ((uint8_t const *) bytes)[i];
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+// What an image relies on in the build that saved it: primitives are stored as their index in
+// the table of primitives, so the table is identified by its names, and objects are stored as
+// they are laid out in memory.
+static uint64_t build_identity() {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < primitives_count(); i++) {
+        auto const name = primitive_name(i);
+        hash = hash_bytes(hash, name, strlen(name) + 1);
+    }
+
+    size_t const layout[] = {sizeof(Object), alignof(Object), offsetof(Object, next), TYPE_HANDLE};
+    return hash_bytes(hash, layout, sizeof(layout));
+}
+
+// Followed by `path_length + 1` bytes of the path, padded to `IMAGE_ALIGNMENT`.
+typedef struct {
+    uint64_t forms;
+    uint64_t device;
+    uint64_t inode;
+    int64_t mtime_ns;
+    int64_t size;
+    uint64_t parse_ns;
+    uint32_t path_length;
+    uint32_t is_evaluated;
+} Image_Module;
+
+// Pointers are stored as references: an offset into the objects region or
+// one of the objects that exist in every VM.
+typedef enum {
+    REF_OBJECT,
+    REF_CHARS,
+    REF_NIL,
+    REF_GLOBALS
+} Image_RefKind;
+
+#define REF_KIND_BITS 2
+#define REF_KIND_MASK ((1u << REF_KIND_BITS) - 1)
+
+static_assert(sizeof(uint64_t) == sizeof(Object *));
+static_assert(sizeof(uint64_t) == sizeof(Object_Primitive));
+
+static uint64_t ref_make(Image_RefKind kind, uint64_t offset) {
+    return offset << REF_KIND_BITS | kind;
+}
+
+static size_t align(size_t size) {
+    return (size + IMAGE_ALIGNMENT - 1) / IMAGE_ALIGNMENT * IMAGE_ALIGNMENT;
+}
+
+static size_t chars_offset(void) {
+    return offsetof(Object, as_string) + sizeof(char const *);
+}
+
+static bool has_chars(Object_Type type) {
+    return TYPE_STRING == type || TYPE_SYMBOL == type;
+}
+
+static size_t header_size(Object_Type type) {
+    return has_chars(type) ? chars_offset() : sizeof(Object);
+}
+
+static size_t image_object_size(Object *obj) {
+    if (has_chars(obj->type)) {
+        return align(chars_offset() + strlen(obj->as_string) + 1);
+    }
+
+    return sizeof(Object);
+}
+
+typedef struct {
+    Object *key;
+    uint64_t offset;
+} Image_Slot;
+
+// Open-addressing map from saved objects to their offsets in the image.
+typedef struct {
+    Image_Slot *data;
+    size_t count;
+    size_t capacity;
+} Image_Offsets;
+
+static size_t slot_index(Image_Offsets const *offsets, Object *key) {
+    auto const hash = ((uint64_t) (uintptr_t) key >> 3) * 0x9e3779b97f4a7c15;
+    return (size_t) (hash >> 32) & (offsets->capacity - 1);
+}
+
+static Image_Slot *slot_find(Image_Offsets const *offsets, Object *key) {
+    auto index = slot_index(offsets, key);
+    while (nullptr != offsets->data[index].key && key != offsets->data[index].key) {
+        index = (index + 1) & (offsets->capacity - 1);
+    }
+
+    return &offsets->data[index];
+}
+
+static bool offsets_try_grow(Image_Offsets *offsets, errno_t *error_code) {
+    auto const capacity = 0 == offsets->capacity ? 1024 : offsets->capacity * 2;
+
+    errno = 0;
+    auto const data = (Image_Slot *) calloc(capacity, sizeof(Image_Slot));
+    if (nullptr == data) {
+        *error_code = errno;
+        return false;
+    }
+
+    auto const old = *offsets;
+    *offsets = (Image_Offsets) {.data = data, .count = old.count, .capacity = capacity};
+    for (size_t i = 0; i < old.capacity; i++) {
+        if (nullptr != old.data[i].key) {
+            *slot_find(offsets, old.data[i].key) = old.data[i];
+        }
+    }
+    free(old.data);
+
+    return true;
+}
+
+typedef struct {
+    VirtualMachine *vm;
+    Image_Offsets offsets;
+    Objects order;
+    uint64_t size;
+} Image_Writer;
+
+static bool is_shared(Image_Writer const *w, Object *obj) {
+    return OBJECT_NIL == obj || w->vm->globals == obj;
+}
+
+static bool try_visit(Image_Writer *w, Object *obj, errno_t *error_code) {
+    if (is_shared(w, obj)) {
+        return true;
+    }
+
+    if (2 * (w->offsets.count + 1) > w->offsets.capacity) {
+        if (false == offsets_try_grow(&w->offsets, error_code)) {
+            return false;
+        }
+    }
+
+    auto const slot = slot_find(&w->offsets, obj);
+    if (nullptr != slot->key) {
+        return true;
+    }
+
+    if (TYPE_PRIMITIVE == obj->type) {
+        size_t unused;
+        if (false == primitive_try_get_index(obj->as_primitive, &unused)) {
+            *error_code = EINVAL;
+            return false;
+        }
+    }
+
+    // Native resources do not outlive the process.
+    if (TYPE_HANDLE == obj->type) {
+        *error_code = EINVAL;
+        return false;
+    }
+
+    if (false == da_try_append(&w->order, obj)) {
+        *error_code = errno;
+        return false;
+    }
+
+    *slot = (Image_Slot) {.key = obj, .offset = w->size};
+    w->offsets.count++;
+    w->size += image_object_size(obj);
+
+    return true;
+}
+
+static bool try_visit_children(Image_Writer *w, Object *obj, errno_t *error_code) {
+    switch (obj->type) {
+        case TYPE_NIL:
+        case TYPE_INT:
+        case TYPE_STRING:
+        case TYPE_SYMBOL:
+        case TYPE_PRIMITIVE: {
+            return true;
+        }
+        case TYPE_LIST: {
+            return try_visit(w, obj->as_list.first, error_code)
+                   && try_visit(w, obj->as_list.rest, error_code);
+        }
+        case TYPE_CLOSURE:
+        case TYPE_MACRO: {
+            return try_visit(w, obj->as_closure.env, error_code)
+                   && try_visit(w, obj->as_closure.args, error_code)
+                   && try_visit(w, obj->as_closure.body, error_code);
+        }
+        case TYPE_DICT: {
+            return try_visit(w, obj->as_dict.key, error_code)
+                   && try_visit(w, obj->as_dict.value, error_code)
+                   && try_visit(w, obj->as_dict.left, error_code)
+                   && try_visit(w, obj->as_dict.right, error_code);
+        }
+        case TYPE_HANDLE: {
+            guard_unreachable();
+        }
+    }
+
+    guard_unreachable();
+}
+
+static uint64_t ref_of(Image_Writer const *w, Object *obj) {
+    if (OBJECT_NIL == obj) {
+        return ref_make(REF_NIL, 0);
+    }
+
+    if (w->vm->globals == obj) {
+        return ref_make(REF_GLOBALS, 0);
+    }
+
+    auto const slot = slot_find(&w->offsets, obj);
+    guard_is_not_null(slot->key);
+    return ref_make(REF_OBJECT, slot->offset);
+}
+
+static void write_ref(void *field, uint64_t ref) {
+    memcpy(field, &ref, sizeof(ref));
+}
+
+static void write_object(Image_Writer const *w, Object *obj, char *region) {
+    auto const offset = slot_find(&w->offsets, obj)->offset;
+
+    auto image_obj = (Object) {
+            .size = image_object_size(obj),
+            .color = OBJECT_IMAGE,
+            .next = nullptr,
+            .type = obj->type
+    };
+
+    switch (obj->type) {
+        case TYPE_NIL: {
+            break;
+        }
+        case TYPE_INT: {
+            image_obj.as_int = obj->as_int;
+            break;
+        }
+        case TYPE_STRING:
+        case TYPE_SYMBOL: {
+            write_ref(&image_obj.as_string, ref_make(REF_CHARS, offset + chars_offset()));
+            strcpy(region + offset + chars_offset(), obj->as_string);
+            break;
+        }
+        case TYPE_LIST: {
+            write_ref(&image_obj.as_list.first, ref_of(w, obj->as_list.first));
+            write_ref(&image_obj.as_list.rest, ref_of(w, obj->as_list.rest));
+            break;
+        }
+        case TYPE_PRIMITIVE: {
+            size_t index;
+            auto const found = primitive_try_get_index(obj->as_primitive, &index);
+            guard_is_true(found);
+            write_ref(&image_obj.as_primitive, index);
+            break;
+        }
+        case TYPE_CLOSURE:
+        case TYPE_MACRO: {
+            write_ref(&image_obj.as_closure.env, ref_of(w, obj->as_closure.env));
+            write_ref(&image_obj.as_closure.args, ref_of(w, obj->as_closure.args));
+            write_ref(&image_obj.as_closure.body, ref_of(w, obj->as_closure.body));
+            break;
+        }
+        case TYPE_DICT: {
+            image_obj.as_dict.height = obj->as_dict.height;
+            image_obj.as_dict.size = obj->as_dict.size;
+            write_ref(&image_obj.as_dict.key, ref_of(w, obj->as_dict.key));
+            write_ref(&image_obj.as_dict.value, ref_of(w, obj->as_dict.value));
+            write_ref(&image_obj.as_dict.left, ref_of(w, obj->as_dict.left));
+            write_ref(&image_obj.as_dict.right, ref_of(w, obj->as_dict.right));
+            break;
+        }
+        case TYPE_HANDLE: {
+            guard_unreachable();
+        }
+    }
+
+    memcpy(region + offset, &image_obj, header_size(obj->type));
+}
+
+static bool try_write_all(FILE *file, void const *data, size_t size, errno_t *error_code) {
+    errno = 0;
+    if (size == fwrite(data, 1, size, file)) {
+        return true;
+    }
+
+    *error_code = 0 == errno ? EIO : errno;
+    return false;
+}
+
+static bool try_write_modules(Image_Writer const *w, FILE *file, errno_t *error_code) {
+    auto const modules = &w->vm->modules;
+    char const padding[IMAGE_ALIGNMENT] = {0};
+
+    auto forms = w->vm->module_forms;
+    for (size_t i = 0; i < modules->count; i++) {
+        auto const module = &modules->data[i];
+        auto const path_length = strlen(module->path);
+
+        auto const record = (Image_Module) {
+                .forms = ref_of(w, object_list_shift(&forms)),
+                .device = (uint64_t) module->device,
+                .inode = (uint64_t) module->inode,
+                .mtime_ns = module->mtime_ns,
+                .size = (int64_t) module->size,
+                .parse_ns = module->parse_ns,
+                .path_length = (uint32_t) path_length,
+                .is_evaluated = module->is_evaluated
+        };
+
+        auto const ok = try_write_all(file, &record, sizeof(record), error_code)
+                        && try_write_all(file, module->path, path_length + 1, error_code)
+                        && try_write_all(file, padding, align(path_length + 1) - (path_length + 1), error_code);
+        if (false == ok) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool try_save(Image_Writer *w, char const *path, errno_t *error_code) {
+    auto const vm = w->vm;
+    guard_is_equal(vm->globals->type, TYPE_LIST);
+    guard_is_equal(vm->globals->as_list.rest, OBJECT_NIL);
+
+    auto const scope = vm->globals->as_list.first;
+    if (false == try_visit(w, scope, error_code)) {
+        return false;
+    }
+
+    object_list_for(forms, vm->module_forms) {
+        if (false == try_visit(w, forms, error_code)) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < w->order.count; i++) {
+        if (false == try_visit_children(w, w->order.data[i], error_code)) {
+            return false;
+        }
+    }
+
+    errno = 0;
+    auto const region = (char *) calloc(w->size + 1, 1);
+    if (nullptr == region) {
+        *error_code = errno;
+        return false;
+    }
+
+    for (size_t i = 0; i < w->order.count; i++) {
+        write_object(w, w->order.data[i], region);
+    }
+
+    auto const header = (Image_Header) {
+            .magic = IMAGE_MAGIC,
+            .version = IMAGE_VERSION,
+            .build = build_identity(),
+            .objects_size = w->size,
+            .globals_scope = ref_of(w, scope),
+            .modules_count = vm->modules.count
+    };
+
+    errno = 0;
+    auto const file = fopen(path, "wb");
+    if (nullptr == file) {
+        *error_code = errno;
+        free(region);
+        return false;
+    }
+
+    auto ok = try_write_all(file, &header, sizeof(header), error_code)
+              && try_write_all(file, region, w->size, error_code)
+              && try_write_modules(w, file, error_code);
+    free(region);
+
+    if (0 != fclose(file) && ok) {
+        *error_code = errno;
+        ok = false;
+    }
+
+    return ok;
+}
+
+bool image_try_save(VirtualMachine *vm, char const *path, errno_t *error_code) {
+    guard_is_not_null(vm);
+    guard_is_not_null(path);
+    guard_is_not_null(error_code);
+
+    auto w = (Image_Writer) {.vm = vm};
+    auto const ok = try_save(&w, path, error_code);
+    free(w.offsets.data);
+    da_free(&w.order);
+
+    return ok;
+}
+
+typedef struct {
+    VirtualMachine *vm;
+    char *region;
+    uint64_t size;
+} Image_Loader;
+
+static bool try_resolve(Image_Loader const *l, void *field) {
+    uint64_t ref;
+    memcpy(&ref, field, sizeof(ref));
+
+    auto const offset = ref >> REF_KIND_BITS;
+    void *resolved;
+    switch ((Image_RefKind) (ref & REF_KIND_MASK)) {
+        case REF_OBJECT: {
+            if (offset % IMAGE_ALIGNMENT != 0 || offset + chars_offset() > l->size) {
+                return false;
+            }
+            resolved = l->region + offset;
+            break;
+        }
+        case REF_CHARS: {
+            if (offset >= l->size) {
+                return false;
+            }
+            resolved = l->region + offset;
+            break;
+        }
+        case REF_NIL: {
+            resolved = OBJECT_NIL;
+            break;
+        }
+        case REF_GLOBALS: {
+            resolved = l->vm->globals;
+            break;
+        }
+        default: {
+            return false;
+        }
+    }
+
+    memcpy(field, &resolved, sizeof(resolved));
+    return true;
+}
+
+static bool try_relocate_object(Image_Loader const *l, Object *obj) {
+    switch (obj->type) {
+        case TYPE_NIL:
+        case TYPE_INT: {
+            return true;
+        }
+        case TYPE_STRING:
+        case TYPE_SYMBOL: {
+            return try_resolve(l, &obj->as_string);
+        }
+        case TYPE_LIST: {
+            return try_resolve(l, &obj->as_list.first)
+                   && try_resolve(l, &obj->as_list.rest);
+        }
+        case TYPE_PRIMITIVE: {
+            uint64_t index;
+            memcpy(&index, &obj->as_primitive, sizeof(index));
+            return primitive_try_get(index, &obj->as_primitive);
+        }
+        case TYPE_CLOSURE:
+        case TYPE_MACRO: {
+            return try_resolve(l, &obj->as_closure.env)
+                   && try_resolve(l, &obj->as_closure.args)
+                   && try_resolve(l, &obj->as_closure.body);
+        }
+        case TYPE_DICT: {
+            return try_resolve(l, &obj->as_dict.key)
+                   && try_resolve(l, &obj->as_dict.value)
+                   && try_resolve(l, &obj->as_dict.left)
+                   && try_resolve(l, &obj->as_dict.right);
+        }
+        case TYPE_HANDLE: {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+static bool try_relocate(Image_Loader const *l) {
+    uint64_t offset = 0;
+    while (offset < l->size) {
+        auto const obj = (Object *) (l->region + offset);
+        if (l->size - offset < chars_offset() || obj->size < chars_offset() || obj->size > l->size - offset) {
+            return false;
+        }
+
+        if (OBJECT_IMAGE != obj->color || false == try_relocate_object(l, obj)) {
+            return false;
+        }
+
+        offset += obj->size;
+    }
+
+    return true;
+}
+
+static bool try_restore_modules(
+        Image_Loader const *l,
+        char const *records,
+        char const *end,
+        uint64_t count,
+        errno_t *error_code
+) {
+    auto const vm = l->vm;
+
+    for (uint64_t i = 0; i < count; i++) {
+        Image_Module record;
+        if ((size_t) (end - records) < sizeof(record)) {
+            *error_code = EINVAL;
+            return false;
+        }
+        memcpy(&record, records, sizeof(record));
+        records += sizeof(record);
+
+        auto const path_size = align(record.path_length + 1);
+        if ((size_t) (end - records) < path_size || '\0' != records[record.path_length]) {
+            *error_code = EINVAL;
+            return false;
+        }
+
+        Object *forms;
+        if (false == try_resolve(l, &record.forms)) {
+            *error_code = EINVAL;
+            return false;
+        }
+        memcpy(&forms, &record.forms, sizeof(forms));
+
+        errno = 0;
+        auto const path = strdup(records);
+        if (nullptr == path) {
+            *error_code = errno;
+            return false;
+        }
+        records += path_size;
+
+        auto const module = (Module) {
+                .path = path,
+                .device = (dev_t) record.device,
+                .inode = (ino_t) record.inode,
+                .mtime_ns = record.mtime_ns,
+                .size = (off_t) record.size,
+                .parse_ns = record.parse_ns,
+                .is_evaluated = record.is_evaluated
+        };
+        if (false == modules_try_append(&vm->modules, module, error_code)) {
+            free(path);
+            return false;
+        }
+
+        // The list of cached forms is updated in place, so it has to live on the heap.
+        if (false == object_list_try_append_inplace(&vm->allocator, forms, &vm->module_forms)) {
+            *error_code = ENOMEM;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool try_load(VirtualMachine *vm, char const *mapping, size_t mapping_size, errno_t *error_code) {
+    Image_Header header;
+    if (mapping_size < sizeof(header)) {
+        *error_code = EINVAL;
+        return false;
+    }
+    memcpy(&header, mapping, sizeof(header));
+
+    auto const is_valid = 0 == memcmp(header.magic, IMAGE_MAGIC, sizeof(header.magic))
+                          && IMAGE_VERSION == header.version
+                          && build_identity() == header.build
+                          && header.objects_size <= mapping_size - sizeof(header);
+    if (false == is_valid) {
+        *error_code = EINVAL;
+        return false;
+    }
+
+    auto const l = (Image_Loader) {
+            .vm = vm,
+            .region = (char *) mapping + sizeof(header),
+            .size = header.objects_size
+    };
+    if (false == try_relocate(&l)) {
+        *error_code = EINVAL;
+        return false;
+    }
+
+    auto scope = header.globals_scope;
+    if (false == try_resolve(&l, &scope)) {
+        *error_code = EINVAL;
+        return false;
+    }
+    memcpy(&vm->globals->as_list.first, &scope, sizeof(scope));
+
+    return try_restore_modules(
+            &l,
+            l.region + l.size, mapping + mapping_size,
+            header.modules_count,
+            error_code
+    );
+}
+
+bool image_try_load(VirtualMachine *vm, char const *path, errno_t *error_code) {
+    guard_is_not_null(vm);
+    guard_is_not_null(path);
+    guard_is_not_null(error_code);
+    guard_is_equal(vm->modules.count, 0);
+    guard_is_equal(vm->image._mapping, nullptr);
+
+    errno = 0;
+    auto const file = fopen(path, "rb");
+    if (nullptr == file) {
+        *error_code = errno;
+        return false;
+    }
+
+    struct stat st;
+    if (0 != fstat(fileno(file), &st)) {
+        *error_code = errno;
+        fclose(file);
+        return false;
+    }
+
+    auto const mapping_size = (size_t) st.st_size;
+    if (0 == mapping_size) {
+        *error_code = EINVAL;
+        fclose(file);
+        return false;
+    }
+
+    // Pages are private: relocation writes to them, then they are made read-only.
+    auto const mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(file), 0);
+    auto const map_error = errno;
+    fclose(file);
+    if (MAP_FAILED == mapping) {
+        *error_code = map_error;
+        return false;
+    }
+
+    vm->image = (Image) {._mapping = mapping, ._mapping_size = mapping_size};
+    if (false == try_load(vm, mapping, mapping_size, error_code)) {
+        return false;
+    }
+
+    if (0 != mprotect(mapping, mapping_size, PROT_READ)) {
+        *error_code = errno;
+        return false;
+    }
+
+    return true;
+}
+
+void image_free(Image *image) {
+    guard_is_not_null(image);
+
+    if (nullptr != image->_mapping) {
+        munmap(image->_mapping, image->_mapping_size);
+    }
+
+    *image = (Image) {0};
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+
+// A heap image is a snapshot of everything reachable from the global scope and the
+// module cache. Restoring one maps the file and relocates it in place; restored objects
+// are immortal and read-only, but belong to the VM that restored them (see `OBJECT_IMAGE`).
+
+struct VirtualMachine;
+
+typedef struct {
+    void *_mapping;
+    size_t _mapping_size;
+} Image;
+
+[[nodiscard]]
+bool image_try_save(struct VirtualMachine *vm, char const *path, errno_t *error_code);
+
+// Must be called on a freshly initialized VM, before anything is evaluated;
+// the VM can not be used after a failure.
+[[nodiscard]]
+bool image_try_load(struct VirtualMachine *vm, char const *path, errno_t *error_code);
+
+void image_free(Image *image);
@@ -0,0 +1,104 @@
+#include "modules.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "utility/guards.h"
+#include "utility/dynamic_array.h"
+
+#ifdef __APPLE__
+#define stat_mtime(St) ((St).st_mtimespec)
+#else
+#define stat_mtime(St) ((St).st_mtim)
+#endif
+
+bool module_try_stat(char const *path, Module *module, errno_t *error_code) {
+    guard_is_not_null(path);
+    guard_is_not_null(module);
+    guard_is_not_null(error_code);
+
+    errno = 0;
+    auto const canonical_path = realpath(path, nullptr);
+    if (nullptr == canonical_path) {
+        *error_code = errno;
+        return false;
+    }
+
+    struct stat st;
+    if (0 != stat(canonical_path, &st)) {
+        *error_code = errno;
+        free(canonical_path);
+        return false;
+    }
+
+    *module = (Module) {
+            .path = canonical_path,
+            .device = st.st_dev,
+            .inode = st.st_ino,
+            .mtime_ns = (int64_t) stat_mtime(st).tv_sec * 1000000000 + stat_mtime(st).tv_nsec,
+            .size = st.st_size
+    };
+    return true;
+}
+
+bool module_is_unchanged(Module const *cached, Module const *current) {
+    guard_is_not_null(cached);
+    guard_is_not_null(current);
+
+    return cached->device == current->device
+           && cached->inode == current->inode
+           && cached->mtime_ns == current->mtime_ns
+           && cached->size == current->size;
+}
+
+void module_free(Module *module) {
+    guard_is_not_null(module);
+
+    free(module->path);
+    *module = (Module) {0};
+}
+
+bool modules_find(Modules const *modules, char const *path, size_t *index) {
+    guard_is_not_null(modules);
+    guard_is_not_null(path);
+    guard_is_not_null(index);
+
+    for (size_t i = 0; i < modules->count; i++) {
+        if (0 == strcmp(modules->data[i].path, path)) {
+            *index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool modules_try_append(Modules *modules, Module module, errno_t *error_code) {
+    guard_is_not_null(modules);
+    guard_is_not_null(error_code);
+
+    if (da_try_append(modules, module)) {
+        return true;
+    }
+
+    *error_code = errno;
+    return false;
+}
+
+void modules_free(Modules *modules) {
+    guard_is_not_null(modules);
+
+    for (size_t i = 0; i < modules->count; i++) {
+        module_free(&modules->data[i]);
+    }
+    da_free(modules);
+}
+
+uint64_t modules_clock_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
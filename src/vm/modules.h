@@ -0,0 +1,47 @@
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef struct {
+    char *path;
+    dev_t device;
+    ino_t inode;
+    // Nanoseconds since the epoch: a rewrite within the same second still changes it.
+    int64_t mtime_ns;
+    off_t size;
+    uint64_t parse_ns;
+    bool is_evaluated;
+} Module;
+
+typedef struct {
+    size_t hits;
+    size_t misses;
+    uint64_t parse_ns;
+    uint64_t parse_ns_saved;
+} Modules_Statistics;
+
+typedef struct {
+    Module *data;
+    size_t count;
+    size_t capacity;
+    Modules_Statistics statistics;
+} Modules;
+
+[[nodiscard]]
+bool module_try_stat(char const *path, Module *module, errno_t *error_code);
+
+bool module_is_unchanged(Module const *cached, Module const *current);
+
+void module_free(Module *module);
+
+bool modules_find(Modules const *modules, char const *path, size_t *index);
+
+[[nodiscard]]
+bool modules_try_append(Modules *modules, Module module, errno_t *error_code);
+
+void modules_free(Modules *modules);
+
+uint64_t modules_clock_ns();
@@ -0,0 +1,17 @@
+#include "prelude.h"
+
+#include "utility/guards.h"
+#include "object/list.h"
+#include "eval.h"
+
+bool try_define_prelude(VirtualMachine *vm) {
+    guard_is_not_null(vm);
+
+    object_list_for(it, PRELUDE_FORMS) {
+        if (false == try_eval(vm, vm->globals, it)) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "object/object.h"
+#include "virtual_machine.h"
+
+// Top-level forms of the prelude sources, parsed at build time into static objects.
+extern Object *const PRELUDE_FORMS;
+
+[[nodiscard]]
+bool try_define_prelude(VirtualMachine *vm);
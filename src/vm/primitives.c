@@ -9,9 +9,15 @@
 #include "object/accessors.h"
 #include "object/repr.h"
 #include "object/compare.h"
+#include "object/frozen.h"
 #include "env.h"
+#include "stack.h"
 #include "traceback.h"
 #include "errors.h"
+#include "workers.h"
+#include "channels.h"
+#include "tasks.h"
+#include "files.h"
 
 static bool eq(VirtualMachine *vm, Object *args, Object **value) {
     guard_is_not_null(vm);
@@ -121,17 +127,17 @@ static bool print(VirtualMachine *vm, Object *args, Object **value) {
     }
 
     errno_t error_code;
-    if (false == object_try_print(args->as_list.first, stdout, &error_code)) {
+    if (false == object_try_print(args->as_list.first, vm->output, &error_code)) {
         os_error(vm, error_code);
     }
 
     object_list_for(it, args->as_list.rest) {
-        printf(" ");
-        if (false == object_try_print(it, stdout, &error_code)) {
+        fprintf(vm->output, " ");
+        if (false == object_try_print(it, vm->output, &error_code)) {
             os_error(vm, error_code);
         }
     }
-    printf("\n");
+    fprintf(vm->output, "\n");
 
     *value = OBJECT_NIL;
     return true;
@@ -406,7 +412,8 @@ static bool type(VirtualMachine *vm, Object *args, Object **value) {
     }
 
     auto const arg = args->as_list.first;
-    return object_try_make_symbol(&vm->allocator, object_type_str(arg->type), value);
+    auto const name = TYPE_HANDLE == arg->type ? arg->as_handle.class->name : object_type_str(arg->type);
+    return object_try_make_symbol(&vm->allocator, name, value);
 }
 
 static bool traceback(VirtualMachine *vm, Object *args, Object **value) {
@@ -516,15 +523,416 @@ static bool dict_put(VirtualMachine *vm, Object *args, Object **result) {
     out_of_memory_error(vm);
 }
 
+static auto const SYMBOL_HITS = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "hits"};
+static auto const SYMBOL_MISSES = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "misses"};
+static auto const SYMBOL_PARSE_NS = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "parse-ns"};
+static auto const SYMBOL_PARSE_NS_SAVED = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "parse-ns-saved"};
+static auto const SYMBOL_MODULES = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "modules"};
+
+static bool try_put_int(VirtualMachine *vm, Object *key, int64_t value, Object **dict) {
+    Object **int_value;
+    if (false == stack_try_create_local(stack_locals(&vm->stack), &int_value)) {
+        stack_overflow_error(vm);
+    }
+
+    auto const ok = object_try_make_int(&vm->allocator, value, int_value)
+                    && object_dict_try_put(&vm->allocator, *dict, key, *int_value, dict);
+    if (false == ok) {
+        out_of_memory_error(vm);
+    }
+
+    return true;
+}
+
+static bool import_stats(VirtualMachine *vm, Object *args, Object **result) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(result);
+
+    auto const got = object_list_count(args);
+    typeof(got) expected = 0;
+    if (expected != got) {
+        call_args_count_error(vm, "import-stats", expected, got);
+    }
+
+    auto const statistics = vm->modules.statistics;
+    *result = OBJECT_NIL;
+    return try_put_int(vm, SYMBOL_HITS, (int64_t) statistics.hits, result)
+           && try_put_int(vm, SYMBOL_MISSES, (int64_t) statistics.misses, result)
+           && try_put_int(vm, SYMBOL_PARSE_NS, (int64_t) statistics.parse_ns, result)
+           && try_put_int(vm, SYMBOL_PARSE_NS_SAVED, (int64_t) statistics.parse_ns_saved, result)
+           && try_put_int(vm, SYMBOL_MODULES, (int64_t) vm->modules.count, result);
+}
+
+static auto const SYMBOL_COLLECTIONS = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "collections"};
+static auto const SYMBOL_PAUSE_NS_TOTAL = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "pause-ns-total"};
+static auto const SYMBOL_PAUSE_NS_MAX = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "pause-ns-max"};
+static auto const SYMBOL_PAUSE_NS_P50 = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "pause-ns-p50"};
+static auto const SYMBOL_PAUSE_NS_P90 = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "pause-ns-p90"};
+static auto const SYMBOL_PAUSE_NS_P99 = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "pause-ns-p99"};
+static auto const SYMBOL_ALLOCATED_BYTES = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "allocated-bytes"};
+static auto const SYMBOL_ALLOCATED_OBJECTS = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "allocated-objects"};
+static auto const SYMBOL_FREED_BYTES = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "freed-bytes"};
+static auto const SYMBOL_FREED_OBJECTS = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "freed-objects"};
+static auto const SYMBOL_HEAP_BYTES = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "heap-bytes"};
+static auto const SYMBOL_HEAP_BYTES_MAX = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "heap-bytes-max"};
+static auto const SYMBOL_LIVE_BYTES = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "live-bytes"};
+static auto const SYMBOL_LIVE_BYTES_MAX = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "live-bytes-max"};
+static auto const SYMBOL_SOFT_LIMIT = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "soft-limit"};
+static auto const SYMBOL_SOFT_LIMIT_CHANGES = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "soft-limit-changes"};
+static auto const SYMBOL_SURVIVAL_PERCENT = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "survival-percent"};
+static auto const SYMBOL_HEAP_TRIMS = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "heap-trims"};
+static auto const SYMBOL_NURSERY_COLLECTIONS = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "nursery-collections"};
+static auto const SYMBOL_NURSERY_PAUSE_NS_TOTAL = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "nursery-pause-ns-total"};
+static auto const SYMBOL_NURSERY_PAUSE_NS_MAX = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "nursery-pause-ns-max"};
+static auto const SYMBOL_PROMOTED_BYTES = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "promoted-bytes"};
+static auto const SYMBOL_MARK_STACK_OVERFLOWS = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "mark-stack-overflows"};
+static auto const SYMBOL_BY_TYPE = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "by-type"};
+
+static bool try_put_counts(
+        VirtualMachine *vm,
+        ObjectAllocator_Counts allocated,
+        ObjectAllocator_Counts freed,
+        Object **dict
+) {
+    return try_put_int(vm, SYMBOL_ALLOCATED_BYTES, (int64_t) allocated.bytes, dict)
+           && try_put_int(vm, SYMBOL_ALLOCATED_OBJECTS, (int64_t) allocated.objects, dict)
+           && try_put_int(vm, SYMBOL_FREED_BYTES, (int64_t) freed.bytes, dict)
+           && try_put_int(vm, SYMBOL_FREED_OBJECTS, (int64_t) freed.objects, dict);
+}
+
+static bool try_put_dict(VirtualMachine *vm, Object *key, Object *value, Object **dict) {
+    if (false == object_dict_try_put(&vm->allocator, *dict, key, value, dict)) {
+        out_of_memory_error(vm);
+    }
+
+    return true;
+}
+
+// One dict of counts per type allocated so far, keyed by the type's name.
+static bool try_make_gc_stats_by_type(
+        VirtualMachine *vm,
+        ObjectAllocator_Statistics const *statistics,
+        Object **by_type
+) {
+    Object **name, **counts;
+    if (false == stack_try_create_local(stack_locals(&vm->stack), &name)
+        || false == stack_try_create_local(stack_locals(&vm->stack), &counts)) {
+        stack_overflow_error(vm);
+    }
+
+    *by_type = OBJECT_NIL;
+    for (size_t type = 0; type <= TYPE_HANDLE; type++) {
+        if (0 == statistics->allocated[type].objects) {
+            continue;
+        }
+
+        if (false == object_try_make_symbol(&vm->allocator, object_type_str((Object_Type) type), name)) {
+            out_of_memory_error(vm);
+        }
+
+        *counts = OBJECT_NIL;
+        if (false == try_put_counts(vm, statistics->allocated[type], statistics->freed[type], counts)) {
+            return false;
+        }
+
+        if (false == object_dict_try_put(&vm->allocator, *by_type, *name, *counts, by_type)) {
+            out_of_memory_error(vm);
+        }
+    }
+
+    return true;
+}
+
+static bool gc_stats(VirtualMachine *vm, Object *args, Object **result) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(result);
+
+    auto const got = object_list_count(args);
+    typeof(got) expected = 0;
+    if (expected != got) {
+        call_args_count_error(vm, "gc-stats", expected, got);
+    }
+
+    auto const statistics = allocator_statistics(&vm->allocator);
+    auto allocated = (ObjectAllocator_Counts) {0};
+    auto freed = (ObjectAllocator_Counts) {0};
+    for (size_t type = 0; type <= TYPE_HANDLE; type++) {
+        allocated.objects += statistics.allocated[type].objects;
+        allocated.bytes += statistics.allocated[type].bytes;
+        freed.objects += statistics.freed[type].objects;
+        freed.bytes += statistics.freed[type].bytes;
+    }
+
+    Object **by_type;
+    if (false == stack_try_create_local(stack_locals(&vm->stack), &by_type)) {
+        stack_overflow_error(vm);
+    }
+
+    *result = OBJECT_NIL;
+    return try_make_gc_stats_by_type(vm, &statistics, by_type)
+           && try_put_int(vm, SYMBOL_COLLECTIONS, (int64_t) statistics.collections, result)
+           && try_put_int(vm, SYMBOL_PAUSE_NS_TOTAL, (int64_t) statistics.pause_ns_total, result)
+           && try_put_int(vm, SYMBOL_PAUSE_NS_MAX, (int64_t) statistics.pause_ns_max, result)
+           && try_put_int(vm, SYMBOL_PAUSE_NS_P50, (int64_t) allocator_pause_percentile_ns(&statistics, 0.5), result)
+           && try_put_int(vm, SYMBOL_PAUSE_NS_P90, (int64_t) allocator_pause_percentile_ns(&statistics, 0.9), result)
+           && try_put_int(vm, SYMBOL_PAUSE_NS_P99, (int64_t) allocator_pause_percentile_ns(&statistics, 0.99), result)
+           && try_put_counts(vm, allocated, freed, result)
+           && try_put_int(vm, SYMBOL_HEAP_BYTES, (int64_t) statistics.heap_bytes, result)
+           && try_put_int(vm, SYMBOL_HEAP_BYTES_MAX, (int64_t) statistics.heap_bytes_max, result)
+           && try_put_int(vm, SYMBOL_LIVE_BYTES, (int64_t) statistics.live_bytes, result)
+           && try_put_int(vm, SYMBOL_LIVE_BYTES_MAX, (int64_t) statistics.live_bytes_max, result)
+           && try_put_int(vm, SYMBOL_SOFT_LIMIT, (int64_t) statistics.soft_limit, result)
+           && try_put_int(vm, SYMBOL_SOFT_LIMIT_CHANGES, (int64_t) statistics.soft_limit_changes, result)
+           && try_put_int(vm, SYMBOL_SURVIVAL_PERCENT, (int64_t) statistics.survival_percent, result)
+           && try_put_int(vm, SYMBOL_HEAP_TRIMS, (int64_t) statistics.heap_trims, result)
+           && try_put_int(vm, SYMBOL_NURSERY_COLLECTIONS, (int64_t) statistics.nursery_collections, result)
+           && try_put_int(vm, SYMBOL_NURSERY_PAUSE_NS_TOTAL, (int64_t) statistics.nursery_pause_ns_total, result)
+           && try_put_int(vm, SYMBOL_NURSERY_PAUSE_NS_MAX, (int64_t) statistics.nursery_pause_ns_max, result)
+           && try_put_int(vm, SYMBOL_PROMOTED_BYTES, (int64_t) statistics.promoted_bytes, result)
+           && try_put_int(vm, SYMBOL_MARK_STACK_OVERFLOWS, (int64_t) statistics.mark_stack_overflows, result)
+           && try_put_dict(vm, SYMBOL_BY_TYPE, *by_type, result);
+}
+
+static bool pmap(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    Object *fn, *list;
+    if (false == object_list_try_unpack_2(&fn, &list, args)) {
+        call_args_count_error(vm, "pmap", 2, object_list_count(args));
+    }
+
+    if (TYPE_CLOSURE != fn->type && TYPE_PRIMITIVE != fn->type) {
+        type_error(vm, fn->type, TYPE_CLOSURE, TYPE_PRIMITIVE);
+    }
+
+    if (TYPE_LIST != list->type && TYPE_NIL != list->type) {
+        type_error(vm, list->type, TYPE_LIST, TYPE_NIL);
+    }
+
+    return workers_try_map(vm, fn, list, value);
+}
+
+static bool future(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    if (OBJECT_NIL == args) {
+        call_args_count_error(vm, "future", 1, 0);
+    }
+
+    auto const fn = args->as_list.first;
+    if (TYPE_CLOSURE != fn->type && TYPE_PRIMITIVE != fn->type) {
+        type_error(vm, fn->type, TYPE_CLOSURE, TYPE_PRIMITIVE);
+    }
+
+    return workers_try_submit(vm, fn, args->as_list.rest, value);
+}
+
+static bool deref(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    auto const got = object_list_count(args);
+    typeof(got) expected = 1;
+    if (expected != got) {
+        call_args_count_error(vm, "deref", expected, got);
+    }
+
+    return workers_try_deref(vm, args->as_list.first, value);
+}
+
+static bool chan_make(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    auto const got = object_list_count(args);
+    typeof(got) expected = 1;
+    if (expected != got) {
+        call_args_count_error(vm, "chan", expected, got);
+    }
+
+    auto const capacity = args->as_list.first;
+    if (TYPE_INT != capacity->type) {
+        type_error(vm, capacity->type, TYPE_INT);
+    }
+
+    if (capacity->as_int <= 0) {
+        value_error(vm, "channel capacity out of range");
+    }
+
+    return channel_try_make(vm, (size_t) capacity->as_int, value);
+}
+
+static bool chan_send(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    Object *channel, *message;
+    if (false == object_list_try_unpack_2(&channel, &message, args)) {
+        call_args_count_error(vm, "send", 2, object_list_count(args));
+    }
+
+    *value = OBJECT_NIL;
+    return channel_try_send(vm, channel, message);
+}
+
+static bool chan_recv(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    auto const got = object_list_count(args);
+    typeof(got) expected = 1;
+    if (expected != got) {
+        call_args_count_error(vm, "recv", expected, got);
+    }
+
+    return channel_try_recv(vm, args->as_list.first, value);
+}
+
+static bool freeze(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    auto const got = object_list_count(args);
+    typeof(got) expected = 1;
+    if (expected != got) {
+        call_args_count_error(vm, "freeze", expected, got);
+    }
+
+    errno_t error_code;
+    if (false == frozen_try_freeze(args->as_list.first, value, &error_code)) {
+        if (EINVAL == error_code) {
+            value_error(vm, "closures, macros and handles can not be frozen");
+        }
+
+        out_of_memory_error(vm);
+    }
+
+    return true;
+}
+
+static bool task_spawn(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    if (OBJECT_NIL == args) {
+        call_args_count_error(vm, "spawn", 1, 0);
+    }
+
+    auto const fn = args->as_list.first;
+    if (TYPE_CLOSURE != fn->type && TYPE_PRIMITIVE != fn->type) {
+        type_error(vm, fn->type, TYPE_CLOSURE, TYPE_PRIMITIVE);
+    }
+
+    return tasks_try_spawn(vm, fn, args->as_list.rest, value);
+}
+
+static bool task_yield(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    auto const got = object_list_count(args);
+    typeof(got) expected = 0;
+    if (expected != got) {
+        call_args_count_error(vm, "yield", expected, got);
+    }
+
+    tasks_yield(vm);
+    *value = OBJECT_NIL;
+    return true;
+}
+
+static bool task_join(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    auto const got = object_list_count(args);
+    typeof(got) expected = 1;
+    if (expected != got) {
+        call_args_count_error(vm, "join", expected, got);
+    }
+
+    return tasks_try_join(vm, args->as_list.first, value);
+}
+
+static bool file_read(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    auto const got = object_list_count(args);
+    typeof(got) expected = 1;
+    if (expected != got) {
+        call_args_count_error(vm, "read-file", expected, got);
+    }
+
+    return files_try_read(vm, args->as_list.first, value);
+}
+
+static bool file_read_lines(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    auto const got = object_list_count(args);
+    typeof(got) expected = 1;
+    if (expected != got) {
+        call_args_count_error(vm, "read-lines", expected, got);
+    }
+
+    return files_try_read_lines(vm, args->as_list.first, value);
+}
+
+static bool file_write(VirtualMachine *vm, Object *args, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(args);
+    guard_is_one_of(args->type, TYPE_LIST, TYPE_NIL);
+    guard_is_not_null(value);
+
+    Object *path, *contents;
+    if (false == object_list_try_unpack_2(&path, &contents, args)) {
+        call_args_count_error(vm, "write-file", 2, object_list_count(args));
+    }
+
+    return files_try_write(vm, path, contents, value);
+}
+
 typedef struct {
     Object *name;
     Object *value;
 } Primitive;
 
-#define primitive(Name, Fn)                                             \
-((Primitive) {                                                          \
-    .name = &(Object) {.type = TYPE_SYMBOL, .as_symbol = (Name)},       \
-    .value = &(Object) {.type = TYPE_PRIMITIVE, .as_primitive = (Fn)}   \
+#define primitive(Name, Fn)                                                                     \
+((Primitive) {                                                                                  \
+    .name = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = (Name)},     \
+    .value = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_PRIMITIVE, .as_primitive = (Fn)} \
 })
 
 static Primitive const PRIMITIVES[] = {
@@ -550,6 +958,21 @@ static Primitive const PRIMITIVES[] = {
         primitive("dict", dict_dict),
         primitive("get", dict_get),
         primitive("put", dict_put),
+        primitive("import-stats", import_stats),
+        primitive("gc-stats", gc_stats),
+        primitive("pmap", pmap),
+        primitive("future", future),
+        primitive("deref", deref),
+        primitive("chan", chan_make),
+        primitive("send", chan_send),
+        primitive("recv", chan_recv),
+        primitive("freeze", freeze),
+        primitive("spawn", task_spawn),
+        primitive("yield", task_yield),
+        primitive("join", task_join),
+        primitive("read-file", file_read),
+        primitive("read-lines", file_read_lines),
+        primitive("write-file", file_write),
 };
 
 static size_t const PRIMITIVES_COUNT = sizeof(PRIMITIVES) / sizeof(PRIMITIVES[0]);
@@ -567,3 +990,37 @@ bool try_define_primitives(ObjectAllocator *a, Object *env) {
     return true;
 }
 
+size_t primitives_count() {
+    return PRIMITIVES_COUNT;
+}
+
+bool primitive_try_get_index(Object_Primitive fn, size_t *index) {
+    guard_is_not_null(fn);
+    guard_is_not_null(index);
+
+    for (size_t i = 0; i < PRIMITIVES_COUNT; i++) {
+        if (fn == PRIMITIVES[i].value->as_primitive) {
+            *index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool primitive_try_get(size_t index, Object_Primitive *fn) {
+    guard_is_not_null(fn);
+
+    if (index >= PRIMITIVES_COUNT) {
+        return false;
+    }
+
+    *fn = PRIMITIVES[index].value->as_primitive;
+    return true;
+}
+
+char const *primitive_name(size_t index) {
+    guard_is_less(index, PRIMITIVES_COUNT);
+
+    return PRIMITIVES[index].name->as_symbol;
+}
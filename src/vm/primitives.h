@@ -5,3 +5,15 @@
 
 [[nodiscard]]
 bool try_define_primitives(ObjectAllocator *a, Object *env);
+
+// Primitives are identified by their position in the table of primitives,
+// which is the same for every run of the same build.
+size_t primitives_count();
+
+[[nodiscard]]
+bool primitive_try_get_index(Object_Primitive fn, size_t *index);
+
+[[nodiscard]]
+bool primitive_try_get(size_t index, Object_Primitive *fn);
+
+char const *primitive_name(size_t index);
@@ -0,0 +1,284 @@
+#include "profiler.h"
+
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "utility/guards.h"
+#include "utility/dynamic_array.h"
+#include "object/list.h"
+#include "object/accessors.h"
+#include "object/repr.h"
+
+#define PROFILER_DEFAULT_FREQUENCY 100
+#define PROFILER_MAX_BODY_LENGTH 48
+
+static atomic_bool IS_TAKEN;
+// Incremented by the signal handler, taken by `profiler_sample`.
+static atomic_size_t DUE;
+static struct sigaction PREV_ACTION;
+
+static void on_sigprof(int) {
+    atomic_fetch_add_explicit(&DUE, 1, memory_order_relaxed);
+}
+
+bool profiler_try_start(Profiler *p, Profiler_Config config, errno_t *error_code) {
+    guard_is_not_null(p);
+    guard_is_not_null(error_code);
+
+    auto is_taken = false;
+    if (false == atomic_compare_exchange_strong(&IS_TAKEN, &is_taken, true)) {
+        *error_code = EBUSY;
+        return false;
+    }
+
+    *p = (Profiler) {0};
+    atomic_store(&DUE, 0);
+
+    struct sigaction action = {.sa_handler = on_sigprof, .sa_flags = SA_RESTART};
+    sigemptyset(&action.sa_mask);
+    errno = 0;
+    if (0 != sigaction(SIGPROF, &action, &PREV_ACTION)) {
+        *error_code = errno;
+        atomic_store(&IS_TAKEN, false);
+        return false;
+    }
+
+    auto const frequency = 0 == config.frequency ? PROFILER_DEFAULT_FREQUENCY : config.frequency;
+    auto const interval_us = 1000000 / frequency;
+    auto const interval = (struct timeval) {
+            .tv_sec = (time_t) (interval_us / 1000000),
+            .tv_usec = (suseconds_t) (interval_us % 1000000 + (0 == interval_us ? 1 : 0)),
+    };
+    auto const timer = (struct itimerval) {.it_interval = interval, .it_value = interval};
+    if (0 != setitimer(ITIMER_PROF, &timer, nullptr)) {
+        *error_code = errno;
+        sigaction(SIGPROF, &PREV_ACTION, nullptr);
+        atomic_store(&IS_TAKEN, false);
+        return false;
+    }
+
+    p->_is_running = true;
+    return true;
+}
+
+void profiler_stop(Profiler *p) {
+    guard_is_not_null(p);
+
+    if (false == p->_is_running) {
+        return;
+    }
+
+    setitimer(ITIMER_PROF, &(struct itimerval) {0}, nullptr);
+    sigaction(SIGPROF, &PREV_ACTION, nullptr);
+    atomic_store(&DUE, 0);
+    atomic_store(&IS_TAKEN, false);
+    p->_is_running = false;
+}
+
+void profiler_free(Profiler *p) {
+    guard_is_not_null(p);
+
+    profiler_stop(p);
+    for (size_t i = 0; i < p->_slots_capacity; i++) {
+        free(p->_slots[i].stack);
+    }
+    free(p->_slots);
+    da_free(&p->_frames);
+    sb_free(&p->_sb);
+
+    *p = (Profiler) {0};
+}
+
+bool profiler_is_due(void) {
+    return 0 != atomic_load_explicit(&DUE, memory_order_relaxed);
+}
+
+static size_t slot_index(Profiler const *p, char const *stack) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (auto it = stack; '\0' != *it; it++) {
+        hash ^= (uint8_t) *it;
+        hash *= 0x100000001b3;
+    }
+
+    return (size_t) hash & (p->_slots_capacity - 1);
+}
+
+static Profiler_Slot *slot_find(Profiler const *p, char const *stack) {
+    auto index = slot_index(p, stack);
+    while (nullptr != p->_slots[index].stack && 0 != strcmp(stack, p->_slots[index].stack)) {
+        index = (index + 1) & (p->_slots_capacity - 1);
+    }
+
+    return &p->_slots[index];
+}
+
+static bool slots_try_grow(Profiler *p) {
+    auto const capacity = 0 == p->_slots_capacity ? 64 : p->_slots_capacity * 2;
+    auto const slots = (Profiler_Slot *) calloc(capacity, sizeof(Profiler_Slot));
+    if (nullptr == slots) {
+        return false;
+    }
+
+    auto const old_slots = p->_slots;
+    auto const old_capacity = p->_slots_capacity;
+    p->_slots = slots;
+    p->_slots_capacity = capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (nullptr != old_slots[i].stack) {
+            *slot_find(p, old_slots[i].stack) = old_slots[i];
+        }
+    }
+    free(old_slots);
+
+    return true;
+}
+
+static bool try_count(Profiler *p, char const *stack, size_t count) {
+    if (2 * (p->_slots_count + 1) > p->_slots_capacity && false == slots_try_grow(p)) {
+        return false;
+    }
+
+    auto const slot = slot_find(p, stack);
+    if (nullptr == slot->stack) {
+        slot->stack = strdup(stack);
+        if (nullptr == slot->stack) {
+            return false;
+        }
+        p->_slots_count++;
+    }
+
+    slot->count += count;
+    return true;
+}
+
+// Binding names are searched in the scopes the closure was defined in, so that every closure
+// made by the same `fn` form is found, whichever one runs.
+static Object *find_name(Object *dict, Object *body) { // NOLINT(*-no-recursion)
+    if (TYPE_DICT != dict->type) {
+        return nullptr;
+    }
+
+    auto const value = dict->as_dict.value;
+    auto const is_closure = TYPE_CLOSURE == value->type || TYPE_MACRO == value->type;
+    if (is_closure && value->as_closure.body->as_list.rest == body->as_list.rest) {
+        return dict->as_dict.key;
+    }
+
+    auto const name = find_name(dict->as_dict.left, body);
+    return nullptr != name ? name : find_name(dict->as_dict.right, body);
+}
+
+static bool try_append_name(Profiler *p, Stack_Frame const *frame, errno_t *error_code) {
+    auto const body = frame->body;
+    object_list_for(scope, object_as_list(frame->env).rest) {
+        auto const name = find_name(scope, body);
+        if (nullptr != name) {
+            return sb_try_printf(&p->_sb, error_code, "%s", name->as_symbol);
+        }
+    }
+
+    auto const start = p->_sb.length;
+    auto const first = OBJECT_NIL == body->as_list.rest ? OBJECT_NIL : body->as_list.rest->as_list.first;
+    if (false == sb_try_printf(&p->_sb, error_code, "(fn ")
+        || false == object_try_repr(first, &p->_sb, error_code)) {
+        return false;
+    }
+
+    // `;` separates calls.
+    for (auto i = start; i < p->_sb.length; i++) {
+        if (';' == p->_sb.str[i]) {
+            p->_sb.str[i] = ',';
+        }
+    }
+
+    if (p->_sb.length - start > PROFILER_MAX_BODY_LENGTH) {
+        p->_sb.length = start + PROFILER_MAX_BODY_LENGTH;
+        p->_sb.str[p->_sb.length] = '\0';
+        return sb_try_printf(&p->_sb, error_code, "...)");
+    }
+
+    return sb_try_printf(&p->_sb, error_code, ")");
+}
+
+static bool try_fold(Profiler *p, Stack *s, bool is_main, errno_t *error_code) {
+    p->_frames.count = 0;
+    stack_for_reversed(frame, s) {
+        if (OBJECT_NIL != frame->body && false == da_try_append(&p->_frames, frame)) {
+            *error_code = errno;
+            return false;
+        }
+    }
+
+    sb_clear(&p->_sb);
+    if (false == sb_try_printf(&p->_sb, error_code, "%s", is_main ? "<main>" : "<task>")) {
+        return false;
+    }
+
+    // Outermost first; a recursive call copies the name of its caller rather than looking it up.
+    Stack_Frame const *prev = nullptr;
+    size_t prev_start = 0, prev_length = 0;
+    for (auto i = p->_frames.count; i > 0; i--) {
+        auto const frame = p->_frames.data[i - 1];
+        if (false == sb_try_append_char(&p->_sb, error_code, ';')) {
+            return false;
+        }
+
+        auto const start = p->_sb.length;
+        auto const is_same = nullptr != prev && prev->body->as_list.rest == frame->body->as_list.rest;
+        if (is_same) {
+            // Reserved first: the bytes appended are in the builder.
+            if (false == sb_try_reserve(&p->_sb, start + prev_length, error_code)) {
+                return false;
+            }
+            if (false == sb_try_append_bytes(&p->_sb, error_code, p->_sb.str + prev_start, prev_length)) {
+                return false;
+            }
+        } else if (false == try_append_name(p, frame, error_code)) {
+            return false;
+        }
+
+        prev = frame;
+        prev_start = start;
+        prev_length = p->_sb.length - start;
+    }
+
+    return true;
+}
+
+void profiler_sample(Profiler *p, Stack *s, bool is_main) {
+    guard_is_not_null(p);
+    guard_is_not_null(s);
+
+    auto const count = atomic_exchange_explicit(&DUE, 0, memory_order_relaxed);
+    if (0 == count || stack_is_empty(s)) {
+        return;
+    }
+
+    errno_t error_code;
+    if (false == try_fold(p, s, is_main, &error_code) || false == try_count(p, p->_sb.str, count)) {
+        p->dropped += count;
+        return;
+    }
+
+    p->samples += count;
+}
+
+bool profiler_try_write(Profiler const *p, FILE *file, errno_t *error_code) {
+    guard_is_not_null(p);
+    guard_is_not_null(file);
+    guard_is_not_null(error_code);
+
+    errno = 0;
+    for (size_t i = 0; i < p->_slots_capacity; i++) {
+        auto const slot = &p->_slots[i];
+        if (nullptr != slot->stack && fprintf(file, "%s %zu\n", slot->stack, slot->count) < 0) {
+            *error_code = errno;
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "utility/string_builder.h"
+#include "stack.h"
+
+// Samples the stack of a VM on a `SIGPROF` timer. The signal handler only counts the samples
+// due, and the evaluator takes them between two steps, where the stack is consistent. Each
+// sample is folded into a line of calls from the outermost to the innermost one, the format
+// read by `flamegraph.pl`: a closure or macro is named after the binding it was defined with,
+// or after its body if it has none.
+//
+// Timers are process-wide, so one profiler runs at a time; only the VM that is given the
+// profiler takes samples (VMs in the pool of `pmap` and `future` are not profiled).
+
+typedef struct {
+    // Samples per second of CPU time, 100 if 0.
+    size_t frequency;
+} Profiler_Config;
+
+typedef struct {
+    char *stack;
+    size_t count;
+} Profiler_Slot;
+
+typedef struct {
+    Stack_Frame **data;
+    size_t count;
+    size_t capacity;
+} Profiler_Frames;
+
+typedef struct Profiler Profiler;
+struct Profiler {
+    // Samples taken, and samples lost because memory ran out.
+    size_t samples;
+    size_t dropped;
+
+    Profiler_Slot *_slots;
+    size_t _slots_capacity;
+    size_t _slots_count;
+    Profiler_Frames _frames;
+    StringBuilder _sb;
+    bool _is_running;
+};
+
+// Starts the timer; fails with `EBUSY` if another profiler is running.
+[[nodiscard]]
+bool profiler_try_start(Profiler *p, Profiler_Config config, errno_t *error_code);
+
+// Stops the timer; samples taken so far are kept.
+void profiler_stop(Profiler *p);
+
+void profiler_free(Profiler *p);
+
+// Whether a sample is due: called by the evaluator after every step.
+bool profiler_is_due(void);
+
+// Records the stack, `is_main` telling whether it is the main task's, as the samples due.
+void profiler_sample(Profiler *p, Stack *s, bool is_main);
+
+// Writes one line per distinct stack: the calls separated by `;`, then the number of samples.
+[[nodiscard]]
+bool profiler_try_write(Profiler const *p, FILE *file, errno_t *error_code);
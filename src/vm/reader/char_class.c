@@ -0,0 +1,215 @@
+#include "char_class.h"
+
+#include <stdint.h>
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#define BLOCK_SIZE 16
+
+typedef __m128i Block;
+
+static Block block_load(char const *chars) {
+    return _mm_loadu_si128((__m128i const *) chars);
+}
+
+static Block block_eq(Block b, char c) {
+    return _mm_cmpeq_epi8(b, _mm_set1_epi8(c));
+}
+
+// Only valid for ASCII bounds: bytes >= 0x80 are negative and never in range.
+static Block block_in_range(Block b, char lo, char hi) {
+    return _mm_and_si128(
+            _mm_cmpgt_epi8(b, _mm_set1_epi8((char) (lo - 1))),
+            _mm_cmplt_epi8(b, _mm_set1_epi8((char) (hi + 1)))
+    );
+}
+
+static Block block_or(Block a, Block b) {
+    return _mm_or_si128(a, b);
+}
+
+static Block block_and_not(Block a, Block b) {
+    return _mm_andnot_si128(b, a);
+}
+
+static size_t block_span(Block members) {
+    auto const mask = (uint32_t) _mm_movemask_epi8(members);
+    return (size_t) __builtin_ctz(~mask);
+}
+
+#elif defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+#define BLOCK_SIZE 16
+
+typedef uint8x16_t Block;
+
+static Block block_load(char const *chars) {
+    return vld1q_u8((uint8_t const *) chars);
+}
+
+static Block block_eq(Block b, char c) {
+    return vceqq_u8(b, vdupq_n_u8((uint8_t) c));
+}
+
+static Block block_in_range(Block b, char lo, char hi) {
+    return vandq_u8(vcgeq_u8(b, vdupq_n_u8((uint8_t) lo)), vcleq_u8(b, vdupq_n_u8((uint8_t) hi)));
+}
+
+static Block block_or(Block a, Block b) {
+    return vorrq_u8(a, b);
+}
+
+static Block block_and_not(Block a, Block b) {
+    return vbicq_u8(a, b);
+}
+
+static size_t block_span(Block members) {
+    // Narrowing shift packs the byte mask into 4 bits per byte.
+    auto const nibbles = vshrn_n_u16(vreinterpretq_u16_u8(members), 4);
+    auto const mask = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+    if (UINT64_MAX == mask) {
+        return BLOCK_SIZE;
+    }
+
+    return (size_t) __builtin_ctzll(~mask) / 4;
+}
+
+#endif
+
+static bool is_whitespace(unsigned char c) {
+    return ' ' == c || ',' == c || '\r' == c || '\v' == c || '\f' == c;
+}
+
+static bool is_printable(unsigned char c) {
+    return c >= ' ' && c <= '~';
+}
+
+static bool is_name(unsigned char c) {
+    switch (c) {
+        case ' ':
+        case '"':
+        case '\'':
+        case '(':
+        case ')':
+        case ',':
+        case '.':
+        case ':':
+        case ';':
+        case '[':
+        case '\\':
+        case ']':
+        case '`':
+        case '{':
+        case '|':
+        case '}': {
+            return false;
+        }
+        default: {
+            return is_printable(c);
+        }
+    }
+}
+
+static bool is_string(unsigned char c) {
+    return is_printable(c) && '"' != c && '\\' != c;
+}
+
+#ifdef BLOCK_SIZE
+
+static Block block_whitespace(Block b) {
+    return block_or(
+            block_or(block_eq(b, ' '), block_eq(b, ',')),
+            block_or(block_eq(b, '\r'), block_in_range(b, '\v', '\f'))
+    );
+}
+
+static Block block_printable(Block b) {
+    return block_in_range(b, ' ', '~');
+}
+
+static Block block_name(Block b) {
+    auto const separators = block_or(
+            block_or(
+                    block_or(block_eq(b, ' '), block_eq(b, '"')),
+                    block_or(block_in_range(b, '\'', ')'), block_eq(b, ','))
+            ),
+            block_or(
+                    block_or(block_eq(b, '.'), block_in_range(b, ':', ';')),
+                    block_or(
+                            block_or(block_in_range(b, '[', ']'), block_eq(b, '`')),
+                            block_in_range(b, '{', '}')
+                    )
+            )
+    );
+
+    return block_and_not(block_printable(b), separators);
+}
+
+static Block block_string(Block b) {
+    return block_and_not(block_printable(b), block_or(block_eq(b, '"'), block_eq(b, '\\')));
+}
+
+static size_t span(
+        char const *chars,
+        size_t count,
+        Block (*block_class)(Block),
+        bool (*char_class)(unsigned char)
+) {
+    size_t i = 0;
+    while (i + BLOCK_SIZE <= count) {
+        auto const block_span_ = block_span(block_class(block_load(chars + i)));
+        i += block_span_;
+        if (block_span_ < BLOCK_SIZE) {
+            return i;
+        }
+    }
+
+    while (i < count && char_class((unsigned char) chars[i])) {
+        i++;
+    }
+
+    return i;
+}
+
+#else
+
+#define block_whitespace    nullptr
+#define block_printable     nullptr
+#define block_name          nullptr
+#define block_string        nullptr
+
+static size_t span(
+        char const *chars,
+        size_t count,
+        [[maybe_unused]] void *block_class,
+        bool (*char_class)(unsigned char)
+) {
+    size_t i = 0;
+    while (i < count && char_class((unsigned char) chars[i])) {
+        i++;
+    }
+
+    return i;
+}
+
+#endif
+
+size_t char_class_span_whitespace(char const *chars, size_t count) {
+    return span(chars, count, block_whitespace, is_whitespace);
+}
+
+size_t char_class_span_printable(char const *chars, size_t count) {
+    return span(chars, count, block_printable, is_printable);
+}
+
+size_t char_class_span_name(char const *chars, size_t count) {
+    return span(chars, count, block_name, is_name);
+}
+
+size_t char_class_span_string(char const *chars, size_t count) {
+    return span(chars, count, block_string, is_string);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stddef.h>
+
+// Each function returns the length of the longest prefix of `chars` whose
+// characters all belong to the class. Classes match the ones used by the
+// scanner in the "C" locale; tabs and newlines are never included since they
+// affect positions.
+
+// ' ', ',', '\r', '\v' and '\f'.
+size_t char_class_span_whitespace(char const *chars, size_t count);
+
+// Printable ASCII characters (comment bodies).
+size_t char_class_span_printable(char const *chars, size_t count);
+
+// Characters that may appear in a symbol.
+size_t char_class_span_name(char const *chars, size_t count);
+
+// Printable ASCII characters except '"' and '\\' (string literal bodies).
+size_t char_class_span_string(char const *chars, size_t count);
@@ -0,0 +1,315 @@
+#include "form_cache.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utility/guards.h"
+
+#define FORM_CACHE_MAGIC "PSMF"
+#define FORM_CACHE_VERSION 1
+#define FORM_CACHE_EXTENSION ".psf"
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_hash;
+    uint64_t source_size;
+} FormCache_Header;
+
+typedef enum : uint8_t {
+    FORM_OPEN = 1,
+    FORM_CLOSE,
+    FORM_INT,
+    FORM_STRING,
+    FORM_SYMBOL
+} FormCache_Tag;
+
+FormCache_Key form_cache_key(Source source) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < source.size; i++) {
+        hash ^= (uint8_t) source.data[i];
+        hash *= 0x100000001b3;
+    }
+
+    return (FormCache_Key) {.hash = hash, .size = source.size};
+}
+
+static bool try_append_tag(StringBuilder *sb, FormCache_Tag tag, errno_t *error_code) {
+    return sb_try_append_char(sb, error_code, (char) tag);
+}
+
+static bool try_append_chars(StringBuilder *sb, FormCache_Tag tag, char const *chars, errno_t *error_code) {
+    auto const length = strlen(chars);
+    if (length > UINT32_MAX) {
+        *error_code = EOVERFLOW;
+        return false;
+    }
+
+    auto const length_u32 = (uint32_t) length;
+    return try_append_tag(sb, tag, error_code)
+           && sb_try_append_bytes(sb, error_code, (char const *) &length_u32, sizeof(length_u32))
+           && sb_try_append_bytes(sb, error_code, chars, length + 1);
+}
+
+static bool try_encode(Object *obj, StringBuilder *sb, errno_t *error_code) {
+    switch (obj->type) {
+        case TYPE_NIL: {
+            return try_append_tag(sb, FORM_OPEN, error_code)
+                   && try_append_tag(sb, FORM_CLOSE, error_code);
+        }
+        case TYPE_INT: {
+            return try_append_tag(sb, FORM_INT, error_code)
+                   && sb_try_append_bytes(sb, error_code, (char const *) &obj->as_int, sizeof(obj->as_int));
+        }
+        case TYPE_STRING: {
+            return try_append_chars(sb, FORM_STRING, obj->as_string, error_code);
+        }
+        case TYPE_SYMBOL: {
+            return try_append_chars(sb, FORM_SYMBOL, obj->as_symbol, error_code);
+        }
+        case TYPE_LIST: {
+            if (false == try_append_tag(sb, FORM_OPEN, error_code)) {
+                return false;
+            }
+
+            auto it = obj;
+            for (; TYPE_LIST == it->type; it = it->as_list.rest) {
+                if (false == try_encode(it->as_list.first, sb, error_code)) {
+                    return false;
+                }
+            }
+
+            if (OBJECT_NIL != it) {
+                *error_code = EINVAL;
+                return false;
+            }
+
+            return try_append_tag(sb, FORM_CLOSE, error_code);
+        }
+        case TYPE_DICT:
+        case TYPE_PRIMITIVE:
+        case TYPE_CLOSURE:
+        case TYPE_MACRO:
+        case TYPE_HANDLE: {
+            *error_code = EINVAL;
+            return false;
+        }
+    }
+
+    guard_unreachable();
+}
+
+bool form_cache_try_encode(Object *exprs, FormCache_Key key, StringBuilder *sb, errno_t *error_code) {
+    guard_is_not_null(exprs);
+    guard_is_not_null(sb);
+    guard_is_not_null(error_code);
+
+    auto const header = (FormCache_Header) {
+            .magic = FORM_CACHE_MAGIC,
+            .version = FORM_CACHE_VERSION,
+            .source_hash = key.hash,
+            .source_size = key.size
+    };
+
+    sb_clear(sb);
+    if (false == sb_try_append_bytes(sb, error_code, (char const *) &header, sizeof(header))) {
+        return false;
+    }
+
+    for (auto it = exprs; OBJECT_NIL != it; it = it->as_list.rest) {
+        if (false == try_encode(it->as_list.first, sb, error_code)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool try_format_path(char const *dir, FormCache_Key key, char *path, size_t size, errno_t *error_code) {
+    auto const length = snprintf(
+            path, size, "%s/%016llx" FORM_CACHE_EXTENSION,
+            dir, (unsigned long long) key.hash
+    );
+    if (length < 0 || (size_t) length >= size) {
+        *error_code = ENAMETOOLONG;
+        return false;
+    }
+
+    return true;
+}
+
+bool form_cache_try_store(char const *dir, FormCache_Key key, StringBuilder const *sb, errno_t *error_code) {
+    guard_is_not_null(dir);
+    guard_is_not_null(sb);
+    guard_is_not_null(error_code);
+
+    char path[PATH_MAX];
+    if (false == try_format_path(dir, key, path, sizeof(path), error_code)) {
+        return false;
+    }
+
+    // Unique per writer: processes and threads storing the same file must not share it.
+    char temp_path[PATH_MAX];
+    auto const length = snprintf(temp_path, sizeof(temp_path), "%s.XXXXXX", path);
+    if (length < 0 || (size_t) length >= sizeof(temp_path)) {
+        *error_code = ENAMETOOLONG;
+        return false;
+    }
+
+    auto const fd = mkstemp(temp_path);
+    if (fd < 0) {
+        *error_code = errno;
+        return false;
+    }
+
+    errno = 0;
+    auto const file = 0 == fchmod(fd, 0644) ? fdopen(fd, "wb") : nullptr;
+    if (nullptr == file) {
+        *error_code = errno;
+        close(fd);
+        remove(temp_path);
+        return false;
+    }
+
+    auto const written = fwrite(sb->str, 1, sb->length, file);
+    auto const write_error = errno;
+    if (0 != fclose(file) || written != sb->length) {
+        *error_code = 0 == write_error ? EIO : write_error;
+        remove(temp_path);
+        return false;
+    }
+
+    // Readers never observe a partially written file.
+    if (0 != rename(temp_path, path)) {
+        *error_code = errno;
+        remove(temp_path);
+        return false;
+    }
+
+    return true;
+}
+
+bool form_cache_try_load(char const *dir, FormCache_Key key, Source *cached, bool *found, errno_t *error_code) {
+    guard_is_not_null(dir);
+    guard_is_not_null(cached);
+    guard_is_not_null(found);
+    guard_is_not_null(error_code);
+
+    *found = false;
+
+    char path[PATH_MAX];
+    if (false == try_format_path(dir, key, path, sizeof(path), error_code)) {
+        return false;
+    }
+
+    errno = 0;
+    auto const file = fopen(path, "rb");
+    if (nullptr == file) {
+        if (ENOENT == errno) {
+            return true;
+        }
+
+        *error_code = errno;
+        return false;
+    }
+
+    auto const ok = source_try_load(file, cached, error_code);
+    fclose(file);
+    *found = ok;
+
+    return ok;
+}
+
+bool form_cache_reader_try_open(Source cached, FormCache_Key key, FormCache_Reader *reader) {
+    guard_is_not_null(reader);
+
+    FormCache_Header header;
+    if (cached.size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, cached.data, sizeof(header));
+
+    auto const is_valid = 0 == memcmp(header.magic, FORM_CACHE_MAGIC, sizeof(header.magic))
+                          && FORM_CACHE_VERSION == header.version
+                          && key.hash == header.source_hash
+                          && key.size == header.source_size;
+    if (false == is_valid) {
+        return false;
+    }
+
+    *reader = (FormCache_Reader) {
+            ._data = cached.data,
+            ._size = cached.size,
+            ._offset = sizeof(header)
+    };
+    return true;
+}
+
+static bool try_read_bytes(FormCache_Reader *reader, void *bytes, size_t count) {
+    if (reader->_size - reader->_offset < count) {
+        return false;
+    }
+
+    memcpy(bytes, reader->_data + reader->_offset, count);
+    reader->_offset += count;
+    return true;
+}
+
+static bool try_read_chars(FormCache_Reader *reader, char const **chars) {
+    uint32_t length;
+    if (false == try_read_bytes(reader, &length, sizeof(length))) {
+        return false;
+    }
+
+    if (reader->_size - reader->_offset <= length || '\0' != reader->_data[reader->_offset + length]) {
+        return false;
+    }
+
+    *chars = reader->_data + reader->_offset;
+    reader->_offset += length + 1;
+    return true;
+}
+
+bool form_cache_reader_try_next(FormCache_Reader *reader, Token *token) {
+    guard_is_not_null(reader);
+    guard_is_not_null(token);
+
+    if (reader->_offset == reader->_size) {
+        *token = (Token) {.type = TOKEN_EOF};
+        return true;
+    }
+
+    uint8_t tag;
+    if (false == try_read_bytes(reader, &tag, sizeof(tag))) {
+        return false;
+    }
+
+    switch ((FormCache_Tag) tag) {
+        case FORM_OPEN: {
+            *token = (Token) {.type = TOKEN_OPEN_PAREN};
+            return true;
+        }
+        case FORM_CLOSE: {
+            *token = (Token) {.type = TOKEN_CLOSE_PAREN};
+            return true;
+        }
+        case FORM_INT: {
+            *token = (Token) {.type = TOKEN_INT};
+            return try_read_bytes(reader, &token->as_int, sizeof(token->as_int));
+        }
+        case FORM_STRING: {
+            *token = (Token) {.type = TOKEN_STRING};
+            return try_read_chars(reader, &token->as_string);
+        }
+        case FORM_SYMBOL: {
+            *token = (Token) {.type = TOKEN_SYMBOL};
+            return try_read_chars(reader, &token->as_symbol);
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utility/string_builder.h"
+#include "object/object.h"
+#include "scanner.h"
+#include "source.h"
+
+// On-disk cache of parsed top-level forms, keyed by a hash of the source contents.
+// A cache file is a header followed by the forms flattened into a token stream
+// (parentheses and atoms only: quotes and dots are stored already expanded).
+
+typedef struct {
+    uint64_t hash;
+    uint64_t size;
+} FormCache_Key;
+
+FormCache_Key form_cache_key(Source source);
+
+[[nodiscard]]
+bool form_cache_try_encode(Object *exprs, FormCache_Key key, StringBuilder *sb, errno_t *error_code);
+
+[[nodiscard]]
+bool form_cache_try_store(char const *dir, FormCache_Key key, StringBuilder const *sb, errno_t *error_code);
+
+// Loads the cache file for `key` if it exists; a missing file is not an error.
+[[nodiscard]]
+bool form_cache_try_load(char const *dir, FormCache_Key key, Source *cached, bool *found, errno_t *error_code);
+
+typedef struct {
+    char const *_data;
+    size_t _size;
+    size_t _offset;
+} FormCache_Reader;
+
+// Checks the header of `cached` against `key`.
+[[nodiscard]]
+bool form_cache_reader_try_open(Source cached, FormCache_Key key, FormCache_Reader *reader);
+
+// Produces the next token or `TOKEN_EOF` once all forms are read;
+// fails if the cache file is malformed.
+[[nodiscard]]
+bool form_cache_reader_try_next(FormCache_Reader *reader, Token *token);
@@ -1,5 +1,7 @@
 #include "line_reader.h"
 
+#include <string.h>
+
 #include "utility/guards.h"
 
 void line_reader_free(LineReader *r) {
@@ -9,8 +11,6 @@ void line_reader_free(LineReader *r) {
     *r = (LineReader) {0};
 }
 
-#define TAB_AS_SPACES "    "
-
 bool line_reader_try_read(LineReader *r, Arena *a, Line *line, errno_t *error_code) {
     guard_is_not_null(r);
     guard_is_not_null(r->_file);
@@ -31,7 +31,7 @@ bool line_reader_try_read(LineReader *r, Arena *a, Line *line, errno_t *error_co
         }
 
         if (EOF == c) {
-            if (false == sb_try_printf(&r->_sb, error_code, "%c", '\n')) {
+            if (false == sb_try_append_char(&r->_sb, error_code, '\n')) {
                 return false;
             }
 
@@ -39,14 +39,14 @@ bool line_reader_try_read(LineReader *r, Arena *a, Line *line, errno_t *error_co
         }
 
         if ('\t' == c) {
-            if (false == sb_try_printf(&r->_sb, error_code, "%s", TAB_AS_SPACES)) {
+            if (false == sb_try_append_bytes(&r->_sb, error_code, TAB_AS_SPACES, strlen(TAB_AS_SPACES))) {
                 return false;
             }
 
             continue;
         }
 
-        if (false == sb_try_printf(&r->_sb, error_code, "%c", c)) {
+        if (false == sb_try_append_char(&r->_sb, error_code, (char) c)) {
             return false;
         }
 
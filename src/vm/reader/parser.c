@@ -7,8 +7,8 @@
 #include "object/list.h"
 #include "object/constructors.h"
 
-static auto const SYMBOL_GET = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "get"};
-static auto const SYMBOL_QUOTE = &(Object) {.type = TYPE_SYMBOL, .as_symbol = "quote"};
+static auto const SYMBOL_GET = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "get"};
+static auto const SYMBOL_QUOTE = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "quote"};
 
 bool parser_try_init(Parser *p, ObjectAllocator *a, Parser_Config config, errno_t *error_code) {
     guard_is_not_null(p);
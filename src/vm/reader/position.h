@@ -7,3 +7,5 @@ typedef struct {
     size_t col;
     size_t end_col;
 } Position;
+
+#define TAB_AS_SPACES "    "
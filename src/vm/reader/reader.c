@@ -1,6 +1,7 @@
 #include "reader.h"
 
 #include <ctype.h>
+#include <string.h>
 
 #include "utility/guards.h"
 #include "utility/slice.h"
@@ -14,6 +15,9 @@
 #include "line_reader.h"
 #include "scanner.h"
 #include "parser.h"
+#include "source.h"
+#include "tokenizer.h"
+#include "form_cache.h"
 
 typedef struct {
     Line *data;
@@ -32,7 +36,7 @@ bool object_reader_try_init(
 
     auto const a = &vm->allocator;
 
-    *r = (ObjectReader) {._vm = vm};
+    *r = (ObjectReader) {._vm = vm, ._cache_dir = config.cache_dir};
 
     auto const ok =
             scanner_try_init(&r->_s, config.scanner_config, error_code)
@@ -171,66 +175,191 @@ static bool try_prompt(
     return true;
 }
 
+static bool source_syntax_error(
+        ObjectReader *r,
+        Source source,
+        Arena *lines_arena,
+        char const *file_name,
+        SyntaxError error
+) {
+    char const *erroneous_line;
+    errno_t error_code;
+    if (false == source_try_copy_line(source, error.pos.lineno, lines_arena, &erroneous_line, &error_code)) {
+        os_error(r->_vm, error_code);
+    }
+
+    syntax_error(r->_vm, error, file_name, erroneous_line);
+}
+
+static bool source_parser_error(
+        ObjectReader *r,
+        Source source,
+        Arena *lines_arena,
+        char const *file_name,
+        Parser_Error error
+) {
+    switch (error.type) {
+        case PARSER_SYNTAX_ERROR: {
+            return source_syntax_error(r, source, lines_arena, file_name, error.as_syntax_error);
+        }
+        case PARSER_ALLOCATION_ERROR: {
+            out_of_memory_error(r->_vm);
+        }
+    }
+
+    guard_unreachable();
+}
+
 static bool try_read_all(
         ObjectReader *r,
-        LineReader *line_reader,
+        Source source,
         Arena *lines_arena,
         char const *file_name,
         Object **exprs
 ) {
     guard_is_not_null(r);
+    guard_is_not_null(exprs);
 
     object_reader_reset(r);
 
-    auto line = (Line) {0};
-    auto lines = (Lines) {0};
+    auto tokenizer = tokenizer_make(source.data, source.size);
     while (true) {
-        errno_t error_code;
-        if (false == line_reader_try_read(line_reader, lines_arena, &line, &error_code)) {
-            os_error(r->_vm, error_code);
+        SyntaxError syntax_error;
+        if (false == tokenizer_try_next(&tokenizer, &r->_s, &syntax_error)) {
+            return source_syntax_error(r, source, lines_arena, file_name, syntax_error);
         }
 
-        if (nullptr == line.data) {
+        if (false == r->_s.has_token) {
             break;
         }
 
-        if (false == arena_try_append(lines_arena, &lines, line, &error_code)) {
-            os_error(r->_vm, error_code);
+        Parser_Error parser_error;
+        if (false == parser_try_accept(&r->_p, r->_s.token, &parser_error)) {
+            return source_parser_error(r, source, lines_arena, file_name, parser_error);
         }
 
-        if (false == try_parse_line(r, file_name, lines, line, exprs)) {
-            return false;
+        if (false == r->_p.has_expr) {
+            continue;
+        }
+
+        if (false == object_try_make_list(&r->_vm->allocator, r->_p.expr, *exprs, exprs)) {
+            out_of_memory_error(r->_vm);
         }
     }
 
     Parser_Error parser_error;
     if (false == parser_try_accept(&r->_p, (Token) {.type = TOKEN_EOF}, &parser_error)) {
-        switch (parser_error.type) {
-            case PARSER_SYNTAX_ERROR: {
-                auto const erroneous_line = slice_at(&lines, parser_error.as_syntax_error.pos.lineno - 1)->data;
-                syntax_error(r->_vm, parser_error.as_syntax_error, file_name, erroneous_line);
-            }
-            case PARSER_ALLOCATION_ERROR: {
+        return source_parser_error(r, source, lines_arena, file_name, parser_error);
+    }
+
+    return true;
+}
+
+// Rebuilds forms from a cache file by feeding its tokens to the parser.
+// Sets `*is_valid` to false if the cache file does not match the source or is malformed.
+static bool try_replay_cached(
+        ObjectReader *r,
+        Source cached,
+        FormCache_Key key,
+        Object **exprs,
+        bool *is_valid
+) {
+    guard_is_not_null(r);
+    guard_is_not_null(exprs);
+    guard_is_not_null(is_valid);
+
+    object_reader_reset(r);
+
+    FormCache_Reader reader;
+    *is_valid = form_cache_reader_try_open(cached, key, &reader);
+    if (false == *is_valid) {
+        return true;
+    }
+
+    while (true) {
+        Token token;
+        if (false == form_cache_reader_try_next(&reader, &token)) {
+            *is_valid = false;
+            return true;
+        }
+
+        Parser_Error parser_error;
+        if (false == parser_try_accept(&r->_p, token, &parser_error)) {
+            if (PARSER_ALLOCATION_ERROR == parser_error.type) {
                 out_of_memory_error(r->_vm);
             }
+
+            *is_valid = false;
+            return true;
         }
 
-        guard_unreachable();
-    }
+        if (TOKEN_EOF == token.type) {
+            return true;
+        }
 
-    return true;
+        if (false == r->_p.has_expr) {
+            continue;
+        }
+
+        if (false == object_try_make_list(&r->_vm->allocator, r->_p.expr, *exprs, exprs)) {
+            out_of_memory_error(r->_vm);
+        }
+    }
 }
 
-static bool reader_call(
+static bool try_read_all_cached(
         ObjectReader *r,
-        NamedFile file,
-        Object **exprs,
-        bool (*fn)(ObjectReader *, LineReader *, Arena *, char const *, Object **)
+        Source source,
+        Arena *lines_arena,
+        char const *file_name,
+        Object **exprs
 ) {
+    guard_is_not_null(r);
+    guard_is_not_null(r->_cache_dir);
+    guard_is_not_null(exprs);
+
+    auto const key = form_cache_key(source);
+    *exprs = OBJECT_NIL;
+
+    Source cached;
+    bool found;
+    errno_t error_code;
+    if (form_cache_try_load(r->_cache_dir, key, &cached, &found, &error_code) && found) {
+        bool is_valid;
+        auto const ok = try_replay_cached(r, cached, key, exprs, &is_valid);
+        source_free(&cached);
+        if (false == ok) {
+            return false;
+        }
+
+        if (is_valid) {
+            object_list_reverse_inplace(exprs);
+            return true;
+        }
+
+        *exprs = OBJECT_NIL;
+    }
+
+    if (false == try_read_all(r, source, lines_arena, file_name, exprs)) {
+        object_list_reverse_inplace(exprs);
+        return false;
+    }
+    object_list_reverse_inplace(exprs);
+
+    // The cache is an optimization: failing to update it does not fail the read.
+    auto sb = (StringBuilder) {0};
+    (void) (form_cache_try_encode(*exprs, key, &sb, &error_code)
+            && form_cache_try_store(r->_cache_dir, key, &sb, &error_code));
+    sb_free(&sb);
+
+    return true;
+}
+
+bool object_reader_try_prompt(ObjectReader *r, NamedFile file, Object **exprs) {
     auto lines_arena = (Arena) {0};
     auto line_reader = line_reader_make(file.handle);
 
-    auto const ok = fn(r, &line_reader, &lines_arena, file.name, exprs);
+    auto const ok = try_prompt(r, &line_reader, &lines_arena, file.name, exprs);
     object_list_reverse_inplace(exprs);
 
     arena_free(&lines_arena);
@@ -239,10 +368,221 @@ static bool reader_call(
     return ok;
 }
 
-bool object_reader_try_prompt(ObjectReader *r, NamedFile file, Object **exprs) {
-    return reader_call(r, file, exprs, try_prompt);
+bool object_reader_try_read_all(ObjectReader *r, NamedFile file, Object **exprs) {
+    Source source;
+    errno_t error_code;
+    if (false == source_try_load(file.handle, &source, &error_code)) {
+        os_error(r->_vm, error_code);
+    }
+
+    auto lines_arena = (Arena) {0};
+
+    bool ok;
+    if (nullptr == r->_cache_dir) {
+        ok = try_read_all(r, source, &lines_arena, file.name, exprs);
+        object_list_reverse_inplace(exprs);
+    } else {
+        ok = try_read_all_cached(r, source, &lines_arena, file.name, exprs);
+    }
+
+    arena_free(&lines_arena);
+    source_free(&source);
+
+    return ok;
 }
 
-bool object_reader_try_read_all(ObjectReader *r, NamedFile file, Object **exprs) {
-    return reader_call(r, file, exprs, try_read_all);
+#define STREAM_CHUNK_SIZE (64 * 1024)
+
+void object_reader_stream_free(ObjectReader_Stream *s) {
+    guard_is_not_null(s);
+
+    free(s->_window);
+    *s = (ObjectReader_Stream) {0};
+}
+
+static size_t stream_line_offset(ObjectReader_Stream const *s, size_t lineno) {
+    guard_is_greater_or_equal(lineno, s->_window_lineno);
+
+    size_t offset = 0;
+    for (auto i = s->_window_lineno; i < lineno; i++) {
+        char const *const newline = memchr(s->_window + offset, '\n', s->_fed - offset);
+        guard_is_not_null(newline);
+        offset = newline - s->_window + 1;
+    }
+
+    return offset;
+}
+
+// Drops the lines which can no longer be referred to by syntax errors:
+// everything before the line where the outermost unfinished expression begins.
+static void stream_compact(ObjectReader *r, ObjectReader_Stream *s) {
+    auto const lineno = tokenizer_lineno(s->_tokenizer);
+
+    size_t offset = s->_fed;
+    auto keep_lineno = lineno;
+    if (parser_is_inside_expression(r->_p)) {
+        keep_lineno = slice_at(&r->_p.exprs_stack, 0)->begin.lineno;
+        offset = stream_line_offset(s, keep_lineno);
+    }
+
+    memmove(s->_window, s->_window + offset, s->_window_size - offset);
+    s->_window_size -= offset;
+    s->_fed -= offset;
+    s->_window_lineno = keep_lineno;
+}
+
+// Reads until at least one more complete line (or the end of file) can be passed to the tokenizer.
+static bool stream_try_refill(ObjectReader *r, ObjectReader_Stream *s, errno_t *error_code) {
+    stream_compact(r, s);
+
+    while (true) {
+        if (s->_window_capacity - s->_window_size < STREAM_CHUNK_SIZE) {
+            auto const capacity = s->_window_capacity * 2 + STREAM_CHUNK_SIZE;
+
+            errno = 0;
+            auto const window = realloc(s->_window, capacity);
+            if (nullptr == window) {
+                *error_code = errno;
+                return false;
+            }
+
+            s->_window = window;
+            s->_window_capacity = capacity;
+        }
+
+        errno = 0;
+        auto const bytes_read = fread(s->_window + s->_window_size, 1, STREAM_CHUNK_SIZE, s->_file.handle);
+        if (ferror(s->_file.handle)) {
+            *error_code = errno;
+            return false;
+        }
+
+        // Bytes read previously contain no '\n', otherwise they would have been passed to the tokenizer.
+        auto const begin = s->_window + s->_fed;
+        auto const unseen = s->_window + s->_window_size;
+        s->_window_size += bytes_read;
+
+        if (feof(s->_file.handle)) {
+            tokenizer_feed(&s->_tokenizer, begin, s->_window_size - s->_fed, true);
+            s->_fed = s->_window_size;
+            return true;
+        }
+
+        auto end = s->_window + s->_window_size;
+        while (end > unseen && '\n' != end[-1]) {
+            end--;
+        }
+
+        if (end > unseen) {
+            tokenizer_feed(&s->_tokenizer, begin, end - begin, false);
+            s->_fed = end - s->_window;
+            return true;
+        }
+    }
+}
+
+static Source stream_source(ObjectReader_Stream const *s) {
+    return (Source) {.data = s->_window, .size = s->_window_size};
+}
+
+static bool stream_syntax_error(ObjectReader *r, ObjectReader_Stream *s, Arena *lines_arena, SyntaxError error) {
+    error.pos.lineno -= s->_window_lineno - 1;
+
+    char const *erroneous_line;
+    errno_t error_code;
+    if (false == source_try_copy_line(stream_source(s), error.pos.lineno, lines_arena, &erroneous_line, &error_code)) {
+        os_error(r->_vm, error_code);
+    }
+
+    error.pos.lineno += s->_window_lineno - 1;
+    syntax_error(r->_vm, error, s->_file.name, erroneous_line);
+}
+
+static bool stream_parser_error(ObjectReader *r, ObjectReader_Stream *s, Arena *lines_arena, Parser_Error error) {
+    switch (error.type) {
+        case PARSER_SYNTAX_ERROR: {
+            return stream_syntax_error(r, s, lines_arena, error.as_syntax_error);
+        }
+        case PARSER_ALLOCATION_ERROR: {
+            out_of_memory_error(r->_vm);
+        }
+    }
+
+    guard_unreachable();
+}
+
+static bool try_stream(ObjectReader *r, ObjectReader_Stream *s, Arena *lines_arena, Object **exprs) {
+    guard_is_not_null(r);
+    guard_is_not_null(s);
+    guard_is_not_null(exprs);
+
+    *exprs = OBJECT_NIL;
+
+    if (s->_eof) {
+        return true;
+    }
+
+    // Expressions returned previously may have been evaluated using the same reader.
+    object_reader_reset(r);
+    if (s->_started) {
+        tokenizer_replay(&s->_tokenizer, &r->_s);
+    }
+    s->_started = true;
+
+    while (true) {
+        SyntaxError syntax_error;
+        if (false == tokenizer_try_next(&s->_tokenizer, &r->_s, &syntax_error)) {
+            return stream_syntax_error(r, s, lines_arena, syntax_error);
+        }
+
+        if (false == r->_s.has_token && false == tokenizer_is_done(s->_tokenizer)) {
+            errno_t error_code;
+            if (false == stream_try_refill(r, s, &error_code)) {
+                os_error(r->_vm, error_code);
+            }
+
+            continue;
+        }
+
+        if (false == r->_s.has_token) {
+            break;
+        }
+
+        Parser_Error parser_error;
+        if (false == parser_try_accept(&r->_p, r->_s.token, &parser_error)) {
+            return stream_parser_error(r, s, lines_arena, parser_error);
+        }
+
+        if (false == r->_p.has_expr) {
+            continue;
+        }
+
+        if (false == object_try_make_list(&r->_vm->allocator, r->_p.expr, *exprs, exprs)) {
+            out_of_memory_error(r->_vm);
+        }
+
+        if (false == parser_is_inside_expression(r->_p)) {
+            return true;
+        }
+    }
+
+    s->_eof = true;
+
+    Parser_Error parser_error;
+    if (false == parser_try_accept(&r->_p, (Token) {.type = TOKEN_EOF}, &parser_error)) {
+        return stream_parser_error(r, s, lines_arena, parser_error);
+    }
+
+    return true;
+}
+
+bool object_reader_try_stream(ObjectReader *r, ObjectReader_Stream *s, Object **exprs) {
+    auto lines_arena = (Arena) {0};
+
+    auto const ok = try_stream(r, s, &lines_arena, exprs);
+    object_list_reverse_inplace(exprs);
+
+    arena_free(&lines_arena);
+
+    return ok;
 }
@@ -8,6 +8,7 @@
 #include "syntax_error.h"
 #include "parser.h"
 #include "named_file.h"
+#include "tokenizer.h"
 
 struct VirtualMachine;
 
@@ -15,11 +16,15 @@ typedef struct ObjectReader {
     struct VirtualMachine *_vm;
     Scanner _s;
     Parser _p;
+    char const *_cache_dir;
 } ObjectReader;
 
 typedef struct {
     Scanner_Config scanner_config;
     Parser_Config parser_config;
+    // Directory for parsed forms of files read with `object_reader_try_read_all`;
+    // `nullptr` disables the cache.
+    char const *cache_dir;
 } Reader_Config;
 
 bool object_reader_try_init(
@@ -38,3 +43,32 @@ bool object_reader_try_prompt(ObjectReader *r, NamedFile file, Object **exprs);
 
 [[nodiscard]]
 bool object_reader_try_read_all(ObjectReader *r, NamedFile file, Object **exprs);
+
+// Reads a file one top-level expression at a time, keeping only the lines
+// of the expression being parsed in memory.
+typedef struct {
+    NamedFile _file;
+    char *_window;
+    size_t _window_size;
+    size_t _window_capacity;
+    size_t _window_lineno;
+    size_t _fed;
+    bool _eof;
+    bool _started;
+    Tokenizer _tokenizer;
+} ObjectReader_Stream;
+
+#define object_reader_stream_make(File)     \
+((ObjectReader_Stream) {                    \
+    ._file = (File),                        \
+    ._window_lineno = 1,                    \
+    ._tokenizer = tokenizer_make_empty()    \
+})
+
+void object_reader_stream_free(ObjectReader_Stream *s);
+
+// Sets `*exprs` to the next complete top-level expressions (usually exactly one)
+// or to nil when the stream is exhausted. Evaluating expressions before reading
+// further is allowed to use the reader.
+[[nodiscard]]
+bool object_reader_try_stream(ObjectReader *r, ObjectReader_Stream *s, Object **exprs);
@@ -8,6 +8,7 @@
 #include "utility/math.h"
 #include "utility/guards.h"
 #include "utility/strings.h"
+#include "char_class.h"
 
 #define SINGLE_QUOTE    '\''
 #define DOUBLE_QUOTE    '"'
@@ -148,7 +149,7 @@ static bool any_accept(Scanner *s, Position pos, int c, SyntaxError *error) {
     if (is_name_char(c)) {
         transition(s, pos, SCANNER_SYMBOL);
 
-        if (false == sb_try_printf(&s->_sb, "%c", (char) c)) {
+        if (false == sb_try_append_char(&s->_sb, (char) c)) {
             *error = (SyntaxError) {
                     .code = SYNTAX_ERROR_TOKEN_TOO_LONG,
                     .pos = {.lineno = pos.lineno, s->_token_pos.col, pos.end_col}
@@ -270,7 +271,7 @@ static bool string_accept(Scanner *s, Position pos, int c, SyntaxError *error) {
         char represented_char;
         if (string_try_get_escape_seq_value((char) c, &represented_char)) {
 
-            if (false == sb_try_printf(&s->_sb, "%c", represented_char)) {
+            if (false == sb_try_append_char(&s->_sb, represented_char)) {
                 *error = (SyntaxError) {
                         .code = SYNTAX_ERROR_TOKEN_TOO_LONG,
                         .pos = {.lineno = pos.lineno, s->_token_pos.col, pos.end_col}
@@ -303,7 +304,7 @@ static bool string_accept(Scanner *s, Position pos, int c, SyntaxError *error) {
     if (is_printable(c)) {
         s->_token_pos.end_col = pos.end_col;
 
-        if (false == sb_try_printf(&s->_sb, "%c", (char) c)) {
+        if (false == sb_try_append_char(&s->_sb, (char) c)) {
             *error = (SyntaxError) {
                     .code = SYNTAX_ERROR_TOKEN_TOO_LONG,
                     .pos = {.lineno = pos.lineno, s->_token_pos.col, pos.end_col}
@@ -367,7 +368,7 @@ static bool name_accept(Scanner *s, Position pos, int c, SyntaxError *error) {
     if (is_name_char(c)) {
         s->_token_pos.end_col = pos.end_col;
 
-        if (false == sb_try_printf(&s->_sb, "%c", (char) c)) {
+        if (false == sb_try_append_char(&s->_sb, (char) c)) {
             *error = (SyntaxError) {
                     .code = SYNTAX_ERROR_TOKEN_TOO_LONG,
                     .pos = {.lineno = pos.lineno, s->_token_pos.col, pos.end_col}
@@ -447,7 +448,7 @@ static bool dot_accept(Scanner *s, Position pos, int c, SyntaxError *error) {
     if (is_name_char(c)) {
         transition(s, pos, SCANNER_SYMBOL);
 
-        if (false == sb_try_printf(&s->_sb, "%c", (char) c)) {
+        if (false == sb_try_append_char(&s->_sb, (char) c)) {
             *error = (SyntaxError) {
                     .code = SYNTAX_ERROR_TOKEN_TOO_LONG,
                     .pos = {.lineno = pos.lineno, s->_token_pos.col, pos.end_col}
@@ -530,6 +531,59 @@ bool scanner_try_accept(Scanner *s, Position pos, int c, SyntaxError *error) {
     guard_unreachable();
 }
 
+size_t scanner_skip(Scanner *s, Position pos, char const *chars, size_t count) {
+    guard_is_not_null(s);
+    guard_is_not_null(chars);
+
+    s->has_token = false;
+
+    switch (s->_state) {
+        case SCANNER_WS: {
+            auto const span = char_class_span_whitespace(chars, count);
+            return 0 == span ? 0 : span - 1;
+        }
+        case SCANNER_COMMENT: {
+            auto const span = char_class_span_printable(chars, count);
+            return 0 == span ? 0 : span - 1;
+        }
+        case SCANNER_SYMBOL: {
+            if (1 == s->_sb.length) {
+                return 0;
+            }
+
+            auto const span = char_class_span_name(chars, count);
+            if (0 == span || false == sb_try_append_bytes(&s->_sb, chars, span)) {
+                return 0;
+            }
+
+            s->_token_pos.end_col = pos.end_col + span - 1;
+            return span;
+        }
+        case SCANNER_STRING: {
+            if (s->_string_terminated || s->_escape_sequence) {
+                return 0;
+            }
+
+            auto const span = char_class_span_string(chars, count);
+            if (0 == span || false == sb_try_append_bytes(&s->_sb, chars, span)) {
+                return 0;
+            }
+
+            s->_token_pos.end_col = pos.end_col + span - 1;
+            return span;
+        }
+        case SCANNER_INT:
+        case SCANNER_OPEN_PAREN:
+        case SCANNER_CLOSE_PAREN:
+        case SCANNER_QUOTE:
+        case SCANNER_DOT: {
+            return 0;
+        }
+    }
+
+    guard_unreachable();
+}
+
 bool scanner_try_init(Scanner *s, Scanner_Config config, errno_t *error_code) {
     guard_is_not_null(s);
     guard_is_not_null(error_code);
@@ -63,3 +63,9 @@ void scanner_reset(Scanner *s);
 
 [[nodiscard]]
 bool scanner_try_accept(Scanner *s, Position pos, int c, SyntaxError *error);
+
+// Consumes the longest prefix of `chars` that leaves the scanner in its current state
+// without producing a token, as if each character was passed to `scanner_try_accept`
+// (`pos` is the position of the first one). Never fails: characters that would not be
+// accepted are left for `scanner_try_accept`. Returns the number of characters consumed.
+size_t scanner_skip(Scanner *s, Position pos, char const *chars, size_t count);
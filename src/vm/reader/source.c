@@ -0,0 +1,157 @@
+#include "source.h"
+
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "utility/guards.h"
+#include "utility/string_builder.h"
+#include "position.h"
+
+#define READ_CHUNK_SIZE (64 * 1024)
+
+static bool try_map(FILE *file, Source *source, bool *mapped, errno_t *error_code) {
+    *mapped = false;
+
+    auto const fd = fileno(file);
+    struct stat st;
+    if (fd < 0 || 0 != fstat(fd, &st) || false == S_ISREG(st.st_mode)) {
+        return true;
+    }
+
+    auto const offset = ftello(file);
+    if (offset < 0 || offset >= st.st_size) {
+        return true;
+    }
+
+    auto const mapping_size = (size_t) st.st_size;
+    errno = 0;
+    auto const mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == mapping) {
+        *error_code = errno;
+        return false;
+    }
+
+    *source = (Source) {
+            .data = (char const *) mapping + offset,
+            .size = mapping_size - (size_t) offset,
+            ._mapping = mapping,
+            ._mapping_size = mapping_size
+    };
+    *mapped = true;
+
+    return true;
+}
+
+static bool try_read(FILE *file, Source *source, errno_t *error_code) {
+    char *buffer = nullptr;
+    size_t size = 0;
+    size_t capacity = 0;
+
+    while (true) {
+        if (capacity - size < READ_CHUNK_SIZE) {
+            capacity = capacity * 2 + READ_CHUNK_SIZE;
+
+            errno = 0;
+            auto const new_buffer = realloc(buffer, capacity);
+            if (nullptr == new_buffer) {
+                *error_code = errno;
+                free(buffer);
+                return false;
+            }
+
+            buffer = new_buffer;
+        }
+
+        errno = 0;
+        auto const bytes_read = fread(buffer + size, 1, capacity - size, file);
+        size += bytes_read;
+
+        if (ferror(file)) {
+            *error_code = errno;
+            free(buffer);
+            return false;
+        }
+
+        if (feof(file)) {
+            break;
+        }
+    }
+
+    *source = (Source) {
+            .data = buffer,
+            .size = size,
+            ._buffer = buffer
+    };
+
+    return true;
+}
+
+bool source_try_load(FILE *file, Source *source, errno_t *error_code) {
+    guard_is_not_null(file);
+    guard_is_not_null(source);
+    guard_is_not_null(error_code);
+
+    bool mapped;
+    if (false == try_map(file, source, &mapped, error_code)) {
+        return false;
+    }
+
+    if (mapped) {
+        return true;
+    }
+
+    return try_read(file, source, error_code);
+}
+
+void source_free(Source *source) {
+    guard_is_not_null(source);
+
+    if (nullptr != source->_mapping) {
+        munmap(source->_mapping, source->_mapping_size);
+    }
+    free(source->_buffer);
+
+    *source = (Source) {0};
+}
+
+bool source_try_copy_line(Source source, size_t lineno, Arena *a, char const **line, errno_t *error_code) {
+    guard_is_greater(lineno, 0);
+    guard_is_not_null(a);
+    guard_is_not_null(line);
+    guard_is_not_null(error_code);
+
+    auto const end = source.data + source.size;
+
+    auto begin = source.data;
+    for (size_t i = 1; i < lineno && begin < end; i++) {
+        char const *const newline = memchr(begin, '\n', end - begin);
+        begin = nullptr == newline ? end : newline + 1;
+    }
+
+    char const *const newline = memchr(begin, '\n', end - begin);
+    auto const line_end = nullptr == newline ? end : newline;
+
+    auto sb = (StringBuilder) {0};
+    auto ok = sb_try_reserve(&sb, line_end - begin + 1, error_code);
+    auto terminated = false;
+    for (auto it = begin; ok && it < line_end; it++) {
+        if ('\0' == *it) {
+            terminated = true;
+            break;
+        }
+
+        ok = '\t' == *it
+             ? sb_try_append_bytes(&sb, error_code, TAB_AS_SPACES, strlen(TAB_AS_SPACES))
+             : sb_try_append_char(&sb, error_code, *it);
+    }
+
+    if (ok && false == terminated) {
+        ok = sb_try_append_char(&sb, error_code, '\n');
+    }
+
+    ok = ok && arena_try_copy_all(a, sb.str, sb.length + 1, line, error_code);
+
+    sb_free(&sb);
+    return ok;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "utility/arena.h"
+
+typedef struct {
+    char const *data;
+    size_t size;
+
+    void *_mapping;
+    size_t _mapping_size;
+    char *_buffer;
+} Source;
+
+// Maps regular files into memory and reads any other stream to its end.
+[[nodiscard]]
+bool source_try_load(FILE *file, Source *source, errno_t *error_code);
+
+void source_free(Source *source);
+
+// Copies line `lineno` (1-based) into the arena the way `LineReader` would produce it:
+// tabs expanded, terminated by '\n'.
+[[nodiscard]]
+bool source_try_copy_line(Source source, size_t lineno, Arena *a, char const **line, errno_t *error_code);
@@ -0,0 +1,135 @@
+#include "tokenizer.h"
+
+#include <string.h>
+
+#include "utility/exchange.h"
+#include "utility/guards.h"
+
+static char const *line_end(char const *begin, char const *end) {
+    char const *const newline = memchr(begin, '\n', end - begin);
+    return nullptr == newline ? end : newline;
+}
+
+static Position advance(Tokenizer *t, size_t count) {
+    return exchange(t->_pos, ((Position) {
+            .lineno = t->_pos.lineno,
+            .col = t->_pos.col + count,
+            .end_col = t->_pos.end_col + count
+    }));
+}
+
+Tokenizer tokenizer_make_empty() {
+    return (Tokenizer) {._pos = {.lineno = 1}};
+}
+
+Tokenizer tokenizer_make(char const *data, size_t size) {
+    auto t = tokenizer_make_empty();
+    tokenizer_feed(&t, data, size, true);
+    return t;
+}
+
+void tokenizer_feed(Tokenizer *t, char const *data, size_t size, bool is_last) {
+    guard_is_not_null(t);
+    guard_is_not_null(data);
+    guard_is_false(t->_is_last);
+    guard_is_equal(t->_it, t->_end);
+
+    auto const end = data + size;
+    t->_it = data;
+    t->_line_end = line_end(data, end);
+    t->_end = end;
+    t->_is_last = is_last;
+}
+
+bool tokenizer_is_done(Tokenizer t) {
+    return t._done;
+}
+
+size_t tokenizer_lineno(Tokenizer t) {
+    return t._pos.lineno;
+}
+
+static bool try_accept(Tokenizer *t, Scanner *s, Position pos, int c, SyntaxError *error) {
+    t->_last_char = c;
+    t->_last_pos = pos;
+    return scanner_try_accept(s, pos, c, error);
+}
+
+void tokenizer_replay(Tokenizer const *t, Scanner *s) {
+    guard_is_not_null(t);
+    guard_is_not_null(s);
+
+    scanner_reset(s);
+
+    SyntaxError error;
+    auto const ok = scanner_try_accept(s, t->_last_pos, t->_last_char, &error);
+    guard_is_true(ok);
+    guard_is_false(s->has_token);
+}
+
+static void next_line(Tokenizer *t) {
+    if (t->_line_end == t->_end) {
+        t->_done = true;
+        return;
+    }
+
+    t->_it = t->_line_end + 1;
+    t->_line_end = line_end(t->_it, t->_end);
+    t->_pos = (Position) {.lineno = t->_pos.lineno + 1};
+    t->_line_cut = false;
+}
+
+bool tokenizer_try_next(Tokenizer *t, Scanner *s, SyntaxError *error) {
+    guard_is_not_null(t);
+    guard_is_not_null(s);
+    guard_is_not_null(error);
+
+    s->has_token = false;
+
+    while (false == t->_done) {
+        if (t->_pending_spaces > 0) {
+            t->_pending_spaces--;
+
+            if (false == try_accept(t, s, advance(t, 1), ' ', error)) {
+                return false;
+            }
+        } else if (t->_it == t->_end && false == t->_is_last) {
+            return true;
+        } else if (t->_it == t->_line_end) {
+            // Like a '\0' read by `LineReader`, which hides the rest of the line including its '\n'.
+            auto const cut = t->_line_cut;
+            auto const pos = advance(t, 1);
+            next_line(t);
+
+            if (false == cut && false == try_accept(t, s, pos, '\n', error)) {
+                return false;
+            }
+        } else if ('\0' == *t->_it) {
+            t->_it = t->_line_end;
+            t->_line_cut = true;
+            continue;
+        } else if ('\t' == *t->_it) {
+            t->_it++;
+            t->_pending_spaces = strlen(TAB_AS_SPACES);
+            continue;
+        } else {
+            auto const skipped = scanner_skip(s, t->_pos, t->_it, t->_line_end - t->_it);
+            if (skipped > 0) {
+                t->_it += skipped;
+                advance(t, skipped);
+                continue;
+            }
+
+            auto const c = (unsigned char) *t->_it++;
+            if (false == try_accept(t, s, advance(t, 1), c, error)) {
+                return false;
+            }
+        }
+
+        if (s->has_token) {
+            return true;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "position.h"
+#include "scanner.h"
+#include "syntax_error.h"
+
+// Feeds a whole in-memory source to a scanner, producing the same tokens and
+// positions as feeding it line by line from a `LineReader`.
+typedef struct {
+    char const *_it;
+    char const *_line_end;
+    char const *_end;
+    bool _is_last;
+    Position _pos;
+    size_t _pending_spaces;
+    bool _line_cut;
+    bool _done;
+
+    int _last_char;
+    Position _last_pos;
+} Tokenizer;
+
+Tokenizer tokenizer_make(char const *data, size_t size);
+
+// A tokenizer waiting for the first part of a source passed to `tokenizer_feed`.
+Tokenizer tokenizer_make_empty();
+
+// Continues with the next part of a source. Every part but the last one must end with '\n'.
+void tokenizer_feed(Tokenizer *t, char const *data, size_t size, bool is_last);
+
+bool tokenizer_is_done(Tokenizer t);
+
+// Number of the line the next character belongs to.
+size_t tokenizer_lineno(Tokenizer t);
+
+// Restores the state of a scanner which was reset after producing its last token
+// by feeding it the character that made it produce that token once again.
+void tokenizer_replay(Tokenizer const *t, Scanner *s);
+
+// Advances until the scanner produces a token (`s->has_token`), the source is exhausted
+// or the part passed to `tokenizer_feed` is.
+[[nodiscard]]
+bool tokenizer_try_next(Tokenizer *t, Scanner *s, SyntaxError *error);
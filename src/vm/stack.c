@@ -44,6 +44,46 @@ bool stack_is_empty(Stack *s) {
     return nullptr == s->_top;
 }
 
+char const *frame_type_str(Stack_FrameType type) {
+    switch (type) {
+        case FRAME_CALL: {
+            return "call";
+        }
+        case FRAME_FN: {
+            return "fn";
+        }
+        case FRAME_MACRO: {
+            return "macro";
+        }
+        case FRAME_IF: {
+            return "if";
+        }
+        case FRAME_DO: {
+            return "do";
+        }
+        case FRAME_DEFINE: {
+            return "define";
+        }
+        case FRAME_IMPORT: {
+            return "import";
+        }
+        case FRAME_QUOTE: {
+            return "quote";
+        }
+        case FRAME_CATCH: {
+            return "catch";
+        }
+        case FRAME_AND: {
+            return "and";
+        }
+        case FRAME_OR: {
+            return "or";
+        }
+    }
+
+    guard_unreachable();
+}
+
 Stack_Frame frame_make(
         Stack_FrameType type,
         Object *expr,
@@ -61,7 +101,8 @@ Stack_Frame frame_make(
             .env = env,
             .results_list = results_list,
             .unevaluated = unevaluated,
-            .evaluated = OBJECT_NIL
+            .evaluated = OBJECT_NIL,
+            .body = OBJECT_NIL
     };
 }
 
@@ -16,6 +16,8 @@ typedef enum {
     FRAME_OR
 } Stack_FrameType;
 
+char const *frame_type_str(Stack_FrameType type);
+
 typedef struct {
     Stack_FrameType type;
     Object *expr;
@@ -23,6 +25,9 @@ typedef struct {
     Object *unevaluated;
     Object *evaluated;
     Object **results_list;
+    // The body of the closure or macro the frame evaluates, kept by the frames that replace
+    // it in tail position: the frame stands for the call (see `profiler.h`). Nil otherwise.
+    Object *body;
 } Stack_Frame;
 
 Stack_Frame frame_make(
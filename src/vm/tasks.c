@@ -0,0 +1,468 @@
+#include "tasks.h"
+
+#include <stdlib.h>
+
+#include "utility/guards.h"
+#include "utility/exchange.h"
+#include "utility/dynamic_array.h"
+#include "utility/slice.h"
+#include "object/list.h"
+#include "object/accessors.h"
+#include "object/constructors.h"
+#include "virtual_machine.h"
+#include "errors.h"
+#include "trace.h"
+
+#define TASKS_DEFAULT_FUEL 1000
+
+void tasks_init(Tasks *t, Tasks_Config config, Stack_Config vm_stack_config) {
+    guard_is_not_null(t);
+
+    if (0 == config.fuel) {
+        config.fuel = TASKS_DEFAULT_FUEL;
+    }
+    if (0 == config.stack_config.size_bytes) {
+        config.stack_config = vm_stack_config;
+    }
+
+    *t = (Tasks) {
+            .main = {.value = OBJECT_NIL, .error = OBJECT_NIL, .state = TASK_READY},
+            ._config = config,
+            ._fuel = config.fuel,
+    };
+    t->main.owner = t;
+    t->_running = &t->main;
+    pthread_mutex_init(&t->_lock, nullptr);
+    pthread_cond_init(&t->_has_woken, nullptr);
+}
+
+static void free_task(Task *task) {
+    stack_free(&task->stack);
+    free(task);
+}
+
+void tasks_free(Tasks *t) {
+    guard_is_not_null(t);
+    guard_is_true(tasks_is_main_running(t));
+
+    slice_for_v(it, t->spawned) {
+        guard_is_equal((*it)->wait, nullptr);
+        free_task(*it);
+    }
+    da_free(&t->spawned);
+    pthread_cond_destroy(&t->_has_woken);
+    pthread_mutex_destroy(&t->_lock);
+}
+
+void tasks_cancel_waits(Tasks *t) {
+    guard_is_not_null(t);
+    guard_is_true(tasks_is_main_running(t));
+
+    slice_for_v(it, t->spawned) {
+        auto const task = *it;
+        if (nullptr != task->wait) {
+            task->wait->cancel(task->wait_context);
+            task->wait = nullptr;
+        }
+    }
+}
+
+bool tasks_is_main_running(Tasks const *t) {
+    guard_is_not_null(t);
+
+    return &t->main == t->_running;
+}
+
+size_t tasks_running_id(Tasks const *t) {
+    guard_is_not_null(t);
+
+    return t->_running->id;
+}
+
+bool tasks_should_switch(Tasks *t) {
+    guard_is_not_null(t);
+
+    return 0 == --t->_fuel || t->_yielded || TASK_READY != t->_running->state;
+}
+
+bool tasks_is_blocked(Tasks const *t) {
+    guard_is_not_null(t);
+
+    return TASK_WAITING == t->_running->state;
+}
+
+static void remove_task(Task *task) {
+    auto const spawned = &task->owner->spawned;
+    auto const last = spawned->data[--spawned->count];
+    spawned->data[task->index] = last;
+    last->index = task->index;
+
+    free_task(task);
+}
+
+static void push_ready(Tasks *t, Task *task) {
+    task->next = nullptr;
+    if (nullptr == t->_ready_tail) {
+        t->_ready_head = task;
+    } else {
+        t->_ready_tail->next = task;
+    }
+    t->_ready_tail = task;
+}
+
+static bool try_pop_ready(Tasks *t, Task **task) {
+    if (nullptr == t->_ready_head) {
+        return false;
+    }
+
+    *task = t->_ready_head;
+    t->_ready_head = (*task)->next;
+    if (nullptr == t->_ready_head) {
+        t->_ready_tail = nullptr;
+    }
+    return true;
+}
+
+static void unlink_waiter(Task *task, Task *waiter) {
+    auto link = &task->waiters;
+    while (waiter != *link) {
+        link = &(*link)->next;
+    }
+    *link = waiter->next;
+}
+
+static bool can_wake(Task const *task) {
+    return TASK_WAITING == task->state
+           && nullptr == task->joining
+           && (nullptr == task->wait || task->wait->can_wake(task->wait_context));
+}
+
+// Whether a suspended task may be woken up by another thread.
+static bool is_any_wakeable(Tasks const *t) {
+    if (0 == t->_suspended) {
+        return false;
+    }
+
+    if (can_wake(&t->main)) {
+        return true;
+    }
+    slice_for_v(it, t->spawned) {
+        if (can_wake(*it)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Nothing is ready and nothing can wake up a suspended task, so every task left waits for
+// another one, the main task included: the call it waits in fails, or `try_eval` would never
+// return.
+static Task *break_deadlock(Tasks *t) {
+    auto const main = &t->main;
+    guard_is_equal(main->state, TASK_WAITING);
+    if (nullptr != main->joining) {
+        unlink_waiter(main->joining, main);
+        main->joining = nullptr;
+    } else {
+        main->wait->cancel(main->wait_context);
+        main->wait = nullptr;
+        t->_suspended--;
+    }
+    main->state = TASK_READY;
+    t->_deadlocked = true;
+    return main;
+}
+
+// Moves the tasks other threads woke up to the ready queue, waiting for one if asked to. Fails
+// if none may ever be woken up. Checked under the lock, so that a task woken up by a thread
+// which then lets go of what the task waits on is still taken.
+static bool try_take_woken(Tasks *t, bool should_wait) {
+    pthread_mutex_lock(&t->_lock);
+    while (should_wait && nullptr == t->_woken) {
+        if (false == is_any_wakeable(t)) {
+            pthread_mutex_unlock(&t->_lock);
+            return false;
+        }
+        pthread_cond_wait(&t->_has_woken, &t->_lock);
+    }
+    auto woken = exchange(t->_woken, nullptr);
+    pthread_mutex_unlock(&t->_lock);
+
+    while (nullptr != woken) {
+        auto const next = woken->next;
+        woken->state = TASK_READY;
+        woken->wait = nullptr;
+        t->_suspended--;
+        push_ready(t, woken);
+        woken = next;
+    }
+
+    return true;
+}
+
+static Task *next_ready(Tasks *t) {
+    Task *next;
+    while (false == try_pop_ready(t, &next)) {
+        if (false == try_take_woken(t, true)) {
+            return break_deadlock(t);
+        }
+    }
+
+    return next;
+}
+
+static void resume(VirtualMachine *vm, Task *next) {
+    auto const t = &vm->tasks;
+    t->_fuel = t->_config.fuel;
+    t->_yielded = false;
+    if (next == t->_running) {
+        return;
+    }
+
+    t->_running->stack = vm->stack;
+    vm->stack = exchange(next->stack, (Stack) {0});
+    t->_running = next;
+}
+
+void tasks_switch(VirtualMachine *vm) {
+    guard_is_not_null(vm);
+
+    auto const t = &vm->tasks;
+    auto const running = t->_running;
+    // Checked first: a suspended task may be woken up below, and queued by `try_take_woken`.
+    auto const is_blocked = TASK_READY != running->state;
+    if (t->_suspended > 0) {
+        try_take_woken(t, false);
+    }
+
+    if (false == is_blocked) {
+        if (nullptr == t->_ready_head) {
+            resume(vm, running);
+            return;
+        }
+
+        push_ready(t, running);
+    }
+
+    resume(vm, next_ready(t));
+}
+
+void tasks_finish(VirtualMachine *vm, bool is_error) {
+    guard_is_not_null(vm);
+    guard_is_true(stack_is_empty(&vm->stack));
+
+    auto const t = &vm->tasks;
+    auto const task = t->_running;
+    guard_is_false(tasks_is_main_running(t));
+
+    if (is_error) {
+        task->state = TASK_FAILED;
+        task->error = exchange(vm->error, OBJECT_NIL);
+    } else {
+        task->state = TASK_DONE;
+        task->value = object_as_list(task->value).first;
+    }
+
+    for (auto waiter = exchange(task->waiters, nullptr); nullptr != waiter;) {
+        auto const next = waiter->next;
+        waiter->state = TASK_READY;
+        waiter->joining = nullptr;
+        push_ready(t, waiter);
+        waiter = next;
+    }
+
+    resume(vm, next_ready(t));
+
+    // Only its value or error is needed from now on.
+    stack_free(&task->stack);
+    if (task->is_detached) {
+        remove_task(task);
+    }
+}
+
+static void release_task(void *data) {
+    Task *task = data;
+    if (TASK_DONE == task->state || TASK_FAILED == task->state) {
+        remove_task(task);
+        return;
+    }
+
+    task->is_detached = true;
+}
+
+static Object_HandleClass const TASK_CLASS = {.name = "task", .release = release_task};
+
+// The call is made by the first step of the task: its frame starts with the function and
+// arguments already evaluated, in reverse.
+static bool try_push_call(VirtualMachine *vm, Task *task, Object *fn, Object *args, Object **evaluated) {
+    auto const a = &vm->allocator;
+    if (false == object_try_make_list(a, fn, OBJECT_NIL, evaluated)) {
+        out_of_memory_error(vm);
+    }
+
+    object_list_for(it, args) {
+        if (false == object_try_make_list(a, it, *evaluated, evaluated)) {
+            out_of_memory_error(vm);
+        }
+    }
+
+    auto const spawn_frame = stack_top(&vm->stack);
+    auto frame = frame_make(FRAME_CALL, spawn_frame->expr, spawn_frame->env, &task->value, OBJECT_NIL);
+    frame.evaluated = *evaluated;
+    if (false == stack_try_push_frame(&task->stack, frame)) {
+        stack_overflow_error(vm);
+    }
+    if (nullptr != vm->config.trace) {
+        trace_record(vm->config.trace, TRACE_FRAME_PUSH, task->id, FRAME_CALL);
+    }
+
+    return true;
+}
+
+bool tasks_try_spawn(VirtualMachine *vm, Object *fn, Object *args, Object **task) {
+    guard_is_not_null(vm);
+    guard_is_not_null(fn);
+    guard_is_not_null(args);
+    guard_is_not_null(task);
+
+    auto const t = &vm->tasks;
+    auto const new_task = (Task *) calloc(1, sizeof(Task));
+    if (nullptr == new_task) {
+        out_of_memory_error(vm);
+    }
+
+    *new_task = (Task) {
+            .value = OBJECT_NIL,
+            .error = OBJECT_NIL,
+            .state = TASK_READY,
+            .owner = t,
+            .index = t->spawned.count,
+            .id = ++t->_last_id
+    };
+
+    errno_t error_code;
+    if (false == stack_try_init(&new_task->stack, t->_config.stack_config, &error_code)) {
+        free(new_task);
+        out_of_memory_error(vm);
+    }
+
+    if (false == da_try_append(&t->spawned, new_task)) {
+        free_task(new_task);
+        out_of_memory_error(vm);
+    }
+
+    // From now on the collector marks the task's frame.
+    if (false == try_push_call(vm, new_task, fn, args, task)) {
+        remove_task(new_task);
+        return false;
+    }
+
+    if (false == object_try_make_handle(&vm->allocator, &TASK_CLASS, new_task, task)) {
+        remove_task(new_task);
+        out_of_memory_error(vm);
+    }
+
+    push_ready(t, new_task);
+    return true;
+}
+
+void tasks_yield(VirtualMachine *vm) {
+    guard_is_not_null(vm);
+
+    vm->tasks._yielded = true;
+}
+
+static bool is_task(Object *obj) {
+    return TYPE_HANDLE == obj->type && &TASK_CLASS == obj->as_handle.class;
+}
+
+bool tasks_try_join(VirtualMachine *vm, Object *task, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(task);
+    guard_is_not_null(value);
+
+    if (false == is_task(task)) {
+        type_error(vm, task->type, TYPE_HANDLE);
+    }
+
+    auto const t = &vm->tasks;
+    Task *joined = task->as_handle.data;
+    switch (joined->state) {
+        case TASK_DONE: {
+            *value = joined->value;
+            return true;
+        }
+        case TASK_FAILED: {
+            vm->error = joined->error;
+            return false;
+        }
+        case TASK_READY:
+        case TASK_WAITING: {
+            break;
+        }
+    }
+
+    if (tasks_take_deadlock(t)) {
+        value_error(vm, "deadlock: every task is waiting for another");
+    }
+
+    auto const running = t->_running;
+    if (joined == running) {
+        value_error(vm, "a task can not join itself");
+    }
+
+    running->state = TASK_WAITING;
+    running->joining = joined;
+    running->next = joined->waiters;
+    joined->waiters = running;
+
+    *value = OBJECT_NIL;
+    return true;
+}
+
+Task *tasks_suspend(VirtualMachine *vm, Tasks_Wait const *wait, void *context) {
+    guard_is_not_null(vm);
+
+    auto const t = &vm->tasks;
+    auto const running = t->_running;
+    guard_is_equal(running->state, TASK_READY);
+
+    running->state = TASK_WAITING;
+    running->wait = wait;
+    running->wait_context = context;
+    t->_suspended++;
+    return running;
+}
+
+void tasks_wake(Tasks *t, Task *task, void *wakeup) {
+    guard_is_not_null(t);
+    guard_is_not_null(task);
+    guard_is_not_null(wakeup);
+
+    pthread_mutex_lock(&t->_lock);
+    task->wakeup = wakeup;
+    task->next = t->_woken;
+    t->_woken = task;
+    pthread_cond_signal(&t->_has_woken);
+    pthread_mutex_unlock(&t->_lock);
+}
+
+bool tasks_try_take_wakeup(Tasks *t, void **wakeup) {
+    guard_is_not_null(t);
+    guard_is_not_null(wakeup);
+
+    auto const running = t->_running;
+    if (nullptr == running->wakeup) {
+        return false;
+    }
+
+    *wakeup = exchange(running->wakeup, nullptr);
+    return true;
+}
+
+bool tasks_take_deadlock(Tasks *t) {
+    guard_is_not_null(t);
+
+    return exchange(t->_deadlocked, false);
+}
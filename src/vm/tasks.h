@@ -0,0 +1,145 @@
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "object/object.h"
+#include "stack.h"
+
+// Green threads: tasks interleaved by one VM on its own thread. Each task owns a `Stack`;
+// switching tasks swaps the VM's stack with the next task's. `try_eval` runs the evaluation it
+// was given as the main task and switches after a task has made `fuel` steps, calls `yield`,
+// waits in `join` or is done. Tasks only run while the VM evaluates something: `try_eval`
+// returns as soon as the main task is done, other tasks resume with the next evaluation.
+// A task can also be suspended until another thread wakes it up, see `tasks_suspend`.
+
+struct VirtualMachine;
+
+typedef struct {
+    // `try_step` calls a task makes before the next ready task runs, 1000 if 0.
+    size_t fuel;
+    // The stack of each spawned task, the VM's own stack config if its size is 0.
+    Stack_Config stack_config;
+} Tasks_Config;
+
+// What a task is suspended on, when it may never happen: a channel, for instance, that no other
+// VM holds. If every task is waiting and none of those suspended can be woken up, the VM is
+// deadlocked.
+typedef struct {
+    // Whether anything but the VM's own tasks may still wake the task up.
+    bool (*can_wake)(void *context);
+    // Stops waiting, without waking the task up.
+    void (*cancel)(void *context);
+} Tasks_Wait;
+
+typedef enum {
+    TASK_READY,
+    TASK_WAITING,
+    TASK_DONE,
+    TASK_FAILED,
+} Task_State;
+
+typedef struct Task Task;
+typedef struct Tasks Tasks;
+
+struct Task {
+    // Empty while the task runs: its frames are in the VM's stack then.
+    Stack stack;
+    // The results list of the outermost frame while running, then the value it returned.
+    Object *value;
+    Object *error;
+    Task_State state;
+    // The handle was collected: nobody can join the task, it is freed when done.
+    bool is_detached;
+    Tasks *owner;
+    size_t index;
+    // Tasks are numbered in the order they are spawned, from 1: the main task is 0.
+    size_t id;
+    // Links the task into the ready queue, or into the waiters of the task it joins.
+    Task *next;
+    Task *waiters;
+    Task *joining;
+    // Passed by `tasks_wake` to the suspended task.
+    void *wakeup;
+    // What the task is suspended on, until it is woken up; null if it always ends.
+    Tasks_Wait const *wait;
+    void *wait_context;
+};
+
+typedef struct {
+    Task **data;
+    size_t count;
+    size_t capacity;
+} Tasks_List;
+
+struct Tasks {
+    // Marked by the collector: the frames, values and errors of suspended tasks.
+    Task main;
+    Tasks_List spawned;
+
+    Tasks_Config _config;
+    Task *_running;
+    Task *_ready_head;
+    Task *_ready_tail;
+    size_t _fuel;
+    size_t _last_id;
+    bool _yielded;
+    bool _deadlocked;
+
+    // Suspended tasks, and those of them other threads woke up.
+    size_t _suspended;
+    pthread_mutex_t _lock;
+    pthread_cond_t _has_woken;
+    Task *_woken;
+};
+
+void tasks_init(Tasks *t, Tasks_Config config, Stack_Config vm_stack_config);
+
+// Frees every spawned task; the main one must be running.
+void tasks_free(Tasks *t);
+
+// Stops the suspended tasks from waiting, before what they wait on is freed with the heap; the
+// main one must be running.
+void tasks_cancel_waits(Tasks *t);
+
+bool tasks_is_main_running(Tasks const *t);
+
+size_t tasks_running_id(Tasks const *t);
+
+// Called after every step: true if the running task should give way to another.
+bool tasks_should_switch(Tasks *t);
+
+// The running task is waiting in `join`: the call is made again when the task resumes.
+bool tasks_is_blocked(Tasks const *t);
+
+// Resumes the next ready task, if any, or the running one.
+void tasks_switch(struct VirtualMachine *vm);
+
+// The running task's stack is empty: records its value (or the VM's error, if it failed),
+// wakes up the tasks joining it and resumes the next one.
+void tasks_finish(struct VirtualMachine *vm, bool is_error);
+
+// Starts calling `fn` with `args` in a new task and returns a task handle.
+[[nodiscard]]
+bool tasks_try_spawn(struct VirtualMachine *vm, Object *fn, Object *args, Object **task);
+
+void tasks_yield(struct VirtualMachine *vm);
+
+// Returns the value of `task` or rethrows its error; blocks the running task until it is done.
+[[nodiscard]]
+bool tasks_try_join(struct VirtualMachine *vm, Object *task, Object **value);
+
+// Blocks the running task, as `join` does, until `tasks_wake` is called with the returned task.
+// Meanwhile other tasks run, or the VM waits if none can. `wait` is null if the task is certain
+// to be woken up, as when a thread works for it.
+Task *tasks_suspend(struct VirtualMachine *vm, Tasks_Wait const *wait, void *context);
+
+// Wakes up a task returned by `tasks_suspend`; safe to call from any thread.
+void tasks_wake(Tasks *t, Task *task, void *wakeup);
+
+// Takes what the running task was woken up with, if it was.
+bool tasks_try_take_wakeup(Tasks *t, void **wakeup);
+
+// Whether the running task was resumed because every task was waiting: the call it waited in
+// must fail rather than wait again.
+bool tasks_take_deadlock(Tasks *t);
@@ -0,0 +1,54 @@
+#include "trace.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "utility/guards.h"
+
+#define TRACE_DEFAULT_CAPACITY 65536
+
+static_assert(16 == sizeof(Trace_Record));
+
+static uint64_t clock_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+bool trace_try_init(Trace *t, Trace_Config config, errno_t *error_code) {
+    guard_is_not_null(t);
+    guard_is_not_null(error_code);
+
+    size_t capacity = 1;
+    while (capacity < (0 == config.capacity ? TRACE_DEFAULT_CAPACITY : config.capacity)) {
+        capacity *= 2;
+    }
+
+    errno = 0;
+    auto const records = (Trace_Record *) calloc(capacity, sizeof(Trace_Record));
+    if (nullptr == records) {
+        *error_code = errno;
+        return false;
+    }
+
+    *t = (Trace) {._records = records, ._capacity = capacity, ._start_ns = clock_ns()};
+    return true;
+}
+
+void trace_free(Trace *t) {
+    guard_is_not_null(t);
+
+    free(t->_records);
+    *t = (Trace) {0};
+}
+
+void trace_record(Trace *t, Trace_Kind kind, size_t task, uint32_t arg) {
+    auto const count = atomic_load_explicit(&t->_count, memory_order_relaxed);
+    t->_records[count & (t->_capacity - 1)] = (Trace_Record) {
+            .time_ns = clock_ns() - t->_start_ns,
+            .arg = arg,
+            .task = (uint16_t) (task == TRACE_NO_TASK ? task : task % TRACE_NO_TASK),
+            .kind = (uint8_t) kind
+    };
+    atomic_store_explicit(&t->_count, count + 1, memory_order_release);
+}
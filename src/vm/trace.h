@@ -0,0 +1,76 @@
+#pragma once
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Records what a VM does as it evaluates: frames pushed and popped, primitive calls,
+// collections and errors. Records are 16 bytes, written to a ring that keeps the most recent
+// ones; the VM is the only writer, so recording takes no lock. `trace_try_dump` writes the
+// ring in a binary format, which `persimmon-trace-json` converts to Chrome trace JSON.
+//
+// Each VM needs a trace of its own. When a VM is not tracing, recording costs the check of a
+// null pointer.
+//
+// The dump is in the byte order of the machine that wrote it:
+//   - `TRACE_MAGIC`, then `uint32_t` record size, frame type count, primitive count, 0;
+//   - `uint64_t` records dumped and records overwritten before the dump;
+//   - the names of the frame types then of the primitives, each a `uint32_t` length and as
+//     many bytes;
+//   - the records, oldest first.
+
+#define TRACE_MAGIC "PMTRACE1"
+
+// The task of the records that are not a task's, such as collections.
+#define TRACE_NO_TASK UINT16_MAX
+
+typedef enum {
+    // `arg` is the type of the frame, a `Stack_FrameType`.
+    TRACE_FRAME_PUSH,
+    TRACE_FRAME_POP,
+    // `arg` is the index of the primitive, see `primitive_try_get_index`.
+    TRACE_PRIMITIVE_BEGIN,
+    TRACE_PRIMITIVE_END,
+    TRACE_GC_BEGIN,
+    // `arg` is the number of objects freed.
+    TRACE_GC_END,
+    TRACE_ERROR
+} Trace_Kind;
+
+typedef struct {
+    // Since the trace was made.
+    uint64_t time_ns;
+    uint32_t arg;
+    // The task that was running, 0 for the main task (see `tasks_running_id`), truncated.
+    uint16_t task;
+    // A `Trace_Kind`.
+    uint8_t kind;
+    uint8_t _reserved;
+} Trace_Record;
+
+typedef struct {
+    // Records kept, the most recent ones; rounded up to a power of two, 65536 if 0.
+    size_t capacity;
+} Trace_Config;
+
+typedef struct Trace Trace;
+struct Trace {
+    Trace_Record *_records;
+    size_t _capacity;
+    // Records written so far, the last `_capacity` of which are in the ring.
+    atomic_size_t _count;
+    uint64_t _start_ns;
+};
+
+[[nodiscard]]
+bool trace_try_init(Trace *t, Trace_Config config, errno_t *error_code);
+
+void trace_free(Trace *t);
+
+void trace_record(Trace *t, Trace_Kind kind, size_t task, uint32_t arg);
+
+// Writes the records kept; the VM may still be recording, in which case the oldest records
+// may be torn.
+[[nodiscard]]
+bool trace_try_dump(Trace *t, FILE *file, errno_t *error_code);
@@ -0,0 +1,50 @@
+// Kept apart from trace.c, which the allocator needs without the primitives named here.
+#include "trace.h"
+
+#include <string.h>
+
+#include "utility/guards.h"
+#include "stack.h"
+#include "primitives.h"
+
+static bool try_write_name(FILE *file, char const *name) {
+    auto const length = (uint32_t) strlen(name);
+    return 1 == fwrite(&length, sizeof(length), 1, file) && length == fwrite(name, 1, length, file);
+}
+
+bool trace_try_dump(Trace *t, FILE *file, errno_t *error_code) {
+    guard_is_not_null(t);
+    guard_is_not_null(file);
+    guard_is_not_null(error_code);
+
+    auto const count = (uint64_t) atomic_load_explicit(&t->_count, memory_order_acquire);
+    auto const dumped = count < t->_capacity ? count : (uint64_t) t->_capacity;
+    auto const overwritten = count - dumped;
+    uint32_t const header[] = {sizeof(Trace_Record), FRAME_OR + 1, (uint32_t) primitives_count(), 0};
+
+    errno = 0;
+    auto ok = strlen(TRACE_MAGIC) == fwrite(TRACE_MAGIC, 1, strlen(TRACE_MAGIC), file)
+              && 1 == fwrite(header, sizeof(header), 1, file)
+              && 1 == fwrite(&dumped, sizeof(dumped), 1, file)
+              && 1 == fwrite(&overwritten, sizeof(overwritten), 1, file);
+    for (size_t type = 0; ok && type <= FRAME_OR; type++) {
+        ok = try_write_name(file, frame_type_str((Stack_FrameType) type));
+    }
+    for (size_t index = 0; ok && index < primitives_count(); index++) {
+        ok = try_write_name(file, primitive_name(index));
+    }
+
+    // Oldest first: the ring wraps around at the record after the newest.
+    auto const start = (size_t) (count - dumped) & (t->_capacity - 1);
+    auto const first_part = dumped < t->_capacity - start ? dumped : t->_capacity - start;
+    ok = ok
+         && first_part == fwrite(t->_records + start, sizeof(Trace_Record), first_part, file)
+         && dumped - first_part == fwrite(t->_records, sizeof(Trace_Record), dumped - first_part, file);
+
+    if (false == ok) {
+        *error_code = 0 == errno ? EIO : errno;
+        return false;
+    }
+
+    return true;
+}
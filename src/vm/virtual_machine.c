@@ -1,28 +1,38 @@
 #include "virtual_machine.h"
 
 #include "utility/guards.h"
+#include "utility/exchange.h"
 #include "object/constructors.h"
 #include "reader/reader.h"
 #include "env.h"
 #include "stack.h"
 #include "constants.h"
 #include "primitives.h"
+#include "prelude.h"
+#include "workers.h"
+#include "files.h"
 
 bool vm_try_init(VirtualMachine *vm, VirtualMachine_Config config) {
     *vm = (VirtualMachine) {
             .allocator = allocator_make(config.allocator_config),
+            .output = nullptr == config.output ? stdout : config.output,
+            .config = config,
             .globals = OBJECT_NIL,
             .value = OBJECT_NIL,
             .error = OBJECT_NIL,
             .exprs = OBJECT_NIL,
+            .module_forms = OBJECT_NIL,
     };
+    tasks_init(&vm->tasks, config.tasks_config, config.stack_config);
 
     allocator_set_roots(&vm->allocator, (ObjectAllocator_Roots) {
             .stack = &vm->stack,
+            .tasks = &vm->tasks,
             .globals = &vm->globals,
             .value = &vm->value,
             .error = &vm->error,
             .exprs = &vm->exprs,
+            .module_forms = &vm->module_forms,
     });
 
     errno_t error_code;
@@ -30,7 +40,8 @@ bool vm_try_init(VirtualMachine *vm, VirtualMachine_Config config) {
            && object_reader_try_init(&vm->reader, vm, config.reader_config, &error_code)
            && env_try_create(&vm->allocator, OBJECT_NIL, &vm->globals)
            && try_define_constants(&vm->allocator, vm->globals)
-           && try_define_primitives(&vm->allocator, vm->globals);
+           && try_define_primitives(&vm->allocator, vm->globals)
+           && try_define_prelude(vm);
     if (false == ok) {
         vm_free(vm);
     }
@@ -41,13 +52,33 @@ bool vm_try_init(VirtualMachine *vm, VirtualMachine_Config config) {
 void vm_free(VirtualMachine *vm) {
     guard_is_not_null(vm);
 
+    // Before the heap: futures are released with it.
+    workers_free(vm->workers);
+    // Before the tasks: the pool wakes them up.
+    files_free(vm->files);
+    // Before the heap: channels are released with it.
+    tasks_cancel_waits(&vm->tasks);
     object_reader_free(&vm->reader);
+    modules_free(&vm->modules);
     allocator_free(&vm->allocator);
+    // After the heap: task handles are released with it.
+    tasks_free(&vm->tasks);
+    image_free(&vm->image);
     stack_free(&vm->stack);
 
     *vm = (VirtualMachine) {0};
 }
 
+void vm_stop_threads(VirtualMachine *vm) {
+    guard_is_not_null(vm);
+
+    // Its calls are all made first; futures keep their results.
+    workers_free(exchange(vm->workers, nullptr));
+    // Its jobs are all done; their tasks collect them from the pool.
+    files_stop(vm->files);
+    allocator_stop_sweeper(&vm->allocator);
+}
+
 ObjectAllocator *vm_allocator(VirtualMachine *vm) {
     guard_is_not_null(vm);
 
@@ -1,30 +1,67 @@
 #pragma once
 
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "object/allocator.h"
 #include "reader/reader.h"
 #include "stack.h"
+#include "modules.h"
+#include "image.h"
+#include "tasks.h"
+
+// A VM owns all of its state, objects shared between VMs are immortal (see `OBJECT_IMMORTAL`):
+// any number of VMs can run concurrently as long as each one is used by one thread at a time.
 
 typedef struct VirtualMachine VirtualMachine;
 
+typedef struct {
+    ObjectAllocator_Config allocator_config;
+    Reader_Config reader_config;
+    Stack_Config stack_config;
+    Tasks_Config tasks_config;
+    // Where `print` writes, `stdout` if null.
+    FILE *output;
+    // Threads running `pmap` and `future` calls, one per CPU if 0.
+    size_t workers;
+    // Threads reading and writing files for `read-file`, `read-lines` and `write-file`, 4 if 0.
+    size_t file_threads;
+    // Takes samples of the stack while evaluating, see `profiler.h`; null unless profiling.
+    struct Profiler *profiler;
+    // Records frames, primitive calls and errors, see `trace.h`; null unless tracing. Give the
+    // same trace to the allocator to record collections as well.
+    struct Trace *trace;
+} VirtualMachine_Config;
+
+struct Workers;
+struct Files;
+
 struct VirtualMachine {
+    // The stack of the running task, see `tasks.h`.
     Stack stack;
+    Tasks tasks;
     ObjectReader reader;
     ObjectAllocator allocator;
+    Modules modules;
+    Image image;
+    FILE *output;
+    VirtualMachine_Config config;
+    // Started by the first `pmap` or `future`.
+    struct Workers *workers;
+    // Started by the first `read-file`, `read-lines` or `write-file`.
+    struct Files *files;
 
     Object *globals;
     Object *value;
     Object *error;
     Object *exprs;
+    Object *module_forms;
 };
 
-typedef struct {
-    ObjectAllocator_Config allocator_config;
-    Reader_Config reader_config;
-    Stack_Config stack_config;
-} VirtualMachine_Config;
-
 bool vm_try_init(VirtualMachine *vm, VirtualMachine_Config config);
 
 void vm_free(VirtualMachine *vm);
+
+// Stops the threads `vm` started, which it starts again when it needs them: a process forked from
+// it would have their state but none of them.
+void vm_stop_threads(VirtualMachine *vm);
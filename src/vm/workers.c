@@ -0,0 +1,628 @@
+#include "workers.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "utility/guards.h"
+#include "utility/dynamic_array.h"
+#include "utility/math.h"
+#include "utility/slice.h"
+#include "object/constructors.h"
+#include "object/list.h"
+#include "object/transfer.h"
+#include "virtual_machine.h"
+#include "env.h"
+#include "eval.h"
+#include "errors.h"
+#include "variadic.h"
+
+static auto const SYMBOL_QUOTE = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = "quote"};
+static auto const SYMBOL_AMPERSAND = &(Object) {.color = OBJECT_IMMORTAL, .type = TYPE_SYMBOL, .as_symbol = VARIADIC_AMPERSAND};
+
+typedef struct {
+    Transfer_Message message;
+    Transfer_Ref value;
+    // Whether `value` is an error thrown by the call.
+    bool is_error;
+    // Set if the call could not be made or its result could not be packed.
+    errno_t error_code;
+} Workers_Result;
+
+// A global of the VM that submitted a batch, which the batch may look up.
+typedef struct {
+    Transfer_Ref name;
+    Transfer_Ref value;
+} Workers_Binding;
+
+typedef struct {
+    Workers_Binding *data;
+    size_t count;
+    size_t capacity;
+} Workers_Bindings;
+
+// Calls of one `pmap` or `future`. Threads claim calls in chunks until none are left;
+// the batch is freed once its owner and every queue entry referring to it are done with it.
+typedef struct {
+    Transfer_Message request;
+    // The globals of the submitter, left out of the request but for the bindings it looks up.
+    Transfer_Ref globals;
+    Workers_Bindings bindings;
+    Transfer_Ref fn;
+    Transfer_Ref *args;
+    // Whether `args` are argument lists rather than single arguments.
+    bool spreads_args;
+    size_t calls;
+    size_t threads;
+    Workers_Result *results;
+
+    atomic_size_t next_call;
+    atomic_size_t references;
+
+    pthread_mutex_t lock;
+    pthread_cond_t is_done;
+    size_t completed;
+} Workers_Batch;
+
+typedef struct {
+    Workers_Batch **data;
+    size_t count;
+    size_t capacity;
+    size_t head;
+} Workers_Queue;
+
+typedef struct {
+    pthread_t thread;
+    VirtualMachine vm;
+    Workers *pool;
+} Workers_Thread;
+
+struct Workers {
+    pthread_mutex_t lock;
+    pthread_cond_t has_work;
+    Workers_Queue queue;
+    bool is_stopping;
+
+    Workers_Thread *threads;
+    size_t count;
+};
+
+static bool batch_try_create(size_t calls, size_t threads, bool spreads_args, Workers_Batch **batch) {
+    auto const b = (Workers_Batch *) calloc(1, sizeof(Workers_Batch));
+    if (nullptr == b) {
+        return false;
+    }
+
+    b->args = calloc(calls, sizeof(Transfer_Ref));
+    b->results = calloc(calls, sizeof(Workers_Result));
+    if (nullptr == b->args || nullptr == b->results) {
+        free(b->args);
+        free(b->results);
+        free(b);
+        return false;
+    }
+
+    b->spreads_args = spreads_args;
+    b->calls = calls;
+    b->threads = threads;
+    atomic_init(&b->next_call, 0);
+    atomic_init(&b->references, 1);
+    pthread_mutex_init(&b->lock, nullptr);
+    pthread_cond_init(&b->is_done, nullptr);
+
+    *batch = b;
+    return true;
+}
+
+static void batch_retain(Workers_Batch *b) {
+    atomic_fetch_add(&b->references, 1);
+}
+
+static void batch_release(Workers_Batch *b) {
+    if (1 != atomic_fetch_sub(&b->references, 1)) {
+        return;
+    }
+
+    for (size_t i = 0; i < b->calls; i++) {
+        transfer_message_free(&b->results[i].message);
+    }
+    transfer_message_free(&b->request);
+    da_free(&b->bindings);
+    pthread_cond_destroy(&b->is_done);
+    pthread_mutex_destroy(&b->lock);
+    free(b->results);
+    free(b->args);
+    free(b);
+}
+
+// Guided scheduling: chunks shrink as calls run out, so that threads finish together
+// even if some calls take much longer than others.
+static bool batch_try_claim(Workers_Batch *b, size_t *begin, size_t *end) {
+    auto next = atomic_load(&b->next_call);
+    while (next < b->calls) {
+        auto const size = max((b->calls - next) / (2 * b->threads), (size_t) 1);
+        if (atomic_compare_exchange_weak(&b->next_call, &next, next + size)) {
+            *begin = next;
+            *end = next + size;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void batch_complete(Workers_Batch *b, size_t calls) {
+    pthread_mutex_lock(&b->lock);
+    b->completed += calls;
+    if (b->completed == b->calls) {
+        pthread_cond_broadcast(&b->is_done);
+    }
+    pthread_mutex_unlock(&b->lock);
+}
+
+static void batch_wait(Workers_Batch *b) {
+    pthread_mutex_lock(&b->lock);
+    while (b->completed < b->calls) {
+        pthread_cond_wait(&b->is_done, &b->lock);
+    }
+    pthread_mutex_unlock(&b->lock);
+}
+
+static void release_future(void *data) {
+    batch_release(data);
+}
+
+static void retain_future(void *data) {
+    batch_retain(data);
+}
+
+// Futures can be passed to other VMs: any of them can wait for the result.
+static Object_HandleClass const FUTURE_CLASS = {.name = "future", .release = release_future, .retain = retain_future};
+
+// Appends `first` to the list ending at `*tail`: `*cell` is the new cell, `*tail` its rest.
+static bool try_append(ObjectAllocator *a, Object ***tail, Object *first, Object **cell) {
+    if (false == object_try_make_list(a, first, OBJECT_NIL, *tail)) {
+        return false;
+    }
+
+    *cell = **tail;
+    *tail = &(*cell)->as_list.rest;
+    return true;
+}
+
+// Builds `(fn (quote arg))` or `(fn & (quote args))` in the rest of `vm->exprs`, which holds
+// the globals of the batch, the unpacked function and the call being made, replacing the one before.
+static bool try_make_call(VirtualMachine *vm, Workers_Batch const *b, Transfer_Unpacker *u, size_t call, Object **expr, errno_t *error_code) {
+    auto const a = &vm->allocator;
+    auto const fn = vm->exprs->as_list.rest;
+    auto const kept = &fn->as_list.rest;
+    if (false == object_try_make_list(a, OBJECT_NIL, OBJECT_NIL, kept)) {
+        *error_code = ENOMEM;
+        return false;
+    }
+
+    auto const slot = &(*kept)->as_list.first;
+    auto tail = slot;
+    Object *cell;
+    auto const ok = try_append(a, &tail, fn->as_list.first, &cell)
+                    && (false == b->spreads_args || try_append(a, &tail, SYMBOL_AMPERSAND, &cell))
+                    && try_append(a, &tail, OBJECT_NIL, &cell);
+    if (false == ok) {
+        *error_code = ENOMEM;
+        return false;
+    }
+
+    auto quoted = &cell->as_list.first;
+    Object *arg;
+    if (false == try_append(a, &quoted, SYMBOL_QUOTE, &arg) || false == try_append(a, &quoted, OBJECT_NIL, &arg)) {
+        *error_code = ENOMEM;
+        return false;
+    }
+
+    if (false == transfer_try_unpack(u, a, b->args[call], &arg->as_list.first, error_code)) {
+        return false;
+    }
+
+    *expr = *slot;
+    return true;
+}
+
+// Only the objects of the function outlive the call: those of its arguments are forgotten.
+static Workers_Result run_call(VirtualMachine *vm, Workers_Batch const *b, Transfer_Unpacker *u, size_t fn_objects, size_t call) {
+    auto result = (Workers_Result) {0};
+
+    Object *expr;
+    if (false == try_make_call(vm, b, u, call, &expr, &result.error_code)) {
+        transfer_unpacker_forget(u, fn_objects);
+        return result;
+    }
+
+    result.is_error = false == try_eval(vm, vm->globals, expr);
+    auto const value = result.is_error ? vm->error : vm->value;
+    if (false == transfer_try_pack(&result.message, value, &result.value, &result.error_code)) {
+        transfer_message_free(&result.message);
+    }
+    transfer_unpacker_forget(u, fn_objects);
+
+    return result;
+}
+
+// Defines the bindings of the batch in a scope of their own, the first of `vm->exprs`, which stands
+// for the globals of the submitter: other names are looked up in those of `vm`.
+static bool try_unpack_globals(VirtualMachine *vm, Workers_Batch const *b, Transfer_Unpacker *u, errno_t *error_code) {
+    auto const a = &vm->allocator;
+    auto const env = &vm->exprs->as_list.first;
+    // Holds the name and the value being defined.
+    auto const binding = &vm->exprs->as_list.rest;
+    auto const ok = env_try_create(a, vm->globals, env)
+                    && object_try_make_list(a, OBJECT_NIL, OBJECT_NIL, binding)
+                    && object_try_make_list(a, OBJECT_NIL, OBJECT_NIL, &(*binding)->as_list.rest);
+    if (false == ok) {
+        *error_code = ENOMEM;
+        return false;
+    }
+    transfer_unpacker_provide(u, b->globals, *env);
+
+    auto const name = &(*binding)->as_list.first;
+    auto const value = &(*binding)->as_list.rest->as_list.first;
+    slice_for_v(it, b->bindings) {
+        if (false == transfer_try_unpack(u, a, it->name, name, error_code)
+            || false == transfer_try_unpack(u, a, it->value, value, error_code)) {
+            return false;
+        }
+
+        if (false == env_try_define(a, *env, *name, *value)) {
+            *error_code = ENOMEM;
+            return false;
+        }
+    }
+
+    *binding = OBJECT_NIL;
+    return true;
+}
+
+static void run_batch(VirtualMachine *vm, Workers_Batch *b) {
+    auto const a = &vm->allocator;
+    Transfer_Unpacker u;
+    errno_t error_code = 0;
+
+    auto ok = transfer_unpacker_try_init(&u, &b->request, &error_code);
+    if (ok && false == object_try_make_list(a, OBJECT_NIL, OBJECT_NIL, &vm->exprs)) {
+        error_code = ENOMEM;
+        ok = false;
+    }
+    ok = ok && try_unpack_globals(vm, b, &u, &error_code);
+    if (ok && false == object_try_make_list(a, OBJECT_NIL, OBJECT_NIL, &vm->exprs->as_list.rest)) {
+        error_code = ENOMEM;
+        ok = false;
+    }
+    ok = ok && transfer_try_unpack(&u, a, b->fn, &vm->exprs->as_list.rest->as_list.first, &error_code);
+    auto const fn_objects = transfer_unpacker_checkpoint(&u);
+
+    size_t begin, end;
+    while (batch_try_claim(b, &begin, &end)) {
+        for (auto i = begin; i < end; i++) {
+            b->results[i] = ok ? run_call(vm, b, &u, fn_objects, i) : (Workers_Result) {.error_code = error_code};
+        }
+        batch_complete(b, end - begin);
+    }
+
+    vm->exprs = OBJECT_NIL;
+    vm->value = OBJECT_NIL;
+    vm->error = OBJECT_NIL;
+    transfer_unpacker_free(&u);
+}
+
+static void *run_thread(void *arg) {
+    auto const thread = (Workers_Thread *) arg;
+    auto const pool = thread->pool;
+
+    while (true) {
+        pthread_mutex_lock(&pool->lock);
+        while (slice_empty(pool->queue) && false == pool->is_stopping) {
+            pthread_cond_wait(&pool->has_work, &pool->lock);
+        }
+
+        // The queue is drained before stopping: every batch gets all of its calls made.
+        Workers_Batch *b = nullptr;
+        if (false == slice_empty(pool->queue)) {
+            b = pool->queue.data[pool->queue.head++];
+            if (pool->queue.head == pool->queue.count) {
+                pool->queue.head = pool->queue.count = 0;
+            }
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        if (nullptr == b) {
+            return nullptr;
+        }
+
+        run_batch(&thread->vm, b);
+        batch_release(b);
+    }
+}
+
+// Queues up to `entries` references to `b`, one per thread that may help with it;
+// a single one is enough for all calls to be made.
+static bool try_enqueue(Workers *pool, Workers_Batch *b, size_t entries) {
+    size_t queued = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (; queued < entries; queued++) {
+        if (false == da_try_append(&pool->queue, b)) {
+            break;
+        }
+        batch_retain(b);
+    }
+    pthread_cond_broadcast(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    return queued > 0;
+}
+
+static bool try_start(VirtualMachine *vm, Workers **workers) {
+    if (nullptr != vm->workers) {
+        *workers = vm->workers;
+        return true;
+    }
+
+    auto count = vm->config.workers;
+    if (0 == count) {
+        auto const cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        count = cpus > 0 ? (size_t) cpus : 1;
+    }
+
+    auto const pool = (Workers *) calloc(1, sizeof(Workers));
+    auto const threads = (Workers_Thread *) calloc(count, sizeof(Workers_Thread));
+    if (nullptr == pool || nullptr == threads) {
+        free(threads);
+        free(pool);
+        out_of_memory_error(vm);
+    }
+
+    pthread_mutex_init(&pool->lock, nullptr);
+    pthread_cond_init(&pool->has_work, nullptr);
+    pool->threads = threads;
+
+    // Calls made by the pool's VMs evaluate `pmap` and `future` on a single thread.
+    auto config = vm->config;
+    config.output = vm->output;
+    config.workers = 1;
+    // Samples the thread it was started for only: the pool's threads would race on it.
+    config.profiler = nullptr;
+    // A trace has a single writer; the pool's VMs are not traced.
+    config.trace = nullptr;
+    config.allocator_config.trace = nullptr;
+    // Nor are their collections: each would close the JSON array of the file.
+    config.allocator_config.trace_events = nullptr;
+
+    for (size_t i = 0; i < count; i++) {
+        threads[i].pool = pool;
+        if (false == vm_try_init(&threads[i].vm, config)) {
+            workers_free(pool);
+            out_of_memory_error(vm);
+        }
+
+        errno_t const error_code = pthread_create(&threads[i].thread, nullptr, run_thread, &threads[i]);
+        if (0 != error_code) {
+            vm_free(&threads[i].vm);
+            workers_free(pool);
+            os_error(vm, error_code);
+        }
+
+        pool->count = i + 1;
+    }
+
+    *workers = vm->workers = pool;
+    return true;
+}
+
+void workers_free(Workers *workers) {
+    if (nullptr == workers) {
+        return;
+    }
+
+    pthread_mutex_lock(&workers->lock);
+    workers->is_stopping = true;
+    pthread_cond_broadcast(&workers->has_work);
+    pthread_mutex_unlock(&workers->lock);
+
+    for (size_t i = 0; i < workers->count; i++) {
+        pthread_join(workers->threads[i].thread, nullptr);
+        vm_free(&workers->threads[i].vm);
+    }
+
+    da_free(&workers->queue);
+    pthread_cond_destroy(&workers->has_work);
+    pthread_mutex_destroy(&workers->lock);
+    free(workers->threads);
+    free(workers);
+}
+
+static bool try_pack_args(Workers_Batch *b, Object *args, errno_t *error_code) {
+    if (b->spreads_args) {
+        return transfer_try_pack(&b->request, args, &b->args[0], error_code);
+    }
+
+    size_t i = 0;
+    for (auto it = args; OBJECT_NIL != it; it = it->as_list.rest, i++) {
+        if (false == transfer_try_pack(&b->request, it->as_list.first, &b->args[i], error_code)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool is_bound(Workers_Batch const *b, char const *name) {
+    slice_for_v(it, b->bindings) {
+        auto const entry = &b->request.data[transfer_ref_index(it->name)];
+        if (0 == strcmp(name, transfer_entry_chars(&b->request, entry))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Packs the globals named by the symbols of the request, which in turn packs those named by the
+// symbols of their values: the calls can not look up others but by making symbols.
+static bool try_pack_globals(VirtualMachine *vm, Workers_Batch *b, errno_t *error_code) {
+    auto const m = &b->request;
+    for (size_t i = 0; i < m->count; i++) {
+        if (TYPE_SYMBOL != m->data[i].type) {
+            continue;
+        }
+
+        auto name = (Object) {.type = TYPE_SYMBOL, .as_symbol = transfer_entry_chars(m, &m->data[i])};
+        Object *value;
+        if (false == env_try_find(vm->globals, &name, &value) || is_bound(b, name.as_symbol)) {
+            continue;
+        }
+
+        auto binding = (Workers_Binding) {.name = transfer_entry_ref(i)};
+        if (false == transfer_try_pack(m, value, &binding.value, error_code)) {
+            return false;
+        }
+        if (false == da_try_append(&b->bindings, binding)) {
+            *error_code = ENOMEM;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Copies the function and the arguments but the globals they refer to: copying all of them would
+// cost as much as the heap, and fail for a task anywhere in it.
+static bool try_pack_request(VirtualMachine *vm, Workers_Batch *b, Object *fn, Object *args) {
+    errno_t error_code;
+    auto const ok = transfer_try_refer(&b->request, vm->globals, &b->globals, &error_code)
+                    && transfer_try_pack(&b->request, fn, &b->fn, &error_code)
+                    && try_pack_args(b, args, &error_code)
+                    && try_pack_globals(vm, b, &error_code);
+    if (false == ok) {
+        transfer_error(vm, error_code);
+    }
+
+    return true;
+}
+
+// Rebuilds a result in `*value`, or in `vm->error` if the call threw.
+static bool try_collect(VirtualMachine *vm, Workers_Result const *result, Object **value) {
+    if (0 != result->error_code) {
+        transfer_error(vm, result->error_code);
+    }
+
+    Transfer_Unpacker u;
+    errno_t error_code;
+    if (false == transfer_unpacker_try_init(&u, &result->message, &error_code)) {
+        transfer_error(vm, error_code);
+    }
+
+    auto const slot = result->is_error ? &vm->error : value;
+    auto const ok = transfer_try_unpack(&u, &vm->allocator, result->value, slot, &error_code);
+    transfer_unpacker_free(&u);
+    if (false == ok) {
+        transfer_error(vm, error_code);
+    }
+
+    return false == result->is_error;
+}
+
+static bool try_submit(VirtualMachine *vm, Object *fn, Object *args, size_t calls, bool spreads_args, Workers_Batch **batch) {
+    Workers *pool;
+    if (false == try_start(vm, &pool)) {
+        return false;
+    }
+
+    Workers_Batch *b;
+    if (false == batch_try_create(calls, pool->count, spreads_args, &b)) {
+        out_of_memory_error(vm);
+    }
+
+    if (false == try_pack_request(vm, b, fn, args)) {
+        batch_release(b);
+        return false;
+    }
+
+    if (false == try_enqueue(pool, b, min(pool->count, calls))) {
+        batch_release(b);
+        out_of_memory_error(vm);
+    }
+
+    *batch = b;
+    return true;
+}
+
+bool workers_try_map(VirtualMachine *vm, Object *fn, Object *list, Object **results) {
+    guard_is_not_null(vm);
+    guard_is_not_null(fn);
+    guard_is_not_null(list);
+    guard_is_not_null(results);
+
+    *results = OBJECT_NIL;
+
+    auto const calls = object_list_count(list);
+    if (0 == calls) {
+        return true;
+    }
+
+    Workers_Batch *b;
+    if (false == try_submit(vm, fn, list, calls, false, &b)) {
+        return false;
+    }
+    batch_wait(b);
+
+    auto ok = true;
+    auto tail = results;
+    for (size_t i = 0; i < calls && ok; i++) {
+        Object *cell;
+        if (false == try_append(&vm->allocator, &tail, OBJECT_NIL, &cell)) {
+            batch_release(b);
+            out_of_memory_error(vm);
+        }
+
+        ok = try_collect(vm, &b->results[i], &cell->as_list.first);
+    }
+
+    batch_release(b);
+    return ok;
+}
+
+bool workers_try_submit(VirtualMachine *vm, Object *fn, Object *args, Object **future) {
+    guard_is_not_null(vm);
+    guard_is_not_null(fn);
+    guard_is_not_null(args);
+    guard_is_not_null(future);
+
+    Workers_Batch *b;
+    if (false == try_submit(vm, fn, args, 1, true, &b)) {
+        return false;
+    }
+
+    // The queued references keep the call going even if the handle can not be made.
+    if (false == object_try_make_handle(&vm->allocator, &FUTURE_CLASS, b, future)) {
+        batch_release(b);
+        out_of_memory_error(vm);
+    }
+
+    return true;
+}
+
+bool workers_try_deref(VirtualMachine *vm, Object *future, Object **value) {
+    guard_is_not_null(vm);
+    guard_is_not_null(future);
+    guard_is_not_null(value);
+
+    if (TYPE_HANDLE != future->type || &FUTURE_CLASS != future->as_handle.class) {
+        type_error(vm, future->type, TYPE_HANDLE);
+    }
+
+    Workers_Batch *b = future->as_handle.data;
+    batch_wait(b);
+
+    return try_collect(vm, &b->results[0], value);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "object/object.h"
+
+// A pool of threads, each evaluating calls in a VM of its own. Functions, arguments and
+// results are moved between VMs as messages (see `object/transfer.h`), so the pool's VMs never
+// see the owner's heap. Errors thrown by a call are rethrown by whoever collects its result.
+
+struct VirtualMachine;
+
+typedef struct Workers Workers;
+
+// Calls `fn` with each element of `list` on the pool of `vm` and collects the results in order.
+[[nodiscard]]
+bool workers_try_map(struct VirtualMachine *vm, Object *fn, Object *list, Object **results);
+
+// Starts calling `fn` with `args` on the pool of `vm` and returns a future handle for the result.
+[[nodiscard]]
+bool workers_try_submit(struct VirtualMachine *vm, Object *fn, Object *args, Object **future);
+
+// Waits for the result of `future`.
+[[nodiscard]]
+bool workers_try_deref(struct VirtualMachine *vm, Object *future, Object **value);
+
+// Finishes all submitted calls and stops the pool; accepts null.
+void workers_free(Workers *workers);
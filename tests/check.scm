@@ -0,0 +1,3 @@
+; Throws `what` unless `ok`: a test fails by exiting with an error.
+(defn check (what ok)
+  (if ok nil (throw what)))
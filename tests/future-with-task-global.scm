@@ -0,0 +1,10 @@
+; A task anywhere in the globals is not moved to the pool unless the function refers to it.
+(import "tests/check.scm")
+
+(defn dbl (x) (* x 2))
+(define task (spawn (fn () 1)))
+(check "future leaves the task out" (eq? (deref (future dbl 4)) 8))
+
+(defn quad (x) (dbl (dbl x)))
+(check "future moves the globals the function uses" (eq? (deref (future quad 4)) 16))
+(check "a function that uses the task can not be moved" (catch (future (fn () task))))
@@ -0,0 +1,10 @@
+; A module that throws is evaluated again by the next import, up to its end.
+(import "tests/check.scm")
+
+(define should-fail 'true)
+(check "the first import fails" (catch (import "tests/modules/fails-once.scm")))
+(check "names after the error are not defined" (catch after))
+
+(define should-fail nil)
+(import "tests/modules/fails-once.scm")
+(check "the second import defines every name" (eq? after 'defined))
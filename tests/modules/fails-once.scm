@@ -0,0 +1,3 @@
+(define before 'defined)
+(if should-fail (throw 'failed))
+(define after 'defined)
@@ -0,0 +1,10 @@
+; A task anywhere in the globals is not moved to the pool unless the function refers to it.
+(import "tests/check.scm")
+
+(define task (spawn (fn () 1)))
+(check "pmap leaves the task out" (eq? (pmap (fn (x) (* x 2)) (range 3)) '(2 4 6)))
+
+(defn fact (n)
+  (if (eq? n 0) 1 (* n (fact (- n 1)))))
+(check "pmap moves the globals the function uses" (eq? (pmap fact '(3 4 5)) '(6 24 120)))
+(check "a function that uses the task can not be moved" (catch (pmap (fn (x) task) '(1))))
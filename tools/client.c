@@ -0,0 +1,45 @@
+// Sends a script to a server started with `persimmon --serve SOCKET` and prints the response.
+//
+// Usage: persimmon-client SOCKET [SOURCE]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "server/client.h"
+#include "vm/reader/source.h"
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s SOCKET [SOURCE]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto const path = argc > 2 ? argv[2] : "<stdin>";
+    auto const file = argc > 2 ? fopen(argv[2], "rb") : stdin;
+    if (nullptr == file) {
+        fprintf(stderr, "Could not open \"%s\": %s\n", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    Source source;
+    errno_t error_code;
+    if (false == source_try_load(file, &source, &error_code)) {
+        fprintf(stderr, "Could not read \"%s\": %s\n", path, strerror(error_code));
+        return EXIT_FAILURE;
+    }
+
+    int fd;
+    auto const ok = client_try_connect(argv[1], &fd, &error_code)
+                    && client_try_eval(fd, source.data, source.size, stdout, &error_code);
+    if (false == ok) {
+        fprintf(stderr, "Could not evaluate \"%s\" on \"%s\": %s\n", path, argv[1], strerror(error_code));
+    }
+
+    source_free(&source);
+    if (stdin != file) {
+        fclose(file);
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,259 @@
+// Parses prelude sources and writes their top-level forms as statically initialized
+// objects, so that the interpreter can evaluate them without reading anything.
+//
+// Usage: persimmon-prelude-gen OUTPUT SOURCE...
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utility/guards.h"
+#include "utility/dynamic_array.h"
+#include "utility/slice.h"
+#include "object/allocator.h"
+#include "vm/reader/parser.h"
+#include "vm/reader/scanner.h"
+#include "vm/reader/source.h"
+#include "vm/reader/tokenizer.h"
+#include "vm/stack.h"
+#include "vm/tasks.h"
+
+typedef struct {
+    size_t *data;
+    size_t count;
+    size_t capacity;
+} Ids;
+
+[[noreturn]]
+static void fail(char const *what, char const *path, errno_t error_code) {
+    fprintf(stderr, "%s \"%s\": %s\n", what, path, strerror(error_code));
+    exit(EXIT_FAILURE);
+}
+
+[[noreturn]]
+static void fail_syntax(char const *path, SyntaxError error) {
+    fprintf(
+            stderr, "%s:%zu:%zu: %s\n",
+            path, error.pos.lineno, error.pos.col + 1, syntax_error_str(error.code)
+    );
+    exit(EXIT_FAILURE);
+}
+
+static void parse_file(char const *path, Scanner *s, Parser *p, Objects *forms) {
+    errno = 0;
+    auto const file = fopen(path, "rb");
+    if (nullptr == file) {
+        fail("Could not open", path, errno);
+    }
+
+    Source source;
+    errno_t error_code;
+    if (false == source_try_load(file, &source, &error_code)) {
+        fail("Could not read", path, error_code);
+    }
+    fclose(file);
+
+    scanner_reset(s);
+    parser_reset(p);
+
+    auto tokenizer = tokenizer_make(source.data, source.size);
+    while (true) {
+        SyntaxError syntax_error;
+        if (false == tokenizer_try_next(&tokenizer, s, &syntax_error)) {
+            fail_syntax(path, syntax_error);
+        }
+
+        auto const token = s->has_token ? s->token : (Token) {.type = TOKEN_EOF};
+
+        Parser_Error parser_error;
+        if (false == parser_try_accept(p, token, &parser_error)) {
+            if (PARSER_ALLOCATION_ERROR == parser_error.type) {
+                fail("Could not parse", path, ENOMEM);
+            }
+            fail_syntax(path, parser_error.as_syntax_error);
+        }
+
+        if (TOKEN_EOF == token.type) {
+            break;
+        }
+
+        if (p->has_expr && false == da_try_append(forms, p->expr)) {
+            fail("Could not parse", path, errno);
+        }
+    }
+
+    source_free(&source);
+}
+
+static void emit_chars(FILE *out, char const *chars) {
+    fputc('"', out);
+    for (auto it = (unsigned char const *) chars; '\0' != *it; it++) {
+        if ('"' == *it || '\\' == *it) {
+            fprintf(out, "\\%c", *it);
+        } else if (*it >= ' ' && *it <= '~') {
+            fputc(*it, out);
+        } else {
+            fprintf(out, "\\%03o", *it);
+        }
+    }
+    fputc('"', out);
+}
+
+static void emit_ref(FILE *out, size_t id) {
+    if (SIZE_MAX == id) {
+        fprintf(out, "&OBJECT_NIL_STORAGE");
+        return;
+    }
+
+    fprintf(out, "&prelude_%zu", id);
+}
+
+static size_t emit_cons(FILE *out, size_t first, size_t rest, size_t *next_id) {
+    auto const id = (*next_id)++;
+    fprintf(out, "static Object prelude_%zu = {.color = OBJECT_IMMORTAL, .type = TYPE_LIST, .as_list = {", id);
+    fprintf(out, ".first = ");
+    emit_ref(out, first);
+    fprintf(out, ", .rest = ");
+    emit_ref(out, rest);
+    fprintf(out, "}};\n");
+    return id;
+}
+
+// Emits `obj` after all of its children and returns its id; nil is `SIZE_MAX`.
+static size_t emit_object(FILE *out, Object *obj, size_t *next_id) { // NOLINT(*-no-recursion)
+    switch (obj->type) {
+        case TYPE_NIL: {
+            return SIZE_MAX;
+        }
+        case TYPE_INT: {
+            auto const id = (*next_id)++;
+            fprintf(out, "static Object prelude_%zu = {.color = OBJECT_IMMORTAL, .type = TYPE_INT, ", id);
+            if (INT64_MIN == obj->as_int) {
+                fprintf(out, ".as_int = INT64_MIN};\n");
+            } else {
+                fprintf(out, ".as_int = INT64_C(%" PRId64 ")};\n", obj->as_int);
+            }
+            return id;
+        }
+        case TYPE_STRING:
+        case TYPE_SYMBOL: {
+            auto const is_string = TYPE_STRING == obj->type;
+            auto const id = (*next_id)++;
+            fprintf(
+                    out, "static Object prelude_%zu = {.color = OBJECT_IMMORTAL, .type = %s, .%s = ",
+                    id, is_string ? "TYPE_STRING" : "TYPE_SYMBOL", is_string ? "as_string" : "as_symbol"
+            );
+            emit_chars(out, obj->as_string);
+            fprintf(out, "};\n");
+            return id;
+        }
+        case TYPE_LIST: {
+            auto elements = (Ids) {0};
+            for (auto it = obj; OBJECT_NIL != it; it = it->as_list.rest) {
+                if (false == da_try_append(&elements, emit_object(out, it->as_list.first, next_id))) {
+                    fail("Could not generate", "list", errno);
+                }
+            }
+
+            auto id = SIZE_MAX;
+            for (auto i = elements.count; i > 0; i--) {
+                id = emit_cons(out, elements.data[i - 1], id, next_id);
+            }
+            da_free(&elements);
+            return id;
+        }
+        case TYPE_DICT:
+        case TYPE_PRIMITIVE:
+        case TYPE_CLOSURE:
+        case TYPE_MACRO:
+        case TYPE_HANDLE: {
+            guard_unreachable();
+        }
+    }
+
+    guard_unreachable();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s OUTPUT SOURCE...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Nothing is ever collected: parsed forms stay alive until they are written out.
+    auto a = allocator_make((ObjectAllocator_Config) {
+            .hard_limit = SIZE_MAX,
+            .debug = {.gc_mode = ALLOCATOR_NEVER_GC}
+    });
+
+    Stack stack;
+    Scanner s;
+    Parser p;
+    errno_t error_code;
+    auto const ok = stack_try_init(&stack, (Stack_Config) {.size_bytes = 1024}, &error_code)
+                    && scanner_try_init(&s, (Scanner_Config) {.max_token_length = 64 * 1024}, &error_code)
+                    && parser_try_init(&p, &a, (Parser_Config) {.max_nesting_depth = 1024}, &error_code);
+    if (false == ok) {
+        fail("Could not initialize", "parser", error_code);
+    }
+
+    auto unused = OBJECT_NIL;
+    auto no_tasks = (Tasks) {0};
+    allocator_set_roots(&a, (ObjectAllocator_Roots) {
+            .stack = &stack,
+            .tasks = &no_tasks,
+            .parser_stack = &p.exprs_stack,
+            .parser_expr = &p.expr,
+            .globals = &unused,
+            .value = &unused,
+            .error = &unused,
+            .exprs = &unused,
+            .module_forms = &unused
+    });
+
+    auto forms = (Objects) {0};
+    for (int i = 2; i < argc; i++) {
+        parse_file(argv[i], &s, &p, &forms);
+    }
+
+    errno = 0;
+    auto const out = fopen(argv[1], "w");
+    if (nullptr == out) {
+        fail("Could not open", argv[1], errno);
+    }
+
+    fprintf(out, "// Generated by persimmon-prelude-gen, do not edit.\n\n");
+    fprintf(out, "#include <stdint.h>\n\n");
+    fprintf(out, "#include \"vm/prelude.h\"\n\n");
+
+    size_t next_id = 0;
+    auto form_ids = (Ids) {0};
+    slice_for_v(form, forms) {
+        if (false == da_try_append(&form_ids, emit_object(out, *form, &next_id))) {
+            fail("Could not generate", argv[1], errno);
+        }
+    }
+
+    auto list_id = SIZE_MAX;
+    for (auto i = form_ids.count; i > 0; i--) {
+        list_id = emit_cons(out, form_ids.data[i - 1], list_id, &next_id);
+    }
+
+    fprintf(out, "\nObject *const PRELUDE_FORMS = ");
+    emit_ref(out, list_id);
+    fprintf(out, ";\n");
+
+    if (0 != fclose(out)) {
+        fail("Could not write", argv[1], errno);
+    }
+
+    da_free(&form_ids);
+    da_free(&forms);
+    parser_free(&p);
+    scanner_free(&s);
+    stack_free(&stack);
+    allocator_free(&a);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,236 @@
+// Converts a trace dumped by `persimmon --trace DUMP` (see src/vm/trace.h) to the Chrome trace
+// event format, which `chrome://tracing` and Perfetto open: frames and primitive calls are
+// slices on the thread of their task, collections are slices on a thread of their own and
+// errors are instant events. Ends recorded after their beginnings were overwritten are dropped,
+// and slices still open at the end of the trace are closed there.
+//
+// Usage: persimmon-trace-json DUMP [OUTPUT]
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vm/trace.h"
+
+#define GC_TID 0
+#define TASKS (TRACE_NO_TASK + 1)
+
+typedef struct {
+    uint32_t count;
+    char **names;
+} Names;
+
+static char const *path;
+
+[[noreturn]]
+static void fail(char const *what) {
+    fprintf(stderr, "Could not read \"%s\": %s\n", path, what);
+    exit(EXIT_FAILURE);
+}
+
+static void read_exactly(FILE *file, void *data, size_t size) {
+    if (size > 0 && 1 != fread(data, size, 1, file)) {
+        fail(ferror(file) ? strerror(errno) : "unexpected end of file");
+    }
+}
+
+static Names read_names(FILE *file, uint32_t count) {
+    auto const names = (Names) {.count = count, .names = (char **) calloc(count, sizeof(char *))};
+    if (nullptr == names.names && count > 0) {
+        fail(strerror(errno));
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t length;
+        read_exactly(file, &length, sizeof(length));
+        names.names[i] = (char *) calloc(length + 1, 1);
+        if (nullptr == names.names[i]) {
+            fail(strerror(errno));
+        }
+        read_exactly(file, names.names[i], length);
+    }
+
+    return names;
+}
+
+static void free_names(Names names) {
+    for (uint32_t i = 0; i < names.count; i++) {
+        free(names.names[i]);
+    }
+    free(names.names);
+}
+
+static char const *name_of(Names names, uint32_t index) {
+    return index < names.count ? names.names[index] : "?";
+}
+
+// Names are frame types and primitive names: none needs escaping but `"` and `\`.
+static void write_string(FILE *output, char const *s) {
+    fputc('"', output);
+    for (auto it = s; '\0' != *it; it++) {
+        if ('"' == *it || '\\' == *it) {
+            fputc('\\', output);
+        }
+        fputc(*it, output);
+    }
+    fputc('"', output);
+}
+
+static void write_event(
+        FILE *output,
+        bool *is_first,
+        char const *phase,
+        char const *category,
+        char const *name,
+        size_t tid,
+        uint64_t time_ns,
+        char const *args
+) {
+    fprintf(output, "%s\n{\"ph\": \"%s\", \"cat\": \"%s\", \"name\": ", *is_first ? "" : ",", phase, category);
+    write_string(output, name);
+    fprintf(output, ", \"pid\": 1, \"tid\": %zu, \"ts\": %.3f", tid, (double) time_ns / 1e3);
+    if ('i' == phase[0]) {
+        fprintf(output, ", \"s\": \"t\"");
+    }
+    if (nullptr != args) {
+        fprintf(output, ", \"args\": %s", args);
+    }
+    fputc('}', output);
+    *is_first = false;
+}
+
+static void write_thread_name(FILE *output, bool *is_first, size_t tid) {
+    fprintf(output, "%s\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": %zu, ", *is_first ? "" : ",", tid);
+    if (GC_TID == tid) {
+        fprintf(output, "\"args\": {\"name\": \"gc\"}}");
+    } else if (1 == tid) {
+        fprintf(output, "\"args\": {\"name\": \"main\"}}");
+    } else {
+        fprintf(output, "\"args\": {\"name\": \"task %zu\"}}", tid - 1);
+    }
+    *is_first = false;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s DUMP [OUTPUT]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    path = argv[1];
+    auto const file = fopen(path, "rb");
+    if (nullptr == file) {
+        fail(strerror(errno));
+    }
+
+    auto const output = argc > 2 ? fopen(argv[2], "wb") : stdout;
+    if (nullptr == output) {
+        fprintf(stderr, "Could not open \"%s\": %s\n", argv[2], strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    char magic[sizeof(TRACE_MAGIC) - 1];
+    uint32_t header[4];
+    uint64_t count, overwritten;
+    read_exactly(file, magic, sizeof(magic));
+    read_exactly(file, header, sizeof(header));
+    read_exactly(file, &count, sizeof(count));
+    read_exactly(file, &overwritten, sizeof(overwritten));
+    if (0 != memcmp(magic, TRACE_MAGIC, sizeof(magic)) || sizeof(Trace_Record) != header[0]) {
+        fail("not a trace, or one written by a different build");
+    }
+
+    auto const frame_types = read_names(file, header[1]);
+    auto const primitives = read_names(file, header[2]);
+
+    // Slices open on each thread, and the threads already named.
+    auto const depths = (size_t *) calloc(TASKS, sizeof(size_t));
+    auto const is_named = (bool *) calloc(TASKS, sizeof(bool));
+    if (nullptr == depths || nullptr == is_named) {
+        fail(strerror(errno));
+    }
+
+    auto is_first = true;
+    uint64_t last_ns = 0;
+    fprintf(output, "{\"displayTimeUnit\": \"ns\", \"otherData\": {\"overwritten\": %llu}, \"traceEvents\": [",
+            (unsigned long long) overwritten);
+    for (uint64_t i = 0; i < count; i++) {
+        Trace_Record record;
+        read_exactly(file, &record, sizeof(record));
+        last_ns = record.time_ns;
+
+        auto const tid = TRACE_NO_TASK == record.task ? GC_TID : (size_t) record.task + 1;
+        auto const is_begin =
+                TRACE_FRAME_PUSH == record.kind
+                || TRACE_PRIMITIVE_BEGIN == record.kind
+                || TRACE_GC_BEGIN == record.kind;
+        auto const is_end =
+                TRACE_FRAME_POP == record.kind
+                || TRACE_PRIMITIVE_END == record.kind
+                || TRACE_GC_END == record.kind;
+        if (false == is_named[tid]) {
+            write_thread_name(output, &is_first, tid);
+            is_named[tid] = true;
+        }
+        if (is_begin) {
+            depths[tid]++;
+        }
+        if (is_end) {
+            if (0 == depths[tid]) {
+                continue;
+            }
+            depths[tid]--;
+        }
+
+        switch (record.kind) {
+            case TRACE_FRAME_PUSH:
+            case TRACE_FRAME_POP: {
+                auto const phase = TRACE_FRAME_PUSH == record.kind ? "B" : "E";
+                write_event(output, &is_first, phase, "frame", name_of(frame_types, record.arg), tid, record.time_ns, nullptr);
+                break;
+            }
+            case TRACE_PRIMITIVE_BEGIN:
+            case TRACE_PRIMITIVE_END: {
+                auto const phase = TRACE_PRIMITIVE_BEGIN == record.kind ? "B" : "E";
+                write_event(output, &is_first, phase, "primitive", name_of(primitives, record.arg), tid, record.time_ns, nullptr);
+                break;
+            }
+            case TRACE_GC_BEGIN:
+            case TRACE_GC_END: {
+                char args[32];
+                snprintf(args, sizeof(args), "{\"freed\": %" PRIu32 "}", record.arg);
+                auto const is_begin_gc = TRACE_GC_BEGIN == record.kind;
+                write_event(output, &is_first, is_begin_gc ? "B" : "E", "gc", "gc", tid, record.time_ns, is_begin_gc ? nullptr : args);
+                break;
+            }
+            case TRACE_ERROR: {
+                write_event(output, &is_first, "i", "error", "error", tid, record.time_ns, nullptr);
+                break;
+            }
+            default: {
+                fail("unknown record");
+            }
+        }
+    }
+
+    for (size_t tid = 0; tid < TASKS; tid++) {
+        for (; depths[tid] > 0; depths[tid]--) {
+            write_event(output, &is_first, "E", "frame", "", tid, last_ns, nullptr);
+        }
+    }
+    fprintf(output, "\n]}\n");
+
+    free(is_named);
+    free(depths);
+    free_names(frame_types);
+    free_names(primitives);
+    fclose(file);
+    if (0 != fclose(output)) {
+        fprintf(stderr, "Could not write the trace: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}